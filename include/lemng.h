@@ -39,7 +39,11 @@ ECHMET_ST_ENUM(RetCode) {
 						     the numerical sovler will be able to solve the system */
 	E_PARTIAL_EIGENZONES = 0x16,		/*!< Some eigenzones in the system could not have been fully resolved */
 	E_INVALID_COMPOSITION_PARAMS = 0x17,	/*!< Parameters of the same constituent in BGE and sample composition differ */
-	E_INVALID_COMPOSITION_MISSING = 0x18	/*!< BGE composition contains a constituent that is not present in sample */
+	E_INVALID_COMPOSITION_MISSING = 0x18,	/*!< BGE composition contains a constituent that is not present in sample */
+	E_RESULTS_EXPIRED = 0x19,		/*!< Lazily evaluated results cannot be calculated because the system
+						     has been evaluated again since the results were created */
+	E_IO_ERROR = 0x1A,			/*!< File cannot be created, opened or mapped into memory */
+	E_INVALID_FILE = 0x1B			/*!< File is truncated or is not a valid file of the expected kind */
 	ENUM_FORCE_INT32_SIZE(LEMNGRetCode)
 };
 
@@ -60,6 +64,44 @@ ECHMET_ST_ENUM(EFGResponseType) {
 	ENUM_FORCE_INT32_SIZE(EFGType)
 };
 
+/*!
+ * Parts of the results that can be requested from \p CZESystem::evaluateLazy().
+ * Values may be combined with a bitwise OR.
+ */
+ECHMET_ST_ENUM(EvaluationParts) {
+	EVAL_BGE = 0x1,			/*!< Properties of the plain background electrolyte */
+	EVAL_EIGENMOBILITIES = 0x2,	/*!< Mobilities of the eigenzones */
+	EVAL_ZONE_COMPOSITIONS = 0x4,	/*!< Analytical concentrations of constituents in the eigenzones */
+	EVAL_ZONE_PROPERTIES = 0x8,	/*!< Equilibrium composition and properties of the solution in the eigenzones */
+	EVAL_DISPERSION = 0x10,		/*!< Diffusive and electromigration dispersion parameters of the eigenzones */
+	EVAL_ALL = 0x1F,		/*!< Everything that \p CZESystem::evaluate() calculates */
+	EVAL_SENSITIVITIES = 0x20	/*!< Derivatives of the mobilities of the eigenzones by the concentrations of the BGE constituents.
+					     Not calculated by \p CZESystem::evaluate(). Dependence of the ionic mobilities
+					     on the ionic strength is neglected except for its effect on the conductivity. */
+	ENUM_FORCE_INT32_SIZE(LEMNGEvaluationParts)
+};
+
+/*!
+ * Compositions whose concentration of the swept constituent is varied by \p CZESystem::sweep().
+ * Values may be combined with a bitwise OR.
+ */
+ECHMET_ST_ENUM(SweepTarget) {
+	SWEEP_BGE = 0x1,	/*!< Concentration in the background electrolyte */
+	SWEEP_SAMPLE = 0x2,	/*!< Concentration in the sample zone */
+	SWEEP_BOTH = 0x3	/*!< Concentration in both the background electrolyte and the sample zone */
+	ENUM_FORCE_INT32_SIZE(LEMNGSweepTarget)
+};
+
+/*!
+ * Separation criteria maximized by \p CZESystem::optimizeBGE().
+ * Values may be combined with a bitwise OR.
+ */
+ECHMET_ST_ENUM(OptimizationObjective) {
+	OPT_ANALYTE_SEPARATION = 0x1,		/*!< Separation of the eigenzones of the analytes from each other */
+	OPT_SYSTEM_ZONE_SEPARATION = 0x2	/*!< Separation of the eigenzones of the analytes from the system zones */
+	ENUM_FORCE_INT32_SIZE(LEMNGOptimizationObjective)
+};
+
 /*!
  * Description of a tracepoint.
  */
@@ -150,6 +192,12 @@ public:
 };
 IS_POD(RSolutionProperties)
 
+/*!
+ * Map of derivatives of mobility of an eigenzone by the analytical concentrations
+ * of the BGE constituents, keyed by the names of the constituents.
+ */
+typedef SKMap<double> RMobilitySensitivitiesMap;
+
 /*!
  * Description of eigenzone.
  */
@@ -157,13 +205,18 @@ class REigenzone {
 public:
 	EigenzoneType ztype;			/*!< Denotes whether a zone belongs to an analyte or not (a system zone). */
 	double mobility;			/*!< Electroforetic mobility of the zone */
-	double a2t;				/*!< Time-independent diffusive parameter of the zone. */
-	double uEMD;				/*!< Measure of electromigration of dispersion of the zone in mobility units. */
+	double a2t;				/*!< Time-independent diffusive parameter of the zone.
+						     NaN if the nonlinear stage of the model has not been evaluated. */
+	double uEMD;				/*!< Measure of electromigration of dispersion of the zone in mobility units.
+						     NaN if the nonlinear stage of the model has not been evaluated. */
 	RSolutionProperties solutionProperties;	/*!< Properties of the solution comprising the zone */
 	bool tainted;				/*!< Set to true if the concentrations of the constituents
 						     that make up the zones had to be clamped to valid values. */
 	bool valid;				/*!< Set to false if the eigenzone could not have been fully resolved
 						     by the solver. */
+	RMobilitySensitivitiesMap *mobilitySensitivities;	/*!< Derivatives of \p mobility by the analytical concentrations of the BGE constituents
+								     in <tt>m.m/V/s . 1e-9</tt> per <tt>mmol/dm3</tt>.
+								     \p nullptr unless \p EvaluationParts::EVAL_SENSITIVITIES has been evaluated. */
 };
 IS_POD(REigenzone)
 typedef Vec<REigenzone> REigenzoneVec;
@@ -192,13 +245,150 @@ typedef Vec<REigenzoneEnvelope> REigenzoneEnvelopeVec;
 class Results {
 public:
 	RSolutionProperties BGEProperties;			/*!< Properties of the plain background electrolyte. */
-	REigenzoneVec *eigenzones;				/*!< Description of all eigenzones present in the system. */
+	REigenzoneVec *eigenzones;				/*!< Description of all eigenzones present in the system.
+								     When the BGE composition of a \p CZESystem changes, the eigenzones
+								     are ordered so that each zone stays at the index of the zone
+								     it corresponds to in the previous evaluation. */
 	RDissociatedConstituentVec *analytesDissociation;	/*!< Description of dissociation degrees of all analytes. */
 	bool isBGEValid;					/*!< Set to true if the BGE composition was successfully solved. */
 };
 IS_POD(Results)
 typedef MutSKMap<double> InAnalyticalConcentrationsMap;
 
+/*!
+ * One point of a parametric sweep.
+ */
+class RSweepPoint {
+public:
+	double concentration;	/*!< Concentration of the swept constituent at this point */
+	RetCode status;		/*!< Outcome of the evaluation of this point */
+	Results results;	/*!< Results of the evaluation. Valid only if \p results.isBGEValid is <tt>true</tt>. */
+};
+IS_POD(RSweepPoint)
+typedef Vec<RSweepPoint> RSweepPointVec;
+
+/*!
+ * Usage statistics of the process-wide cache of prepared compositions.
+ */
+class RCZESystemCacheStatistics {
+public:
+	size_t entries;		/*!< Number of compositions currently held by the cache */
+	size_t hits;		/*!< Number of systems created from a cached composition */
+	size_t misses;		/*!< Number of systems whose composition had to be prepared */
+};
+IS_POD(RCZESystemCacheStatistics)
+
+/*!
+ * One axis of a grid scan.
+ */
+class GridScanAxis {
+public:
+	const char *constituent;	/*!< Name of the constituent whose concentration is varied along the axis */
+	int32_t target;			/*!< Combination of \p SweepTarget values. Selects the compositions the axis applies to. */
+	const RealVec *values;		/*!< Concentrations of the constituent along the axis in <tt>mmol/dm3</tt> */
+};
+IS_POD(GridScanAxis)
+
+/*!
+ * Columnar results of a grid scan.
+ *
+ * Points are ordered row-major by the axes of the scan, the last axis varies the fastest.
+ * Per-zone columns hold \p zonesPerPoint consecutive values for each point. Eigenzones
+ * are kept in the same order in all points of the scan.
+ */
+class RGridScanBuffer {
+public:
+	size_t numPoints;	/*!< Number of points of the scan */
+	size_t zonesPerPoint;	/*!< Number of eigenzones of each point */
+	int32_t *status;	/*!< <tt>RetCode</tt> of the evaluation of each point. Per-zone values of failed points are undefined. */
+	double *mobilities;	/*!< Mobilities of the eigenzones */
+	double *uEMDs;		/*!< Electromigration dispersion of the eigenzones. NaN if the nonlinear stage has not been evaluated. */
+	double *a2ts;		/*!< Diffusive parameters of the eigenzones. NaN if the nonlinear stage has not been evaluated. */
+	int32_t *ztypes;	/*!< <tt>EigenzoneType</tt> of the eigenzones */
+};
+IS_POD(RGridScanBuffer)
+
+/*!
+ * Header of a grid scan file.
+ *
+ * Grid scan file stores the results of a grid scan in a form that can be mapped into memory
+ * and used without parsing. All values are stored in the byte order of the machine that
+ * wrote the file. Offsets are counted in bytes from the beginning of the file and all
+ * arrays are aligned to \p GRID_SCAN_FILE_ALIGNMENT bytes. The file consists of this header
+ * followed by
+ *  - array of \p numAxes \p GridScanFileAxis records,
+ *  - array of \p numConstituents \p GridScanFileConstituent records,
+ *  - name table of zero-terminated names of the axes and constituents,
+ *  - values of the axes,
+ *  - columns of the results with the same layout as \p RGridScanBuffer.
+ */
+class GridScanFileHeader {
+public:
+	char magic[8];			/*!< Set to \p GRID_SCAN_FILE_MAGIC */
+	uint32_t version;		/*!< Version of the format, set to \p GRID_SCAN_FILE_VERSION */
+	uint32_t byteOrder;		/*!< Set to \p GRID_SCAN_FILE_BYTE_ORDER. Any other value indicates a file written on a machine with different byte order. */
+	uint64_t fileSize;		/*!< Total size of the file */
+	uint64_t numPoints;		/*!< Number of points of the scan */
+	uint64_t zonesPerPoint;		/*!< Number of eigenzones of each point */
+	uint32_t numAxes;		/*!< Number of axes of the grid */
+	uint32_t numConstituents;	/*!< Number of constituents of the system */
+	int32_t corrections;		/*!< Nonideality corrections used by the scan */
+	int32_t hasDispersion;		/*!< Nonzero if the dispersion parameters have been calculated */
+	uint64_t axesOffset;		/*!< Offset of the array of \p GridScanFileAxis records */
+	uint64_t constituentsOffset;	/*!< Offset of the array of \p GridScanFileConstituent records */
+	uint64_t namesOffset;		/*!< Offset of the name table */
+	uint64_t namesSize;		/*!< Size of the name table including the terminating zeros */
+	uint64_t statusOffset;		/*!< Offset of the <tt>int32_t</tt> status column */
+	uint64_t mobilitiesOffset;	/*!< Offset of the <tt>double</tt> mobilities column */
+	uint64_t uEMDsOffset;		/*!< Offset of the <tt>double</tt> uEMD column */
+	uint64_t a2tsOffset;		/*!< Offset of the <tt>double</tt> a2t column */
+	uint64_t ztypesOffset;		/*!< Offset of the <tt>int32_t</tt> eigenzone types column */
+};
+IS_POD(GridScanFileHeader)
+
+static const char GRID_SCAN_FILE_MAGIC[8] = { 'L', 'E', 'M', 'N', 'G', 'G', 'S', '\0' };	/*!< Identifies a grid scan file */
+static const uint32_t GRID_SCAN_FILE_VERSION = 1;		/*!< Current version of the grid scan file format */
+static const uint32_t GRID_SCAN_FILE_BYTE_ORDER = 0x01020304;	/*!< Byte order mark of the grid scan file */
+static const uint64_t GRID_SCAN_FILE_ALIGNMENT = 64;		/*!< Alignment of the arrays in the grid scan file */
+
+/*!
+ * Axis of the grid stored in a grid scan file.
+ */
+class GridScanFileAxis {
+public:
+	uint64_t nameOffset;	/*!< Offset of the name of the varied constituent in the name table */
+	uint64_t valuesOffset;	/*!< Offset of the <tt>double</tt> concentrations along the axis */
+	uint64_t numValues;	/*!< Number of points along the axis */
+	int32_t target;		/*!< Combination of \p SweepTarget values */
+	int32_t reserved;
+};
+IS_POD(GridScanFileAxis)
+
+/*!
+ * Constituent of the system stored in a grid scan file.
+ */
+class GridScanFileConstituent {
+public:
+	uint64_t nameOffset;	/*!< Offset of the name of the constituent in the name table */
+	double cBGE;		/*!< Concentration in the background electrolyte the scan started from. NaN if the constituent is not present in the BGE. */
+	double cSample;		/*!< Concentration in the sample zone the scan started from */
+};
+IS_POD(GridScanFileConstituent)
+
+/*!
+ * Grid scan file mapped into memory.
+ */
+class RGridScanFile {
+public:
+	const GridScanFileHeader *header;		/*!< Header of the file */
+	const GridScanFileAxis *axes;			/*!< Axes of the grid */
+	const GridScanFileConstituent *constituents;	/*!< Constituents of the system */
+	const char *names;				/*!< Name table */
+	RGridScanBuffer results;			/*!< Columns of the results. Pages of the file are mapped copy-on-write,
+							     modifications of the columns are not written back to the file. */
+};
+IS_POD(RGridScanFile)
+
 /*!
  * Time-value data pair.
  * Vector of these composes the expected detector trace.
@@ -211,6 +401,111 @@ public:
 IS_POD(EFGPair)
 typedef Vec<EFGPair> EFGPairVec;
 
+/*!
+ * Results of a lazy evaluation of the system.
+ *
+ * Each part of the results is calculated on first access and kept for subsequent
+ * accesses. Parts that are not needed are never calculated.
+ * All accessors fill one shared \p Results object, fields that belong to parts
+ * that have not been calculated yet are zeroed, except for \p a2t and \p uEMD
+ * which are NaN until calculated.
+ *
+ * Parts that have not been calculated yet can be calculated only until
+ * the system that created the object is evaluated again. The object must be
+ * destroyed before the system is released.
+ */
+class LazyResults {
+public:
+	/*!
+	 * Returns properties of the plain background electrolyte.
+	 *
+	 * @param[out] props Properties of the background electrolyte.
+	 *
+	 * @retval RetCode::OK Success.
+	 * @retval RetCode::E_RESULTS_EXPIRED The properties have not been calculated and the system has been evaluated again.
+	 * @retval Anything that can be returned by \p CZESystem::evaluate().
+	 */
+	virtual RetCode ECHMET_CC BGEProperties(const RSolutionProperties *&props) ECHMET_NOEXCEPT = 0;
+
+	/*!
+	 * Releases the object.
+	 */
+	virtual void ECHMET_CC destroy() const ECHMET_NOEXCEPT = 0;
+
+	/*!
+	 * Returns eigenzones with \p a2t and \p uEMD parameters calculated.
+	 *
+	 * @param[out] eigenzones Eigenzones of the system.
+	 *
+	 * @retval RetCode::OK Success.
+	 * @retval RetCode::E_RESULTS_EXPIRED The parameters have not been calculated and the system has been evaluated again.
+	 * @retval Anything that can be returned by \p CZESystem::evaluate().
+	 */
+	virtual RetCode ECHMET_CC dispersion(const REigenzoneVec *&eigenzones) ECHMET_NOEXCEPT = 0;
+
+	/*!
+	 * Returns eigenzones with mobilities calculated.
+	 *
+	 * @param[out] eigenzones Eigenzones of the system.
+	 *
+	 * @retval RetCode::OK Success.
+	 * @retval RetCode::E_RESULTS_EXPIRED The mobilities have not been calculated and the system has been evaluated again.
+	 * @retval Anything that can be returned by \p CZESystem::evaluate().
+	 */
+	virtual RetCode ECHMET_CC eigenmobilities(const REigenzoneVec *&eigenzones) ECHMET_NOEXCEPT = 0;
+
+	/*!
+	 * Calculates all remaining parts and returns the complete results.
+	 * The results are owned by this object and must not be released by \p releaseResults().
+	 *
+	 * @param[out] results Complete results.
+	 *
+	 * @retval RetCode::OK Success.
+	 * @retval RetCode::E_RESULTS_EXPIRED Some parts have not been calculated and the system has been evaluated again.
+	 * @retval Anything that can be returned by \p CZESystem::evaluate().
+	 */
+	virtual RetCode ECHMET_CC results(const Results *&results) ECHMET_NOEXCEPT = 0;
+
+	/*!
+	 * Returns eigenzones with mobilities and their derivatives by the concentrations
+	 * of the BGE constituents calculated.
+	 *
+	 * @param[out] eigenzones Eigenzones of the system.
+	 *
+	 * @retval RetCode::OK Success.
+	 * @retval RetCode::E_RESULTS_EXPIRED The derivatives have not been calculated and the system has been evaluated again.
+	 * @retval Anything that can be returned by \p CZESystem::evaluate().
+	 */
+	virtual RetCode ECHMET_CC sensitivities(const REigenzoneVec *&eigenzones) ECHMET_NOEXCEPT = 0;
+
+	/*!
+	 * Returns eigenzones with mobilities, types and analytical concentrations
+	 * of constituents calculated.
+	 *
+	 * @param[out] eigenzones Eigenzones of the system.
+	 *
+	 * @retval RetCode::OK Success.
+	 * @retval RetCode::E_RESULTS_EXPIRED The compositions have not been calculated and the system has been evaluated again.
+	 * @retval Anything that can be returned by \p CZESystem::evaluate().
+	 */
+	virtual RetCode ECHMET_CC zoneCompositions(const REigenzoneVec *&eigenzones) ECHMET_NOEXCEPT = 0;
+
+	/*!
+	 * Returns eigenzones with fully resolved solution properties.
+	 *
+	 * @param[out] eigenzones Eigenzones of the system.
+	 *
+	 * @retval RetCode::OK Success.
+	 * @retval RetCode::E_PARTIAL_EIGENZONES Some eigenzones could not have been fully resolved.
+	 * @retval RetCode::E_RESULTS_EXPIRED The properties have not been calculated and the system has been evaluated again.
+	 * @retval Anything that can be returned by \p CZESystem::evaluate().
+	 */
+	virtual RetCode ECHMET_CC zoneProperties(const REigenzoneVec *&eigenzones) ECHMET_NOEXCEPT = 0;
+
+protected:
+	virtual ~LazyResults() ECHMET_NOEXCEPT = 0;
+};
+
 /*!
  * Object representing the CZE system to be solved.
  */
@@ -260,6 +555,179 @@ public:
 	 */
 	virtual RetCode ECHMET_CC makeAnalyticalConcentrationsMaps(InAnalyticalConcentrationsMap *&acMapBGE, InAnalyticalConcentrationsMap *&acMapFull) const ECHMET_NOEXCEPT = 0;
 
+	/*!
+	 * Prepares lazily evaluated results of the system.
+	 * Only the parts given by \p parts are calculated immediately, the
+	 * remaining parts are calculated when they are accessed through \p LazyResults.
+	 *
+	 * @param[in] acBGE Analytical concentrations of constituents in plain background electrolyte.
+	 * @param[in] acFull Analytical concentrations of constituents in the sample zone.
+	 * @param[in] corrections Nonideality corrections to apply.
+	 * @param[in] parts Combination of \p EvaluationParts values to calculate immediately.
+	 * @param[out] results Lazily evaluated results. Must be released with \p LazyResults::destroy().
+	 *
+	 * @retval RetCode::OK Success.
+	 * @retval RetCode::E_PARTIAL_EIGENZONES Some eigenzones could not have been fully resolved.
+	 *                                       \p results are set.
+	 * @retval Anything that can be returned by \p evaluate(). \p results are not set.
+	 */
+	virtual RetCode ECHMET_CC evaluateLazy(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acFull,
+					       const NonidealityCorrections corrections, const int32_t parts, LazyResults *&results) ECHMET_NOEXCEPT = 0;
+
+	/*!
+	 * Solves the system using only the linear model.
+	 * This is considerably faster than \p evaluate() because the nonlinear stage of the model
+	 * is not evaluated. \p a2t and \p uEMD parameters of the eigenzones are set to NaN.
+	 * Such results cannot be used to plot electrophoregrams.
+	 *
+	 * @param[in] acBGE Analytical concentrations of constituents in plain background electrolyte.
+	 * @param[in] acFull Analytical concentrations of constituents in the sample zone.
+	 * @param[in] corrections Nonideality corrections to apply.
+	 * @param[out] results Results will be stored here if the calculation succeeds.
+	 *
+	 * @retval Anything that can be returned by \p evaluate().
+	 */
+	virtual RetCode ECHMET_CC evaluateLinear(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acFull,
+						 const NonidealityCorrections corrections, Results &results) ECHMET_NOEXCEPT = 0;
+
+	/*!
+	 * Evaluates the system along a path of concentrations of one constituent.
+	 * Concentrations of all other constituents are taken from \p acBGE and \p acFull.
+	 *
+	 * Points are evaluated in the given order and the equilibrium solver of each point
+	 * starts from the solution of the previous point. Path should therefore be ordered
+	 * so that the adjacent points are close to each other. If a point cannot be solved,
+	 * the step from the last solved point is subdivided and the point is approached
+	 * through intermediate concentrations which are not reported. Eigenzones of the first
+	 * solved point are ordered independently of the previous evaluations of the system,
+	 * eigenzones of every other point follow the order of the previous solved point. An eigenzone
+	 * thus keeps its index along the path even where its mobility crosses the mobility of another zone.
+	 * If the eigenmobilities of two zones cross or come close to each other on the step from the previous
+	 * point, or if the eigenvectors turn too much on it, the point is approached again in subdivided steps
+	 * whose eigenzones follow each other.
+	 *
+	 * Outcome of each point is reported in its \p status, a failure of a point does not stop the sweep.
+	 *
+	 * @param[in] acBGE Analytical concentrations of constituents in plain background electrolyte.
+	 * @param[in] acFull Analytical concentrations of constituents in the sample zone.
+	 * @param[in] constituent Name of the swept constituent.
+	 * @param[in] target Combination of \p SweepTarget values. Selects the compositions the path applies to.
+	 * @param[in] path Concentrations of the swept constituent in <tt>mmol/dm3</tt>.
+	 * @param[in] corrections Nonideality corrections to apply.
+	 * @param[in] parts Combination of \p EvaluationParts values to calculate for each point. Must include \p EVAL_BGE.
+	 * @param[out] points Evaluated points in the order of \p path. Must be released with \p releaseSweepPoints().
+	 *
+	 * @retval RetCode::OK All points have been evaluated, see \p status of the points for their outcome.
+	 * @retval RetCode::E_NO_MEMORY Insufficient memory to perform the sweep.
+	 * @retval RetCode::E_INVALID_ARGUMENT Invalid argument was passed to the function, \p parts do not include
+	 *                                     \p EVAL_BGE or the swept constituent is not present in the targeted composition.
+	 */
+	virtual RetCode ECHMET_CC sweep(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acFull,
+					const char *constituent, const int32_t target, const RealVec *path,
+					const NonidealityCorrections corrections, const int32_t parts, RSweepPointVec *&points) ECHMET_NOEXCEPT = 0;
+
+	/*!
+	 * Searches for the concentrations of the BGE constituents that maximize the separation of the eigenzones.
+	 * Separation is measured as the smallest difference between the mobilities of the pairs of eigenzones
+	 * selected by \p objective. Only the constituents that have a bound in both \p lowerBounds and \p upperBounds
+	 * with the upper bound greater than the lower one are optimized, lower bounds are raised to \p minimumSafeConcentration().
+	 *
+	 * The search is a projected gradient ascent driven by the derivatives of the eigenmobilities by the concentrations
+	 * of the BGE constituents. Candidate steps of each iteration are evaluated in parallel and ranked by their eigenmobilities
+	 * alone, the derivatives are calculated only at the accepted candidate from the solution that has ranked it.
+	 * Objective values are not cached across iterations as the candidates practically never repeat.
+	 * The search converges to a local optimum. Composition of the sample zone is not altered because it has no effect
+	 * on the mobilities of the eigenzones.
+	 *
+	 * @param[in] acBGE Analytical concentrations of constituents in plain background electrolyte. The search starts from this composition.
+	 * @param[in] acFull Analytical concentrations of constituents in the sample zone.
+	 * @param[in] lowerBounds Lower bounds of the concentrations of the optimized constituents in <tt>mmol/dm3</tt>.
+	 * @param[in] upperBounds Upper bounds of the concentrations of the optimized constituents in <tt>mmol/dm3</tt>.
+	 * @param[in] objective Combination of \p OptimizationObjective values.
+	 * @param[in] corrections Nonideality corrections to apply.
+	 * @param[in] maxIterations Maximum number of iterations of the search.
+	 * @param[in,out] acBGEOptimum Map that receives the analytical concentrations of all constituents of the optimal background electrolyte.
+	 * @param[out] objectiveValue Smallest difference of mobilities at the optimum in <tt>m.m/V/s . 1e-9</tt>.
+	 *
+	 * @retval RetCode::OK Success.
+	 * @retval RetCode::E_NO_MEMORY Insufficient memory to perform the search.
+	 * @retval RetCode::E_INVALID_ARGUMENT Invalid argument was passed to the function, no constituent is to be optimized
+	 *                                     or the system has no pair of eigenzones selected by \p objective.
+	 * @retval Anything that can be returned by \p evaluate() if the starting composition cannot be evaluated.
+	 */
+	virtual RetCode ECHMET_CC optimizeBGE(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acFull,
+					      const InAnalyticalConcentrationsMap *lowerBounds, const InAnalyticalConcentrationsMap *upperBounds,
+					      const int32_t objective, const NonidealityCorrections corrections, const int32_t maxIterations,
+					      InAnalyticalConcentrationsMap *acBGEOptimum, double &objectiveValue) ECHMET_NOEXCEPT = 0;
+
+	/*!
+	 * Allocates a buffer large enough to hold the results of a grid scan over the given axes.
+	 * The buffer may be reused by any number of scans over grids of the same size.
+	 *
+	 * @param[in] axes Axes of the grid.
+	 * @param[in] numAxes Number of axes of the grid.
+	 * @param[out] buffer Allocated buffer. Must be released with \p releaseGridScanBuffer().
+	 *
+	 * @retval RetCode::OK Success.
+	 * @retval RetCode::E_NO_MEMORY Insufficient memory to allocate the buffer.
+	 * @retval RetCode::E_INVALID_ARGUMENT Invalid argument was passed to the function.
+	 */
+	virtual RetCode ECHMET_CC makeGridScanBuffer(const GridScanAxis *axes, const int32_t numAxes, RGridScanBuffer *&buffer) const ECHMET_NOEXCEPT = 0;
+
+	/*!
+	 * Evaluates eigenzones of the system at every point of a grid of concentrations.
+	 * Concentrations of the constituents that are not varied by any axis are taken from \p acBGE and \p acFull.
+	 *
+	 * Points are distributed among worker threads in contiguous blocks. Each worker keeps its own
+	 * evaluation context and visits the points of its block in serpentine order so that the adjacent
+	 * points differ in only one concentration and the equilibrium solver can start from the solution
+	 * of the previous point. Only the eigenzone mobilities, types and optionally dispersion parameters
+	 * are calculated and written directly into \p buffer. Eigenzones of all points follow the order
+	 * of the first point of the grid that can be solved, the order thus depends neither on the number
+	 * of workers nor on the previous evaluations of the system. Points far from that point are matched
+	 * against it directly, zones whose mobilities cross somewhere in between may therefore swap their
+	 * indices. Use \p sweep() to track the zones along a path through such crossings.
+	 *
+	 * Outcome of each point is reported in \p buffer->status, a failure of a point does not stop the scan.
+	 *
+	 * @param[in] acBGE Analytical concentrations of constituents in plain background electrolyte.
+	 * @param[in] acFull Analytical concentrations of constituents in the sample zone.
+	 * @param[in] axes Axes of the grid. A constituent may be varied by one axis only.
+	 * @param[in] numAxes Number of axes of the grid.
+	 * @param[in] corrections Nonideality corrections to apply.
+	 * @param[in] calcDispersion Evaluate the nonlinear stage of the model to get \p uEMD and \p a2t parameters of the eigenzones.
+	 * @param[in,out] buffer Buffer to store the results in. Its dimensions must match the grid and the system.
+	 *
+	 * @retval RetCode::OK All points have been evaluated, see \p buffer->status for their outcome.
+	 * @retval RetCode::E_NO_MEMORY Insufficient memory to perform the scan.
+	 * @retval RetCode::E_INVALID_ARGUMENT Invalid argument was passed to the function, a varied constituent is not present
+	 *                                     in the targeted composition or the dimensions of the buffer do not match.
+	 */
+	virtual RetCode ECHMET_CC gridScan(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acFull,
+					   const GridScanAxis *axes, const int32_t numAxes, const NonidealityCorrections corrections,
+					   const bool calcDispersion, RGridScanBuffer *buffer) ECHMET_NOEXCEPT = 0;
+
+	/*!
+	 * Performs a grid scan and writes the results directly into a grid scan file.
+	 * The file is mapped into memory and the scan fills its columns in place, see \p gridScan()
+	 * for details of the scan and \p GridScanFileHeader for the layout of the file.
+	 *
+	 * @param[in] acBGE Analytical concentrations of constituents in plain background electrolyte.
+	 * @param[in] acFull Analytical concentrations of constituents in the sample zone.
+	 * @param[in] axes Axes of the grid. A constituent may be varied by one axis only.
+	 * @param[in] numAxes Number of axes of the grid.
+	 * @param[in] corrections Nonideality corrections to apply.
+	 * @param[in] calcDispersion Evaluate the nonlinear stage of the model to get \p uEMD and \p a2t parameters of the eigenzones.
+	 * @param[in] path Path to the file. Existing file is overwritten.
+	 *
+	 * @retval RetCode::OK All points have been evaluated and written to the file.
+	 * @retval RetCode::E_IO_ERROR The file cannot be created or mapped into memory.
+	 * @retval Anything that can be returned by \p gridScan(). No file is left behind in such a case.
+	 */
+	virtual RetCode ECHMET_CC gridScanToFile(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acFull,
+						 const GridScanAxis *axes, const int32_t numAxes, const NonidealityCorrections corrections,
+						 const bool calcDispersion, const char *path) ECHMET_NOEXCEPT = 0;
+
 protected:
 	virtual ~CZESystem() ECHMET_NOEXCEPT = 0;
 };
@@ -287,6 +755,124 @@ ECHMET_API const char * ECHMET_CC LEMNGerrorToString(const RetCode tRet) ECHMET_
 ECHMET_API RetCode ECHMET_CC makeCZESystem(SysComp::InConstituentVec *BGE, SysComp::InConstituentVec *sample,
 					   CZESystem *&czeSystem) ECHMET_NOEXCEPT;
 
+/*!
+ * Reads a pair of compositions stored by \p saveSystemDefinition().
+ * The file is mapped into memory and parsed in a single pass.
+ * Constituents are returned in the canonical order which may differ
+ * from the order in which they were saved.
+ *
+ * @param[in] path Path to the file.
+ * @param[out] BGE Composition of the background electrolyte. Must be released with <tt>SysComp::releaseInputData()</tt>.
+ * @param[out] sample Composition of the sample zone. Must be released with <tt>SysComp::releaseInputData()</tt>.
+ *
+ * @retval RetCode::OK Success.
+ * @retval RetCode::E_NO_MEMORY Insufficient memory.
+ * @retval RetCode::E_INVALID_ARGUMENT Invalid argument was passed to the function.
+ * @retval RetCode::E_IO_ERROR The file cannot be opened or mapped into memory.
+ * @retval RetCode::E_INVALID_FILE The file is not a system definition file, has an unsupported version,
+ *                                 was written on a machine with different byte order, is damaged
+ *                                 or holds a snapshot of the cache of prepared compositions instead of a single pair.
+ */
+ECHMET_API RetCode ECHMET_CC loadSystemDefinition(const char *path, SysComp::InConstituentVec *&BGE, SysComp::InConstituentVec *&sample) ECHMET_NOEXCEPT;
+
+/*!
+ * Stores a pair of compositions in a compact binary file that can be read back
+ * by \p loadSystemDefinition() without any further validation.
+ * The compositions are validated in the same way as by \p makeCZESystem() before they are stored.
+ * Unlike \p makeCZESystem() the validation does not add them to the cache of prepared compositions.
+ *
+ * @param[in] path Path to the file. Existing file is overwritten.
+ * @param[in] BGE Vector of constituents composing the background electrolyte.
+ * @param[in] sample Vector of constituents composing the sample zone.
+ *
+ * @retval RetCode::OK Success.
+ * @retval RetCode::E_INVALID_ARGUMENT Invalid argument was passed to the function.
+ * @retval RetCode::E_IO_ERROR The file cannot be written.
+ * @retval Anything that can be returned by \p makeCZESystem().
+ */
+ECHMET_API RetCode ECHMET_CC saveSystemDefinition(const char *path, SysComp::InConstituentVec *BGE, SysComp::InConstituentVec *sample) ECHMET_NOEXCEPT;
+
+/*!
+ * Sets the maximum number of prepared compositions kept by the process-wide cache.
+ *
+ * \p makeCZESystem() looks up the given pair of compositions in the cache first
+ * and skips all composition processing if an identical pair has already been prepared.
+ * Least recently used entries are evicted when the capacity is exceeded. Systems
+ * created from an evicted entry remain valid.
+ *
+ * @param[in] capacity Maximum number of cached compositions. Zero disables the cache.
+ */
+ECHMET_API void ECHMET_CC setCZESystemCacheCapacity(const size_t capacity) ECHMET_NOEXCEPT;
+
+/*!
+ * Removes all entries from the process-wide cache of prepared compositions
+ * and resets its statistics.
+ */
+ECHMET_API void ECHMET_CC clearCZESystemCache() ECHMET_NOEXCEPT;
+
+/*!
+ * Returns usage statistics of the process-wide cache of prepared compositions.
+ * Statistics are counted since the last call of \p clearCZESystemCache().
+ *
+ * @param[out] stats Statistics of the cache.
+ */
+ECHMET_API void ECHMET_CC czeSystemCacheStatistics(RCZESystemCacheStatistics &stats) ECHMET_NOEXCEPT;
+
+/*!
+ * Creates the canonical key of a pair of compositions, the same key that identifies
+ * the compositions in the cache of prepared compositions. Pairs that differ only in the order
+ * of constituents or complex forms have identical keys. The key is an opaque printable string
+ * suitable for exact comparison and hashing, for example to recognize identical systems
+ * that come from different sources.
+ *
+ * @param[in] BGE Vector of constituents composing the background electrolyte.
+ * @param[in] sample Vector of constituents composing the sample zone.
+ * @param[out] key The key. Must be released with <tt>FixedString::destroy()</tt>.
+ *
+ * @retval RetCode::OK Success.
+ * @retval RetCode::E_NO_MEMORY Insufficient memory.
+ * @retval RetCode::E_INVALID_ARGUMENT Invalid argument was passed to the function.
+ */
+ECHMET_API RetCode ECHMET_CC compositionKey(const SysComp::InConstituentVec *BGE, const SysComp::InConstituentVec *sample, FixedString *&key) ECHMET_NOEXCEPT;
+
+/*!
+ * Restores the cache of prepared compositions from a snapshot created by
+ * \p saveCZESystemCacheSnapshot(). A file written by \p saveSystemDefinition()
+ * is accepted too and adds its single pair of compositions to the cache.
+ * All compositions in the file are prepared so that subsequent calls of \p makeCZESystem()
+ * with any of them skip all composition processing. Preparing them takes as long as creating
+ * the systems with \p makeCZESystem(), loading a snapshot only saves reading and parsing
+ * the definitions of the compositions. The capacity of the cache should be set with
+ * \p setCZESystemCacheCapacity() before the snapshot is loaded, entries
+ * over the capacity are evicted as usual.
+ *
+ * @param[in] path Path to the snapshot.
+ *
+ * @retval RetCode::OK Success.
+ * @retval RetCode::E_NO_MEMORY Insufficient memory.
+ * @retval RetCode::E_INVALID_ARGUMENT Invalid argument was passed to the function.
+ * @retval RetCode::E_IO_ERROR The file cannot be opened or mapped into memory.
+ * @retval RetCode::E_INVALID_FILE The file is not a system definition file, has an unsupported version,
+ *                                 was written on a machine with different byte order or is damaged.
+ * @retval Anything that can be returned by \p makeCZESystem().
+ */
+ECHMET_API RetCode ECHMET_CC loadCZESystemCacheSnapshot(const char *path) ECHMET_NOEXCEPT;
+
+/*!
+ * Stores the compositions held by the cache of prepared compositions in a file.
+ * The snapshot uses the format of \p saveSystemDefinition() with one pair of compositions
+ * per cached system. It contains only the compositions, the prepared systems are rebuilt
+ * from them by \p loadCZESystemCacheSnapshot().
+ *
+ * @param[in] path Path to the snapshot. Existing file is overwritten.
+ *
+ * @retval RetCode::OK Success.
+ * @retval RetCode::E_NO_MEMORY Insufficient memory.
+ * @retval RetCode::E_INVALID_ARGUMENT Invalid argument was passed to the function.
+ * @retval RetCode::E_IO_ERROR The file cannot be written.
+ */
+ECHMET_API RetCode ECHMET_CC saveCZESystemCacheSnapshot(const char *path) ECHMET_NOEXCEPT;
+
 /*!
  * Returns the minimum analytical concentrations of a constituent
  * that is considered safe for use by the numerical solver.
@@ -332,7 +918,8 @@ ECHMET_API RetCode ECHMET_CC findEigenzoneEnvelopes(REigenzoneEnvelopeVec *&enve
  * @retval RetCode::OK Success.
  * @retval RetCode::E_NO_MEMORY Insufficient memory to generate electrophoregram.
  * @retval RetCode::E_INTERNAL_ERROR Internal error has occured.
- * @retval RetCode::E_INVALID_ARGUMENT Concentration response was requested but no constituent name was given or nonsensical value of \p injectionZoneLength.
+ * @retval RetCode::E_INVALID_ARGUMENT Concentration response was requested but no constituent name was given, nonsensical value of \p injectionZoneLength
+ *                                     or the results lack dispersion parameters.
  * @retval RetCode::E_INVALID_CAPILLARY Nonsensical value of \p totalLength.
  * @retval RetCode::E_INVALID_DETECTOR_POSITION \p effectiveLength is greater than \p totalLength.
  */
@@ -358,6 +945,42 @@ ECHMET_API void ECHMET_CC releaseCZESystem(const CZESystem *czeSystem) ECHMET_NO
  */
 ECHMET_API void ECHMET_CC releaseResults(Results &results) ECHMET_NOEXCEPT;
 
+/*!
+ * Frees resources claimed by points of a parametric sweep.
+ *
+ * @param[in] points Points to be released.
+ */
+ECHMET_API void ECHMET_CC releaseSweepPoints(RSweepPointVec *points) ECHMET_NOEXCEPT;
+
+/*!
+ * Frees resources claimed by a buffer allocated by \p CZESystem::makeGridScanBuffer().
+ *
+ * @param[in] buffer Buffer to be released.
+ */
+ECHMET_API void ECHMET_CC releaseGridScanBuffer(RGridScanBuffer *buffer) ECHMET_NOEXCEPT;
+
+/*!
+ * Maps a grid scan file into memory.
+ *
+ * @param[in] path Path to the file.
+ * @param[out] file Mapped file. Must be released with \p releaseGridScanFile().
+ *
+ * @retval RetCode::OK Success.
+ * @retval RetCode::E_NO_MEMORY Insufficient memory.
+ * @retval RetCode::E_INVALID_ARGUMENT Invalid argument was passed to the function.
+ * @retval RetCode::E_IO_ERROR The file cannot be opened or mapped into memory.
+ * @retval RetCode::E_INVALID_FILE The file is not a grid scan file, has an unsupported version
+ *                                 or was written on a machine with different byte order.
+ */
+ECHMET_API RetCode ECHMET_CC openGridScanFile(const char *path, const RGridScanFile *&file) ECHMET_NOEXCEPT;
+
+/*!
+ * Unmaps a grid scan file mapped by \p openGridScanFile().
+ *
+ * @param[in] file File to be released.
+ */
+ECHMET_API void ECHMET_CC releaseGridScanFile(const RGridScanFile *file) ECHMET_NOEXCEPT;
+
 /*!
  * Sets all tracepoints to the given state.
  *
@@ -0,0 +1,308 @@
+#include "batch_driver.h"
+#include "jsonloader/inputreader.h"
+#include "json_input_processor.h"
+#include "ref_tool_common.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+class BatchJob {
+public:
+	BatchJob() :
+		correctForDH(false),
+		correctForOF(false),
+		correctForVS(false),
+		drivingVoltage(0.0),
+		totalLength(0.0),
+		effectiveLength(0.0),
+		uEOF(0.0),
+		succeeded(false),
+		seconds(0.0)
+	{}
+
+	std::string inputFile;
+	bool correctForDH;
+	bool correctForOF;
+	bool correctForVS;
+	double drivingVoltage;		/* V */
+	double totalLength;		/* m */
+	double effectiveLength;		/* m */
+	double uEOF;
+
+	bool succeeded;
+	std::string status;
+	double seconds;			/* Time spent on evaluation of the job */
+};
+
+/*
+ * Jobs that share one input file and thus one CZESystem
+ */
+class BatchGroup {
+public:
+	BatchGroup() :
+		prepareSeconds(0.0)
+	{}
+
+	std::string inputFile;
+	std::vector<size_t> jobs;
+	double prepareSeconds;		/* Time spent on reading the input and creating the CZESystem */
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static
+double secondsSince(const Clock::time_point &start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static
+bool readManifest(const char *manifestPath, std::vector<BatchJob> &jobs)
+{
+	std::ifstream manifest(manifestPath);
+	if (!manifest.is_open()) {
+		std::cerr << "ERROR: Cannot open manifest " << manifestPath << "\n";
+		return false;
+	}
+
+	std::string line;
+	size_t lineNo = 0;
+	while (std::getline(manifest, line)) {
+		lineNo++;
+
+		std::istringstream iss(line);
+		BatchJob job;
+		int DH;
+		int OF;
+		int VS;
+
+		if (!(iss >> job.inputFile) || job.inputFile[0] == '#')
+			continue;
+
+		if (!(iss >> DH >> OF >> VS >> job.drivingVoltage >> job.totalLength >> job.effectiveLength >> job.uEOF)) {
+			std::cerr << "ERROR: Invalid job on line " << lineNo << " of the manifest\n";
+			return false;
+		}
+
+		job.correctForDH = DH >= 1;
+		job.correctForOF = OF >= 1;
+		job.correctForVS = VS >= 1;
+		job.drivingVoltage *= 1000.0;
+		job.totalLength /= 100.0;
+		job.effectiveLength /= 100.0;
+
+		jobs.push_back(job);
+	}
+
+	return true;
+}
+
+static
+std::vector<BatchGroup> groupJobs(const std::vector<BatchJob> &jobs)
+{
+	std::map<std::string, size_t> groupIndices;
+	std::vector<BatchGroup> groups;
+
+	for (size_t idx = 0; idx < jobs.size(); idx++) {
+		const std::string &inputFile = jobs[idx].inputFile;
+		std::map<std::string, size_t>::const_iterator it = groupIndices.find(inputFile);
+
+		if (it == groupIndices.end()) {
+			it = groupIndices.emplace(inputFile, groups.size()).first;
+			groups.push_back(BatchGroup());
+			groups.back().inputFile = inputFile;
+		}
+
+		groups[it->second].jobs.push_back(idx);
+	}
+
+	return groups;
+}
+
+static
+void failGroup(std::vector<BatchJob> &jobs, const BatchGroup &group, const std::string &status)
+{
+	for (size_t idx = 0; idx < group.jobs.size(); idx++)
+		jobs[group.jobs[idx]].status = status;
+}
+
+static
+void evaluateJob(ECHMET::LEMNG::CZESystem *czeSystem, ECHMET::LEMNG::InAnalyticalConcentrationsMap *acBGEMap,
+		 ECHMET::LEMNG::InAnalyticalConcentrationsMap *acFullMap, const ECHMET::LEMNG::JsonInputProcessor::InputDescription &inputDesc,
+		 BatchJob &job, const std::string &outputBase)
+{
+	const Clock::time_point start = Clock::now();
+
+	ECHMET::NonidealityCorrections corrections = ECHMET::defaultNonidealityCorrections();
+	if (job.correctForDH)
+		ECHMET::nonidealityCorrectionSet(corrections, ECHMET::NonidealityCorrectionsItems::CORR_DEBYE_HUCKEL);
+	if (job.correctForOF)
+		ECHMET::nonidealityCorrectionSet(corrections, ECHMET::NonidealityCorrectionsItems::CORR_ONSAGER_FUOSS);
+	if (job.correctForVS)
+		ECHMET::nonidealityCorrectionSet(corrections, ECHMET::NonidealityCorrectionsItems::CORR_VISCOSITY);
+
+	ECHMET::LEMNG::Results results{};
+	const ECHMET::LEMNG::RetCode tRet = czeSystem->evaluate(acBGEMap, acFullMap, corrections, results);
+	if (tRet != ECHMET::LEMNG::RetCode::OK) {
+		job.status = std::string("Failed to solve the system: ") + czeSystem->lastErrorString();
+
+		/* Partially evaluated results are still handed over if the BGE was solved */
+		if (results.isBGEValid)
+			ECHMET::LEMNG::releaseResults(results);
+	} else {
+		std::ofstream out((outputBase + ".txt").c_str());
+		const std::string efgPlotsPath = outputBase + "_efg.csv";
+
+		printResults(out, efgPlotsPath.c_str(), results, job.drivingVoltage, job.totalLength, job.effectiveLength, job.uEOF, inputDesc.SampleConcentrations);
+		out.close();
+
+		job.succeeded = !out.fail();
+		job.status = job.succeeded ? "OK" : "Cannot write results";
+
+		ECHMET::LEMNG::releaseResults(results);
+	}
+
+	job.seconds = secondsSince(start);
+}
+
+/*
+ * Reads the input file of the group, creates its CZESystem and evaluates all jobs of the group
+ */
+static
+void evaluateGroup(std::vector<BatchJob> &jobs, BatchGroup &group, const std::string &outputDir, std::mutex &readerLock)
+{
+	const Clock::time_point start = Clock::now();
+	ECHMET::LEMNG::JsonInputProcessor::InputDescription inputDesc;
+
+	/* The JSON loader is not known to be reentrant */
+	try {
+		std::lock_guard<std::mutex> lk(readerLock);
+		ECHMET::LEMNG::JsonInputProcessor inputProc;
+		InputReader reader;
+
+		inputDesc = inputProc.process(reader.read(group.inputFile));
+	} catch (std::exception &ex) {
+		failGroup(jobs, group, ex.what());
+		return;
+	}
+
+	ECHMET::LEMNG::CZESystem *czeSystem = NULL;
+	ECHMET::LEMNG::RetCode tRet = ECHMET::LEMNG::makeCZESystem(inputDesc.BGEComposition, inputDesc.SampleComposition, czeSystem);
+	if (tRet != ECHMET::LEMNG::RetCode::OK) {
+		failGroup(jobs, group, std::string("Cannot create CZESystem: ") + ECHMET::LEMNG::LEMNGerrorToString(tRet));
+	} else {
+		ECHMET::LEMNG::InAnalyticalConcentrationsMap *acBGEMap;
+		ECHMET::LEMNG::InAnalyticalConcentrationsMap *acFullMap;
+
+		tRet = czeSystem->makeAnalyticalConcentrationsMaps(acBGEMap, acFullMap);
+		if (tRet != ECHMET::LEMNG::RetCode::OK) {
+			failGroup(jobs, group, "Failed to get analytical concentration maps");
+		} else {
+			applyConcentrations(acBGEMap, inputDesc.BGEConcentrations);
+			applyConcentrations(acFullMap, inputDesc.SampleConcentrations);
+
+			group.prepareSeconds = secondsSince(start);
+
+			for (size_t idx = 0; idx < group.jobs.size(); idx++) {
+				const size_t jobIdx = group.jobs[idx];
+				std::ostringstream outputBase;
+
+				outputBase << outputDir << "/job_" << jobIdx + 1;
+				evaluateJob(czeSystem, acBGEMap, acFullMap, inputDesc, jobs[jobIdx], outputBase.str());
+			}
+
+			acBGEMap->destroy();
+			acFullMap->destroy();
+		}
+
+		ECHMET::LEMNG::releaseCZESystem(czeSystem);
+	}
+
+	ECHMET::SysComp::releaseInputData(inputDesc.BGEComposition);
+	ECHMET::SysComp::releaseInputData(inputDesc.SampleComposition);
+}
+
+static
+bool writeSummary(const std::string &outputDir, const std::vector<BatchJob> &jobs, const std::vector<BatchGroup> &groups, const double wallSeconds)
+{
+	std::ofstream summary((outputDir + "/summary.csv").c_str());
+
+	summary << "job; input; status; time (s)\n";
+	for (size_t idx = 0; idx < jobs.size(); idx++) {
+		const BatchJob &job = jobs[idx];
+
+		summary << idx + 1 << "; " << job.inputFile << "; " << job.status << "; " << job.seconds << "\n";
+	}
+	summary.close();
+
+	size_t failed = 0;
+	double jobSeconds = 0.0;
+	for (size_t idx = 0; idx < jobs.size(); idx++) {
+		if (!jobs[idx].succeeded)
+			failed++;
+		jobSeconds += jobs[idx].seconds;
+	}
+
+	double prepareSeconds = 0.0;
+	for (size_t idx = 0; idx < groups.size(); idx++)
+		prepareSeconds += groups[idx].prepareSeconds;
+
+	std::cout << "Jobs: " << jobs.size() << ", failed: " << failed << "\n"
+		  << "Distinct systems: " << groups.size() << "\n"
+		  << "Preparation time (s): " << prepareSeconds << "\n"
+		  << "Evaluation time (s): " << jobSeconds << "\n"
+		  << "Wall time (s): " << wallSeconds << "\n";
+
+	return !summary.fail() && failed == 0;
+}
+
+int runBatch(const char *manifestPath, const char *outputDir, const unsigned int numThreads)
+{
+	const Clock::time_point start = Clock::now();
+	std::vector<BatchJob> jobs;
+
+	if (!readManifest(manifestPath, jobs))
+		return EXIT_FAILURE;
+
+	std::vector<BatchGroup> groups = groupJobs(jobs);
+	const std::string outDir(outputDir);
+
+	/* Largest groups go first so that no thread is left with a long tail */
+	std::vector<size_t> order(groups.size());
+	for (size_t idx = 0; idx < order.size(); idx++)
+		order[idx] = idx;
+	std::stable_sort(order.begin(), order.end(), [&groups](const size_t first, const size_t second) {
+		return groups[first].jobs.size() > groups[second].jobs.size();
+	});
+
+	std::atomic<size_t> nextGroup(0);
+	std::mutex readerLock;
+	const auto worker = [&]() {
+		for (;;) {
+			const size_t idx = nextGroup++;
+			if (idx >= order.size())
+				return;
+
+			evaluateGroup(jobs, groups[order[idx]], outDir, readerLock);
+		}
+	};
+
+	const unsigned int NThreads = std::max(1u, std::min(numThreads, static_cast<unsigned int>(groups.size())));
+	std::vector<std::thread> threads;
+	for (unsigned int idx = 1; idx < NThreads; idx++)
+		threads.emplace_back(worker);
+	worker();
+
+	for (size_t idx = 0; idx < threads.size(); idx++)
+		threads[idx].join();
+
+	return writeSummary(outDir, jobs, groups, secondsSince(start)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
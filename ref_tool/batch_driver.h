@@ -0,0 +1,21 @@
+#ifndef BATCH_DRIVER_H
+#define BATCH_DRIVER_H
+
+/*
+ * Evaluates all jobs listed in a manifest file.
+ *
+ * Each non-empty line of the manifest that does not start with '#' describes one job
+ * with the same parameters as the single-file mode of ref_tool:
+ *
+ *   inputFile DH_CORRECTION OF_CORRECTION VS_CORRECTION DrivingVoltage(kV) TotalLength(cm) EffectiveLength(cm) uEOF(U)
+ *
+ * Jobs that share an input file are evaluated by the same CZESystem, distinct input files
+ * are processed in parallel. Results of job N are written to outputDir/job_N.txt and
+ * outputDir/job_N_efg.csv, timings of all jobs to outputDir/summary.csv.
+ * The output directory must exist.
+ *
+ * Returns EXIT_SUCCESS if all jobs were evaluated successfully.
+ */
+int runBatch(const char *manifestPath, const char *outputDir, const unsigned int numThreads);
+
+#endif // BATCH_DRIVER_H
@@ -0,0 +1,23 @@
+#! /bin/sh
+source ./ref_tool_glob.sh
+
+clang -c jsonloader/constituents_json_ldr.c \
+	-I${LIBJANSSON_INCLUDE}
+clang++ -std=c++11 -pthread -Wall -Wextra -pedantic -g -O2 \
+	lemng_server.cpp ref_tool_common.cpp response_cache.cpp json_input_processor.cpp jsonloader/inputreader.cpp \
+	constituents_json_ldr.o ${LIBJANSSON_BIN} \
+	-o lemng_server \
+	-I${LEMNG_INCLUDE} \
+	-I${ECL_INCLUDE} \
+	-DECHMET_COMPILER_GCC_LIKE \
+	-Wl,-rpath,${ECL_BIN} \
+	-L${ECL_BIN} \
+	-L${LEMNG_BIN} \
+	-lECHMETShared -lSysComp \
+	-lLEMNG
+clang++ -std=c++11 -Wall -Wextra -pedantic -g -O2 \
+	lemng_client.cpp \
+	-o lemng_client \
+	-I${LEMNG_INCLUDE} \
+	-I${ECL_INCLUDE} \
+	-DECHMET_COMPILER_GCC_LIKE
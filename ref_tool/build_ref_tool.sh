@@ -3,8 +3,8 @@ source ./ref_tool_glob.sh
 
 clang -c jsonloader/constituents_json_ldr.c \
 	-I${LIBJANSSON_INCLUDE}
-clang++ -std=c++98 -Wall -Wextra -pedantic -g -O0 \
-	ref_tool.cpp json_input_processor.cpp jsonloader/inputreader.cpp \
+clang++ -std=c++11 -pthread -Wall -Wextra -pedantic -g -O0 \
+	ref_tool.cpp ref_tool_common.cpp batch_driver.cpp json_input_processor.cpp jsonloader/inputreader.cpp \
 	constituents_json_ldr.o ${LIBJANSSON_BIN} \
 	-o ref_tool \
 	-I${LEMNG_INCLUDE} \
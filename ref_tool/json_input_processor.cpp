@@ -90,7 +90,7 @@ void JsonInputProcessor::makeSysCompComplexForms(SysComp::InConstituent &scCtuen
 
 		scCF.nucleusCharge = cForm->nucleusCharge;
 
-		if (scCtuent.complexForms->push_back(scCF) != OK) {
+		if (scCtuent.complexForms->push_back(scCF) != ::ECHMET::RetCode::OK) {
 			cleanupInLigandGroups(scCF.ligandGroups);
 			throw std::runtime_error("Cannot push back complex form");
 		}
@@ -127,7 +127,7 @@ void JsonInputProcessor::makeSysCompInputInternal(SysComp::InConstituentVec *inC
 
 		zeroInitializeINC(scCtuent);
 
-		scCtuent.ctype = (ctuent->ctype == ::LIGAND) ? SysComp::LIGAND : SysComp::NUCLEUS;
+		scCtuent.ctype = (ctuent->ctype == ::LIGAND) ? SysComp::ConstituentType::LIGAND : SysComp::ConstituentType::NUCLEUS;
 		scCtuent.chargeLow = ctuent->chargeLow;
 		scCtuent.chargeHigh = ctuent->chargeHigh;
 		scCtuent.viscosityCoefficient = ctuent->viscosityCoefficient;
@@ -165,7 +165,7 @@ void JsonInputProcessor::makeSysCompInputInternal(SysComp::InConstituentVec *inC
 		}
 
 		try {
-			if (scCtuent.ctype == SysComp::NUCLEUS)
+			if (scCtuent.ctype == SysComp::ConstituentType::NUCLEUS)
 				makeSysCompComplexForms(scCtuent, ctuent, listOfAnalytes);
 		} catch (std::runtime_error &up) {
 			cleanupInConstituent(scCtuent);
@@ -174,7 +174,7 @@ void JsonInputProcessor::makeSysCompInputInternal(SysComp::InConstituentVec *inC
 		}
 
 		for (int pidx = 0; pidx < numpKas; pidx++) {
-			if (scCtuent.pKas->push_back(ctuent->pKas[pidx]) != OK) {
+			if (scCtuent.pKas->push_back(ctuent->pKas[pidx]) != ::ECHMET::RetCode::OK) {
 				cleanupInConstituent(scCtuent);
 				cleanupInConstituentVector(inCtuentVec);
 				throw std::runtime_error("Cannot push back pKa");
@@ -182,14 +182,14 @@ void JsonInputProcessor::makeSysCompInputInternal(SysComp::InConstituentVec *inC
 		}
 
 		for (int midx = 0; midx < numMobilities; midx++) {
-			if (scCtuent.mobilities->push_back(ctuent->mobilities[midx]) != OK) {
+			if (scCtuent.mobilities->push_back(ctuent->mobilities[midx]) != ::ECHMET::RetCode::OK) {
 				cleanupInConstituent(scCtuent);
 				cleanupInConstituentVector(inCtuentVec);
 				throw std::runtime_error("Cannot push back constituent mobility");
 			}
 		}
 
-		if (inCtuentVec->push_back(scCtuent) != OK) {
+		if (inCtuentVec->push_back(scCtuent) != ::ECHMET::RetCode::OK) {
 			cleanupInConstituent(scCtuent);
 			cleanupInConstituentVector(inCtuentVec);
 			throw std::runtime_error("Cannot push back constituent");
@@ -271,7 +271,7 @@ void JsonInputProcessor::makeSysCompLigands(SysComp::InLigandGroup &scLG, const
 			throw std::runtime_error("Cannot create pBs vector");
 
 		for (int pbidx = 0; pbidx < lForm->maxCount; pbidx++) {
-			if (scLF.pBs->push_back(lForm->pBs[pbidx]) != OK) {
+			if (scLF.pBs->push_back(lForm->pBs[pbidx]) != ::ECHMET::RetCode::OK) {
 				cleanupInLigandForm(scLF);
 				throw std::runtime_error("Cannot push back pB");
 			}
@@ -284,7 +284,7 @@ void JsonInputProcessor::makeSysCompLigands(SysComp::InLigandGroup &scLG, const
 		}
 
 		for (int midx = 0; midx < lForm->maxCount; midx++) {
-			if (scLF.mobilities->push_back(lForm->mobilities[midx]) != OK) {
+			if (scLF.mobilities->push_back(lForm->mobilities[midx]) != ::ECHMET::RetCode::OK) {
 				cleanupInLigandForm(scLF);
 				throw std::runtime_error("Cannot push back ligand form mobility");
 			}
@@ -299,7 +299,7 @@ void JsonInputProcessor::makeSysCompLigands(SysComp::InLigandGroup &scLG, const
 		scLF.charge = lForm->charge;
 		scLF.maxCount = lForm->maxCount;
 
-		if (scLG.ligands->push_back(scLF) != OK) {
+		if (scLG.ligands->push_back(scLF) != ::ECHMET::RetCode::OK) {
 			cleanupInLigandForm(scLF);
 			throw std::runtime_error("Cannot push back ligand form");
 		}
@@ -325,7 +325,7 @@ void JsonInputProcessor::makeSysCompLigandGroups(SysComp::InComplexForm &scCF, c
 			throw up;
 		}
 
-		if (scCF.ligandGroups->push_back(scLG) != OK) {
+		if (scCF.ligandGroups->push_back(scLG) != ::ECHMET::RetCode::OK) {
 			cleanupInLigands(scLG.ligands);
 			throw std::runtime_error("Cannot push back ligand group");
 		}
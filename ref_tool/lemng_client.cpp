@@ -0,0 +1,109 @@
+#include "server_protocol.h"
+#include <lemng.h>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/*
+ * Minimal client of lemng_server. Sends one evaluation request and prints the response.
+ */
+
+using namespace ServerProtocol;
+
+int main(int argc, char **argv)
+{
+	if (argc < 10) {
+		std::cout << "Usage: socketPath inputFile DH_CORRECTION(number) OF_CORRECTION(number) VS_CORRECTION(number) DrivingVoltage(kV) TotalLength(cm) EffectiveLength(cm) uEOF(U) [plotEFG(number)]\n";
+		return EXIT_FAILURE;
+	}
+
+	int32_t corrections = 0;
+	if (std::atoi(argv[3]) >= 1)
+		corrections |= CORRECTION_DEBYE_HUCKEL;
+	if (std::atoi(argv[4]) >= 1)
+		corrections |= CORRECTION_ONSAGER_FUOSS;
+	if (std::atoi(argv[5]) >= 1)
+		corrections |= CORRECTION_VISCOSITY;
+
+	MessageWriter request(MSG_EVALUATE);
+	request.put(std::string(argv[2]));
+	request.put(corrections);
+	request.put(strtod(argv[6], NULL) * 1000.0);
+	request.put(strtod(argv[7], NULL) / 100.0);
+	request.put(strtod(argv[8], NULL) / 100.0);
+	request.put(strtod(argv[9], NULL));
+	request.put(static_cast<int32_t>(argc >= 11 && std::atoi(argv[10]) >= 1));
+
+	sockaddr_un addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (std::strlen(argv[1]) >= sizeof(addr.sun_path)) {
+		std::cerr << "ERROR: Socket path is too long\n";
+		return EXIT_FAILURE;
+	}
+	std::strcpy(addr.sun_path, argv[1]);
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+		std::perror("Cannot connect to server");
+		return EXIT_FAILURE;
+	}
+
+	std::string payload;
+	if (!writeFrame(fd, request) || !readFrame(fd, payload)) {
+		std::cerr << "ERROR: Connection to server failed\n";
+		close(fd);
+		return EXIT_FAILURE;
+	}
+	close(fd);
+
+	try {
+		MessageReader response(payload);
+
+		if (response.type() == MSG_ERROR) {
+			const int32_t tRet = response.getInt32();
+
+			std::cout << "Error " << tRet << ": " << response.getString() << "\n";
+			return EXIT_FAILURE;
+		} else if (response.type() != MSG_RESULTS) {
+			std::cerr << "ERROR: Unexpected response\n";
+			return EXIT_FAILURE;
+		}
+
+		std::cout << "*** BGE PROPERTIES ***\n";
+		std::cout << "pH: " << response.getDouble() << "\n";
+		std::cout << "conductivity: " << response.getDouble() << "\n";
+		std::cout << "ionic strength: " << response.getDouble() << "\n";
+		std::cout << "buffer capacity: " << response.getDouble() << "\n";
+
+		const uint32_t numZones = response.getUInt32();
+		for (uint32_t idx = 0; idx < numZones; idx++) {
+			const int32_t ztype = response.getInt32();
+			const int32_t tainted = response.getInt32();
+
+			std::cout << "*** EIGENZONE " << idx << " " << (ztype == static_cast<int32_t>(ECHMET::LEMNG::EigenzoneType::ANALYTE) ? "(ANALYTE)" : "(SYSTEM)")
+				  << (tainted ? " (TAINTED)" : "") << " ***\n";
+			std::cout << "mobility: " << response.getDouble() << "\n";
+			std::cout << "uEMD: " << response.getDouble() << "\n";
+			std::cout << "a2t: " << response.getDouble() << "\n";
+		}
+
+		const uint32_t numPoints = response.getUInt32();
+		if (numPoints > 0)
+			std::cout << "*** EFG ***\n";
+		for (uint32_t idx = 0; idx < numPoints; idx++) {
+			const double time = response.getDouble();
+			const double value = response.getDouble();
+
+			std::cout << time << "; " << value << "\n";
+		}
+	} catch (MalformedMessage &ex) {
+		std::cerr << "ERROR: " << ex.what() << "\n";
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,487 @@
+#include "jsonloader/inputreader.h"
+#include "json_input_processor.h"
+#include "ref_tool_common.h"
+#include "response_cache.h"
+#include "server_protocol.h"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+using namespace ServerProtocol;
+
+/*
+ * CZESystem with analytical concentrations set up from its input file
+ */
+class PooledSystem {
+public:
+	PooledSystem() :
+		czeSystem(NULL),
+		acBGEMap(NULL),
+		acFullMap(NULL)
+	{}
+
+	~PooledSystem()
+	{
+		if (acBGEMap != NULL)
+			acBGEMap->destroy();
+		if (acFullMap != NULL)
+			acFullMap->destroy();
+		if (czeSystem != NULL)
+			ECHMET::LEMNG::releaseCZESystem(czeSystem);
+	}
+
+	ECHMET::LEMNG::CZESystem *czeSystem;
+	ECHMET::LEMNG::InAnalyticalConcentrationsMap *acBGEMap;
+	ECHMET::LEMNG::InAnalyticalConcentrationsMap *acFullMap;
+};
+
+/*
+ * Parsed input file together with the idle systems created from it.
+ * A system serves one request at a time, concurrent requests for the same
+ * input get additional systems which are cheap to create as the library
+ * caches the prepared composition.
+ */
+class PoolEntry {
+public:
+	PoolEntry() :
+		modificationTime(0),
+		fileSize(0)
+	{}
+
+	~PoolEntry()
+	{
+		for (size_t idx = 0; idx < idle.size(); idx++)
+			delete idle[idx];
+
+		ECHMET::SysComp::releaseInputData(inputDesc.BGEComposition);
+		ECHMET::SysComp::releaseInputData(inputDesc.SampleComposition);
+	}
+
+	ECHMET::LEMNG::JsonInputProcessor::InputDescription inputDesc;
+	std::string compositionKey;		/* Canonical key of the compositions as returned by LEMNG::compositionKey() */
+	time_t modificationTime;		/* Modification time and size of the input file when it was parsed */
+	off_t fileSize;
+	std::vector<PooledSystem *> idle;
+	std::mutex lock;
+};
+typedef std::shared_ptr<PoolEntry> PoolEntryPtr;
+
+class RequestError : public std::runtime_error {
+public:
+	RequestError(const std::string &message, const ECHMET::LEMNG::RetCode tRet) :
+		std::runtime_error(message),
+		tRet(tRet)
+	{}
+
+	const ECHMET::LEMNG::RetCode tRet;
+};
+
+/*
+ * LRU pool of parsed input files. Entries that are evicted while a request
+ * is using them stay alive until the request finishes. An input file is parsed
+ * again if its modification time or size has changed since it was pooled.
+ */
+class SystemPool {
+public:
+	explicit SystemPool(const size_t capacity) :
+		m_capacity(capacity)
+	{}
+
+	PoolEntryPtr entry(const std::string &inputFile)
+	{
+		struct stat st;
+		if (stat(inputFile.c_str(), &st) != 0)
+			throw RequestError(inputFile + ": Cannot access input file", ECHMET::LEMNG::RetCode::E_IO_ERROR);
+
+		std::lock_guard<std::mutex> lk(m_lock);
+
+		std::unordered_map<std::string, LRUList::iterator>::iterator it = m_index.find(inputFile);
+		if (it != m_index.end()) {
+			const PoolEntryPtr &pooled = it->second->second;
+
+			if (pooled->modificationTime == st.st_mtime && pooled->fileSize == st.st_size) {
+				m_lru.splice(m_lru.begin(), m_lru, it->second);
+				return pooled;
+			}
+
+			/* The file has been edited, requests still using the old entry keep it alive */
+			m_lru.erase(it->second);
+			m_index.erase(it);
+		}
+
+		/* Parsing is serialized by the pool lock as the JSON loader is not known to be reentrant */
+		PoolEntryPtr e = std::make_shared<PoolEntry>();
+		try {
+			ECHMET::LEMNG::JsonInputProcessor inputProc;
+			InputReader reader;
+
+			e->inputDesc = inputProc.process(reader.read(inputFile));
+		} catch (std::exception &ex) {
+			throw RequestError(inputFile + ": " + ex.what(), ECHMET::LEMNG::RetCode::E_INVALID_ARGUMENT);
+		}
+		e->modificationTime = st.st_mtime;
+		e->fileSize = st.st_size;
+
+		ECHMET::FixedString *key;
+		const ECHMET::LEMNG::RetCode tRet = ECHMET::LEMNG::compositionKey(e->inputDesc.BGEComposition, e->inputDesc.SampleComposition, key);
+		if (tRet != ECHMET::LEMNG::RetCode::OK)
+			throw RequestError(inputFile + ": Cannot create composition key", tRet);
+		e->compositionKey = key->c_str();
+		key->destroy();
+
+		if (m_capacity < 1)
+			return e;
+
+		m_lru.emplace_front(inputFile, e);
+		try {
+			m_index.emplace(inputFile, m_lru.begin());
+		} catch (std::bad_alloc &) {
+			m_lru.pop_front();
+			throw;
+		}
+
+		while (m_lru.size() > m_capacity) {
+			m_index.erase(m_lru.back().first);
+			m_lru.pop_back();
+		}
+
+		return e;
+	}
+
+	static PooledSystem * acquire(PoolEntry &e)
+	{
+		{
+			std::lock_guard<std::mutex> lk(e.lock);
+
+			if (!e.idle.empty()) {
+				PooledSystem *sys = e.idle.back();
+				e.idle.pop_back();
+
+				return sys;
+			}
+		}
+
+		std::unique_ptr<PooledSystem> sys(new PooledSystem());
+		ECHMET::LEMNG::RetCode tRet = ECHMET::LEMNG::makeCZESystem(e.inputDesc.BGEComposition, e.inputDesc.SampleComposition, sys->czeSystem);
+		if (tRet != ECHMET::LEMNG::RetCode::OK)
+			throw RequestError("Cannot create CZESystem", tRet);
+
+		tRet = sys->czeSystem->makeAnalyticalConcentrationsMaps(sys->acBGEMap, sys->acFullMap);
+		if (tRet != ECHMET::LEMNG::RetCode::OK)
+			throw RequestError("Failed to get analytical concentration maps", tRet);
+
+		applyConcentrations(sys->acBGEMap, e.inputDesc.BGEConcentrations);
+		applyConcentrations(sys->acFullMap, e.inputDesc.SampleConcentrations);
+
+		return sys.release();
+	}
+
+	static void release(PoolEntry &e, PooledSystem *sys)
+	{
+		std::lock_guard<std::mutex> lk(e.lock);
+
+		e.idle.push_back(sys);
+	}
+
+private:
+	typedef std::list<std::pair<std::string, PoolEntryPtr>> LRUList;
+
+	const size_t m_capacity;				/* Maximum number of pooled input files */
+	LRUList m_lru;						/* Most recently used entry is at the front */
+	std::unordered_map<std::string, LRUList::iterator> m_index;
+	std::mutex m_lock;
+};
+
+static const size_t DEFAULT_RESPONSE_CACHE_SIZE = 64;	/* MiB */
+static const size_t DEFAULT_POOL_SIZE = 32;		/* Input files */
+
+static char s_socketPath[sizeof(sockaddr_un::sun_path)];
+
+static
+void onTerminate(int)
+{
+	unlink(s_socketPath);
+	_exit(EXIT_SUCCESS);
+}
+
+/*
+ * Parameters of an MSG_EVALUATE request
+ */
+class EvaluationRequest {
+public:
+	explicit EvaluationRequest(MessageReader &request) :
+		inputFile(request.getString()),
+		correctionFlags(request.getInt32()),
+		drivingVoltage(request.getDouble()),
+		totalLength(request.getDouble()),
+		effectiveLength(request.getDouble()),
+		uEOF(request.getDouble()),
+		plotEFG(request.getInt32() != 0)
+	{}
+
+	const std::string inputFile;
+	const int32_t correctionFlags;
+	const double drivingVoltage;
+	const double totalLength;
+	const double effectiveLength;
+	const double uEOF;
+	const bool plotEFG;
+};
+
+static
+void putConcentrations(MessageWriter &key, const ECHMET::LEMNG::JsonInputProcessor::ConcentrationMap &concentrations)
+{
+	key.put(static_cast<uint32_t>(concentrations.size()));
+	for (ECHMET::LEMNG::JsonInputProcessor::ConcentrationMap::const_iterator it = concentrations.begin(); it != concentrations.end(); it++) {
+		key.put(it->first);
+		key.put(it->second);
+	}
+}
+
+/*
+ * Identifies the response to a request by everything it depends on rather than by the path
+ * of the input file. Identical systems from different files thus share their responses.
+ */
+static
+std::string makeResponseKey(const PoolEntry &e, const EvaluationRequest &req)
+{
+	MessageWriter key(MSG_EVALUATE);
+
+	key.put(e.compositionKey);
+	putConcentrations(key, e.inputDesc.BGEConcentrations);
+	putConcentrations(key, e.inputDesc.SampleConcentrations);
+	key.put(req.correctionFlags & (CORRECTION_DEBYE_HUCKEL | CORRECTION_ONSAGER_FUOSS | CORRECTION_VISCOSITY));
+	key.put(static_cast<int32_t>(req.plotEFG));
+	if (req.plotEFG) {
+		key.put(req.drivingVoltage);
+		key.put(req.totalLength);
+		key.put(req.effectiveLength);
+		key.put(req.uEOF);
+	}
+
+	return key.data();
+}
+
+static
+MessageWriter evaluate(PoolEntry &e, const EvaluationRequest &req)
+{
+	ECHMET::NonidealityCorrections corrections = ECHMET::defaultNonidealityCorrections();
+	if (req.correctionFlags & CORRECTION_DEBYE_HUCKEL)
+		ECHMET::nonidealityCorrectionSet(corrections, ECHMET::NonidealityCorrectionsItems::CORR_DEBYE_HUCKEL);
+	if (req.correctionFlags & CORRECTION_ONSAGER_FUOSS)
+		ECHMET::nonidealityCorrectionSet(corrections, ECHMET::NonidealityCorrectionsItems::CORR_ONSAGER_FUOSS);
+	if (req.correctionFlags & CORRECTION_VISCOSITY)
+		ECHMET::nonidealityCorrectionSet(corrections, ECHMET::NonidealityCorrectionsItems::CORR_VISCOSITY);
+
+	PooledSystem *sys = SystemPool::acquire(e);
+
+	ECHMET::LEMNG::Results results{};
+	const ECHMET::LEMNG::RetCode tRet = sys->czeSystem->evaluate(sys->acBGEMap, sys->acFullMap, corrections, results);
+	if (tRet != ECHMET::LEMNG::RetCode::OK) {
+		const std::string error = sys->czeSystem->lastErrorString();
+
+		/* Partially evaluated results are still handed over if the BGE was solved */
+		if (results.isBGEValid)
+			ECHMET::LEMNG::releaseResults(results);
+		SystemPool::release(e, sys);
+		throw RequestError("Failed to solve the system: " + error, tRet);
+	}
+	SystemPool::release(e, sys);
+
+	MessageWriter response(MSG_RESULTS);
+	response.put(results.BGEProperties.pH);
+	response.put(results.BGEProperties.conductivity);
+	response.put(results.BGEProperties.ionicStrength);
+	response.put(results.BGEProperties.bufferCapacity);
+
+	response.put(static_cast<uint32_t>(results.eigenzones->size()));
+	for (size_t idx = 0; idx < results.eigenzones->size(); idx++) {
+		const ECHMET::LEMNG::REigenzone &ez = results.eigenzones->at(idx);
+
+		response.put(static_cast<int32_t>(ez.ztype));
+		response.put(static_cast<int32_t>(ez.tainted));
+		response.put(ez.mobility);
+		response.put(ez.uEMD);
+		response.put(ez.a2t);
+	}
+
+	ECHMET::LEMNG::EFGPairVec *electrophoregram = NULL;
+	if (req.plotEFG) {
+		const ECHMET::LEMNG::RetCode plRet = plotElectrophoregram(electrophoregram, results, req.drivingVoltage, req.totalLength, req.effectiveLength, req.uEOF,
+									  0.001, ECHMET::LEMNG::EFGResponseType::RESP_CONDUCTIVITY);
+		if (plRet != ECHMET::LEMNG::RetCode::OK) {
+			ECHMET::LEMNG::releaseResults(results);
+			throw RequestError("Cannot plot EFG", plRet);
+		}
+	}
+	ECHMET::LEMNG::releaseResults(results);
+
+	if (electrophoregram == NULL) {
+		response.put(static_cast<uint32_t>(0));
+	} else {
+		response.put(static_cast<uint32_t>(electrophoregram->size()));
+		for (size_t idx = 0; idx < electrophoregram->size(); idx++) {
+			response.put(electrophoregram->at(idx).time);
+			response.put(electrophoregram->at(idx).value);
+		}
+		electrophoregram->destroy();
+	}
+
+	return response;
+}
+
+static
+std::string errorResponse(const ECHMET::LEMNG::RetCode tRet, const std::string &message)
+{
+	MessageWriter response(MSG_ERROR);
+
+	response.put(static_cast<int32_t>(tRet));
+	response.put(message);
+
+	return response.data();
+}
+
+/*
+ * Builds the response to a request. Responses to evaluations are looked up
+ * in the cache first, only successful evaluations are cacheable.
+ */
+static
+std::string respond(SystemPool &pool, ResponseCache &cache, const std::string &payload)
+{
+	try {
+		MessageReader request(payload);
+
+		switch (request.type()) {
+		case MSG_EVALUATE:
+		{
+			const EvaluationRequest req(request);
+			PoolEntryPtr e = pool.entry(req.inputFile);
+
+			return cache.get(makeResponseKey(*e, req), [&e, &req](bool &cacheable) -> std::string {
+				cacheable = false;
+				try {
+					const MessageWriter response = evaluate(*e, req);
+					cacheable = true;
+
+					return response.data();
+				} catch (RequestError &ex) {
+					return errorResponse(ex.tRet, ex.what());
+				}
+			});
+		}
+		default:
+			throw RequestError("Unknown request", ECHMET::LEMNG::RetCode::E_INVALID_ARGUMENT);
+		}
+	} catch (RequestError &ex) {
+		return errorResponse(ex.tRet, ex.what());
+	} catch (MalformedMessage &ex) {
+		return errorResponse(ECHMET::LEMNG::RetCode::E_INVALID_ARGUMENT, ex.what());
+	} catch (std::bad_alloc &) {
+		return errorResponse(ECHMET::LEMNG::RetCode::E_NO_MEMORY, "Insufficient memory");
+	} catch (std::exception &ex) {
+		return errorResponse(ECHMET::LEMNG::RetCode::E_INTERNAL_ERROR, ex.what());
+	}
+}
+
+/*
+ * Runs in a detached thread, no exception may escape it
+ */
+static
+void serveConnection(SystemPool &pool, ResponseCache &cache, const int fd)
+{
+	try {
+		std::string payload;
+
+		while (readFrame(fd, payload)) {
+			const std::string response = respond(pool, cache, payload);
+
+			if (!writeFrame(fd, response))
+				break;
+		}
+	} catch (...) {
+		/* Nothing sensible can be sent back, drop the connection */
+	}
+
+	close(fd);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2) {
+		std::cout << "Usage: socketPath [numberOfCachedCompositions] [responseCacheSize(MiB)] [numberOfPooledInputFiles]\n";
+		return EXIT_FAILURE;
+	}
+
+	const std::string socketPath(argv[1]);
+	if (socketPath.size() >= sizeof(s_socketPath)) {
+		std::cerr << "ERROR: Socket path is too long\n";
+		return EXIT_FAILURE;
+	}
+	std::strcpy(s_socketPath, socketPath.c_str());
+
+	if (argc >= 3)
+		ECHMET::LEMNG::setCZESystemCacheCapacity(std::atoi(argv[2]));
+
+	size_t responseCacheSize = DEFAULT_RESPONSE_CACHE_SIZE;
+	if (argc >= 4)
+		responseCacheSize = std::strtoul(argv[3], NULL, 10);
+
+	size_t poolSize = DEFAULT_POOL_SIZE;
+	if (argc >= 5)
+		poolSize = std::strtoul(argv[4], NULL, 10);
+
+	const int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenFd < 0) {
+		std::perror("Cannot create socket");
+		return EXIT_FAILURE;
+	}
+
+	sockaddr_un addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	std::strcpy(addr.sun_path, s_socketPath);
+
+	unlink(s_socketPath);
+	if (bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(listenFd, SOMAXCONN) != 0) {
+		std::perror("Cannot listen on socket");
+		close(listenFd);
+		return EXIT_FAILURE;
+	}
+
+	signal(SIGPIPE, SIG_IGN);
+	signal(SIGINT, onTerminate);
+	signal(SIGTERM, onTerminate);
+
+	SystemPool pool(poolSize);
+	ResponseCache cache(responseCacheSize * 1024 * 1024);
+
+	/* Each connection is served by its own thread, requests on different
+	 * connections are thus evaluated concurrently */
+	for (;;) {
+		const int fd = accept(listenFd, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR)
+				continue;
+			std::perror("Cannot accept connection");
+			break;
+		}
+
+		std::thread(serveConnection, std::ref(pool), std::ref(cache), fd).detach();
+	}
+
+	close(listenFd);
+	unlink(s_socketPath);
+
+	return EXIT_FAILURE;
+}
@@ -1,131 +1,14 @@
 #include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <thread>
 #include <vector>
 #include <lemng.h>
 #include "jsonloader/inputreader.h"
+#include "batch_driver.h"
 #include "json_input_processor.h"
-
-void printComposition(ECHMET::LEMNG::RConstituentMap *composition) {
-	ECHMET::LEMNG::RConstituentMap::Iterator *it = composition->begin();
-	if (it == NULL) {
-		std::cerr << "Cannot get iterator";
-		return;
-	}
-
-	while (it->hasNext()) {
-		const ECHMET::LEMNG::RConstituent &ctuent = it->value();
-
-		std::cout << "- " << ctuent.name->c_str() << " " << ctuent.concentration << "\n";
-		ECHMET::LEMNG::RFormMap::Iterator *fit = ctuent.forms->begin(); /* Here should be a nullptr check */
-		while (fit->hasNext()) {
-			const ECHMET::LEMNG::RForm &rForm = fit->value();
-
-			std::cout << "\t";
-
-			for (size_t jdx = 0; jdx < rForm.ions->size(); jdx++) {
-				const ECHMET::LEMNG::RIon &ion = rForm.ions->at(jdx);
-
-				std::cout << ion.name->c_str() << "(" << ion.charge << ")" << "[" << ion.count << "]";
-			}
-			std::cout << ": " << rForm.concentration << "\n";
-
-			fit->next();
-		}
-		fit->destroy();
-		it->next();
-
-	}
-	it->destroy();
-	std::cout << "\n";
-}
-
-void printProperties(const ECHMET::LEMNG::RSolutionProperties &properties, const bool printBufCap = false)
-{
-	printf("pH: %.11g\n", properties.pH);
-	printf("conductivity: %.11g\n", properties.conductivity);
-	printf("ionic strength: %.11g\n", properties.ionicStrength);
-	if (printBufCap)
-		printf("buffer capacity: %.11g\n", properties.bufferCapacity);
-
-	printComposition(properties.composition);
-}
-
-const char * ezType(const ECHMET::LEMNG::EigenzoneType ezType)
-{
-	if (ezType == ECHMET::LEMNG::ANALYTE)
-		return "(ANALYTE)";
-	return "(SYSTEM)";
-}
-
-void printResults(const ECHMET::LEMNG::Results &results, const double drivingVoltage, const double totalLength, const double effectiveLength, const double uEOF, const std::map<std::string, double> &aMap)
-{
-	std::cout << "*** BGE PROPERTIES ***\n";
-	printProperties(results.BGEProperties, true);
-
-
-	for (size_t idx = 0; idx < results.eigenzones->size(); idx++) {
-		const ECHMET::LEMNG::REigenzone &ez = results.eigenzones->at(idx);
-
-		std::cout << "*** EIGENZONE " << idx << " "
-			<< ezType(ez.ztype)
-			<< (ez.tainted ? " (TAINTED)" : "") << " ***\n";
-		printf("mobility: %.11g\n", ez.mobility);
-		std::cout << "a2t: " << ez.a2t << "\n";
-		printf("uEMD: %.11g\n", ez.uEMD);
-
-		printProperties(ez.solutionProperties);
-	}
-
-	std::cout << "--- Plotting EFG ---\n";
-
-	std::vector<double> times;
-	std::vector<std::vector<double> > signals;
-
-	std::cout << "* Conductivity *\n";
-	ECHMET::LEMNG::EFGPairVec *electrophoregram;
-	ECHMET::LEMNG::RetCode tRet = plotElectrophoregram(electrophoregram, results, drivingVoltage, totalLength, effectiveLength, uEOF, 0.001, ECHMET::LEMNG::RESP_CONDUCTIVITY);
-	if (tRet != ECHMET::LEMNG::OK) {
-		std::cout << " Cannot plot EFG " << LEMNGerrorToString(tRet) << std::endl;
-		return;
-	}
-
-	for (size_t idx = 0; idx < electrophoregram->size(); idx++) {
-		const ECHMET::LEMNG::EFGPair &p = electrophoregram->at(idx);
-		//std::cout << p.time << "; " << p.value << "\n";
-
-		times.push_back(p.time);
-		signals.push_back(std::vector<double>(p.value));
-	}
-	electrophoregram->destroy();
-
-	for (std::map<std::string, double>::const_iterator cit = aMap.begin(); cit != aMap.end(); cit++) {
-		const char *key = cit->first.c_str();
-
-		std::cout << "* " << key << " *\n";
-
-		plotElectrophoregram(electrophoregram, results, drivingVoltage, totalLength, effectiveLength, uEOF, 0.001, ECHMET::LEMNG::RESP_CONCENTRATION, key);
-
-		for (size_t idx = 0; idx < electrophoregram->size(); idx++) {
-			const ECHMET::LEMNG::EFGPair &p = electrophoregram->at(idx);
-			signals[idx].push_back(p.value);
-			//std::cout << p.time << "; " << p.value << "\n";
-		}
-		electrophoregram->destroy();
-	}
-
-
-	std::ofstream efgPlots("efgplots.csv");
-	for (size_t idx = 0; idx < times.size(); idx++) {
-		efgPlots << times.at(idx) << "; ";
-
-		const std::vector<double> &sig = signals.at(idx);
-		for (size_t jdx = 0; jdx < sig.size(); jdx++) {
-			efgPlots << sig.at(jdx) << "; ";
-		}
-		efgPlots << "\n";
-	}
-}
+#include "ref_tool_common.h"
 
 const char * isEnabledAns(const bool enabled)
 {
@@ -163,12 +46,6 @@ void printTrace()
 		std::cout << "No trace\n";
 }
 
-void applyConcentrations(ECHMET::LEMNG::InAnalyticalConcentrationsMap *acMap, const std::map<std::string, double> &rdAcMap)
-{
-	for (std::map<std::string, double>::const_iterator cit = rdAcMap.begin(); cit != rdAcMap.end(); cit++)
-		acMap->item(cit->first.c_str()) = cit->second;
-}
-
 int launch(int argc, char **argv)
 {
 	const char *inputDataFile;
@@ -183,8 +60,17 @@ int launch(int argc, char **argv)
 	ECHMET::LEMNG::RetCode ltRet;
 	ECHMET::LEMNG::CZESystem *czeSystem = NULL;
 
+	if (argc >= 4 && std::string(argv[1]) == "--batch") {
+		unsigned int numThreads = std::thread::hardware_concurrency();
+		if (argc >= 5)
+			numThreads = std::atoi(argv[4]);
+
+		return runBatch(argv[2], argv[3], numThreads);
+	}
+
 	if (argc < 9) {
-		std::cout << "Usage: inputFile DH_CORRECTION(number) OF_CORRECTION(number) VS_CORRECTION(number), DrivingVoltage(kV) TotalLength(cm) EffectiveLength(cm) uEOF(U)\n";
+		std::cout << "Usage: inputFile DH_CORRECTION(number) OF_CORRECTION(number) VS_CORRECTION(number), DrivingVoltage(kV) TotalLength(cm) EffectiveLength(cm) uEOF(U)\n"
+			  << "       --batch manifestFile outputDirectory [numberOfThreads]\n";
 		return EXIT_FAILURE;
 	}
 
@@ -215,7 +101,7 @@ int launch(int argc, char **argv)
 	}
 
 	ltRet = ECHMET::LEMNG::makeCZESystem(inputDesc.BGEComposition, inputDesc.SampleComposition, czeSystem);
-	if (ltRet != ECHMET::LEMNG::OK) {
+	if (ltRet != ECHMET::LEMNG::RetCode::OK) {
 		std::cerr << "Cannot create CZESystem" << std::endl;
 		ECHMET::SysComp::releaseInputData(inputDesc.BGEComposition);
 		ECHMET::SysComp::releaseInputData(inputDesc.SampleComposition);
@@ -240,7 +126,7 @@ int launch(int argc, char **argv)
 	ECHMET::LEMNG::InAnalyticalConcentrationsMap *acBGEMap;
 	ECHMET::LEMNG::InAnalyticalConcentrationsMap *acFullMap;
 
-	if (czeSystem->makeAnalyticalConcentrationsMaps(acBGEMap, acFullMap) != ECHMET::LEMNG::OK) {
+	if (czeSystem->makeAnalyticalConcentrationsMaps(acBGEMap, acFullMap) != ECHMET::LEMNG::RetCode::OK) {
 		std::cerr << "Failed to get analytical concentration maps" << std::endl;
 		return EXIT_FAILURE;
 	}
@@ -250,19 +136,19 @@ int launch(int argc, char **argv)
 
 	ECHMET::NonidealityCorrections corrections = ECHMET::defaultNonidealityCorrections();
 	if (correctForDH)
-		ECHMET::nonidealityCorrectionSet(corrections, ECHMET::CORR_DEBYE_HUCKEL);
+		ECHMET::nonidealityCorrectionSet(corrections, ECHMET::NonidealityCorrectionsItems::CORR_DEBYE_HUCKEL);
 	if (correctForOF)
-		ECHMET::nonidealityCorrectionSet(corrections, ECHMET::CORR_ONSAGER_FUOSS);
+		ECHMET::nonidealityCorrectionSet(corrections, ECHMET::NonidealityCorrectionsItems::CORR_ONSAGER_FUOSS);
 	if (correctForVS)
-		ECHMET::nonidealityCorrectionSet(corrections, ECHMET::CORR_VISCOSITY);
+		ECHMET::nonidealityCorrectionSet(corrections, ECHMET::NonidealityCorrectionsItems::CORR_VISCOSITY);
 
 	ECHMET::LEMNG::Results results;
 	ECHMET::LEMNG::RetCode tRet = czeSystem->evaluate(acBGEMap, acFullMap, corrections, results);
 
-	if (tRet != ECHMET::LEMNG::OK)
+	if (tRet != ECHMET::LEMNG::RetCode::OK)
 		std::cout << "Failed to solve the system: " << czeSystem->lastErrorString() << "\n";
 	else
-		printResults(results, drivingVoltage, totalLength, effectiveLength, uEOF, inputDesc.SampleConcentrations);
+		printResults(std::cout, "efgplots.csv", results, drivingVoltage, totalLength, effectiveLength, uEOF, inputDesc.SampleConcentrations);
 
 	printTrace();
 
@@ -0,0 +1,144 @@
+#include "ref_tool_common.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+/*
+ * Formats a value the same way as printf("%.11g") does
+ */
+static
+std::string fmt11(const double v)
+{
+	char buf[64];
+
+	snprintf(buf, sizeof(buf), "%.11g", v);
+	return std::string(buf);
+}
+
+void printComposition(std::ostream &out, ECHMET::LEMNG::RConstituentMap *composition) {
+	ECHMET::LEMNG::RConstituentMap::Iterator *it = composition->begin();
+	if (it == NULL) {
+		std::cerr << "Cannot get iterator";
+		return;
+	}
+
+	while (it->hasNext()) {
+		const ECHMET::LEMNG::RConstituent &ctuent = it->value();
+
+		out << "- " << ctuent.name->c_str() << " " << ctuent.concentration << "\n";
+		ECHMET::LEMNG::RFormMap::Iterator *fit = ctuent.forms->begin(); /* Here should be a nullptr check */
+		while (fit->hasNext()) {
+			const ECHMET::LEMNG::RForm &rForm = fit->value();
+
+			out << "\t";
+
+			for (size_t jdx = 0; jdx < rForm.ions->size(); jdx++) {
+				const ECHMET::LEMNG::RIon &ion = rForm.ions->at(jdx);
+
+				out << ion.name->c_str() << "(" << ion.charge << ")" << "[" << ion.count << "]";
+			}
+			out << ": " << rForm.concentration << "\n";
+
+			fit->next();
+		}
+		fit->destroy();
+		it->next();
+
+	}
+	it->destroy();
+	out << "\n";
+}
+
+void printProperties(std::ostream &out, const ECHMET::LEMNG::RSolutionProperties &properties, const bool printBufCap)
+{
+	out << "pH: " << fmt11(properties.pH) << "\n";
+	out << "conductivity: " << fmt11(properties.conductivity) << "\n";
+	out << "ionic strength: " << fmt11(properties.ionicStrength) << "\n";
+	if (printBufCap)
+		out << "buffer capacity: " << fmt11(properties.bufferCapacity) << "\n";
+
+	printComposition(out, properties.composition);
+}
+
+const char * ezType(const ECHMET::LEMNG::EigenzoneType ezType)
+{
+	if (ezType == ECHMET::LEMNG::EigenzoneType::ANALYTE)
+		return "(ANALYTE)";
+	return "(SYSTEM)";
+}
+
+void printResults(std::ostream &out, const char *efgPlotsPath, const ECHMET::LEMNG::Results &results, const double drivingVoltage, const double totalLength, const double effectiveLength, const double uEOF, const std::map<std::string, double> &aMap)
+{
+	out << "*** BGE PROPERTIES ***\n";
+	printProperties(out, results.BGEProperties, true);
+
+
+	for (size_t idx = 0; idx < results.eigenzones->size(); idx++) {
+		const ECHMET::LEMNG::REigenzone &ez = results.eigenzones->at(idx);
+
+		out << "*** EIGENZONE " << idx << " "
+			<< ezType(ez.ztype)
+			<< (ez.tainted ? " (TAINTED)" : "") << " ***\n";
+		out << "mobility: " << fmt11(ez.mobility) << "\n";
+		out << "a2t: " << ez.a2t << "\n";
+		out << "uEMD: " << fmt11(ez.uEMD) << "\n";
+
+		printProperties(out, ez.solutionProperties);
+	}
+
+	out << "--- Plotting EFG ---\n";
+
+	std::vector<double> times;
+	std::vector<std::vector<double> > signals;
+
+	out << "* Conductivity *\n";
+	ECHMET::LEMNG::EFGPairVec *electrophoregram;
+	ECHMET::LEMNG::RetCode tRet = plotElectrophoregram(electrophoregram, results, drivingVoltage, totalLength, effectiveLength, uEOF, 0.001, ECHMET::LEMNG::EFGResponseType::RESP_CONDUCTIVITY);
+	if (tRet != ECHMET::LEMNG::RetCode::OK) {
+		out << " Cannot plot EFG " << LEMNGerrorToString(tRet) << std::endl;
+		return;
+	}
+
+	for (size_t idx = 0; idx < electrophoregram->size(); idx++) {
+		const ECHMET::LEMNG::EFGPair &p = electrophoregram->at(idx);
+		//std::cout << p.time << "; " << p.value << "\n";
+
+		times.push_back(p.time);
+		signals.push_back(std::vector<double>(p.value));
+	}
+	electrophoregram->destroy();
+
+	for (std::map<std::string, double>::const_iterator cit = aMap.begin(); cit != aMap.end(); cit++) {
+		const char *key = cit->first.c_str();
+
+		out << "* " << key << " *\n";
+
+		plotElectrophoregram(electrophoregram, results, drivingVoltage, totalLength, effectiveLength, uEOF, 0.001, ECHMET::LEMNG::EFGResponseType::RESP_CONCENTRATION, key);
+
+		for (size_t idx = 0; idx < electrophoregram->size(); idx++) {
+			const ECHMET::LEMNG::EFGPair &p = electrophoregram->at(idx);
+			signals[idx].push_back(p.value);
+			//std::cout << p.time << "; " << p.value << "\n";
+		}
+		electrophoregram->destroy();
+	}
+
+
+	std::ofstream efgPlots(efgPlotsPath);
+	for (size_t idx = 0; idx < times.size(); idx++) {
+		efgPlots << times.at(idx) << "; ";
+
+		const std::vector<double> &sig = signals.at(idx);
+		for (size_t jdx = 0; jdx < sig.size(); jdx++) {
+			efgPlots << sig.at(jdx) << "; ";
+		}
+		efgPlots << "\n";
+	}
+}
+
+void applyConcentrations(ECHMET::LEMNG::InAnalyticalConcentrationsMap *acMap, const std::map<std::string, double> &rdAcMap)
+{
+	for (std::map<std::string, double>::const_iterator cit = rdAcMap.begin(); cit != rdAcMap.end(); cit++)
+		acMap->item(cit->first.c_str()) = cit->second;
+}
@@ -0,0 +1,15 @@
+#ifndef REF_TOOL_COMMON_H
+#define REF_TOOL_COMMON_H
+
+#include <lemng.h>
+#include <map>
+#include <ostream>
+#include <string>
+
+void applyConcentrations(ECHMET::LEMNG::InAnalyticalConcentrationsMap *acMap, const std::map<std::string, double> &rdAcMap);
+const char * ezType(const ECHMET::LEMNG::EigenzoneType ezType);
+void printComposition(std::ostream &out, ECHMET::LEMNG::RConstituentMap *composition);
+void printProperties(std::ostream &out, const ECHMET::LEMNG::RSolutionProperties &properties, const bool printBufCap = false);
+void printResults(std::ostream &out, const char *efgPlotsPath, const ECHMET::LEMNG::Results &results, const double drivingVoltage, const double totalLength, const double effectiveLength, const double uEOF, const std::map<std::string, double> &aMap);
+
+#endif // REF_TOOL_COMMON_H
@@ -0,0 +1,88 @@
+#include "response_cache.h"
+#include <new>
+
+ResponseCache::ResponseCache(const size_t capacity) :
+	m_capacity(capacity),
+	m_size(0)
+{
+}
+
+std::string ResponseCache::get(const std::string &key, const Compute &compute)
+{
+	std::promise<std::string> promise;
+
+	{
+		std::unique_lock<std::mutex> lk(m_lock);
+
+		std::unordered_map<std::string, LRUList::iterator>::const_iterator it = m_index.find(key);
+		if (it != m_index.end()) {
+			m_lru.splice(m_lru.begin(), m_lru, it->second);
+			return it->second->second;
+		}
+
+		std::unordered_map<std::string, std::shared_future<std::string>>::const_iterator ifIt = m_inFlight.find(key);
+		if (ifIt != m_inFlight.end()) {
+			std::shared_future<std::string> pending = ifIt->second;
+
+			lk.unlock();
+			return pending.get();
+		}
+
+		m_inFlight.emplace(key, promise.get_future().share());
+	}
+
+	/* This request is the first of its kind, compute it without holding the lock */
+	std::string response;
+	bool cacheable = true;
+	try {
+		response = compute(cacheable);
+	} catch (...) {
+		std::lock_guard<std::mutex> lk(m_lock);
+
+		promise.set_exception(std::current_exception());
+		m_inFlight.erase(key);
+		throw;
+	}
+
+	std::lock_guard<std::mutex> lk(m_lock);
+
+	promise.set_value(response);
+	m_inFlight.erase(key);
+	if (cacheable) {
+		/* Failing to cache the response is not an error */
+		try {
+			insert(key, response);
+		} catch (std::bad_alloc &) { }
+	}
+
+	return response;
+}
+
+void ResponseCache::insert(const std::string &key, const std::string &response)
+{
+	const size_t size = key.size() + response.size();
+	if (size > m_capacity)
+		return;
+
+	m_lru.emplace_front(key, response);
+	try {
+		m_index.emplace(key, m_lru.begin());
+	} catch (std::bad_alloc &) {
+		m_lru.pop_front();
+		throw;
+	}
+	m_size += size;
+
+	trim();
+}
+
+void ResponseCache::trim()
+{
+	while (m_size > m_capacity) {
+		const LRUList::value_type &last = m_lru.back();
+
+		m_size -= last.first.size() + last.second.size();
+		m_index.erase(last.first);
+		m_lru.pop_back();
+	}
+}
@@ -0,0 +1,46 @@
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <functional>
+#include <future>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/*
+ * Size-bounded LRU cache of responses of lemng_server.
+ *
+ * The key shall identify everything the response depends on, i.e. the canonical
+ * composition, the concentrations, the nonideality corrections and the parameters
+ * of the electrophoregram, so that equal keys always produce identical responses.
+ * Concurrent requests with equal keys are coalesced, only the first one is computed
+ * and the others wait for its response.
+ */
+class ResponseCache {
+public:
+	/*
+	 * Computes the response to a request. Sets cacheable to false
+	 * if the response must not be stored, e.g. because it reports an error.
+	 */
+	typedef std::function<std::string (bool &cacheable)> Compute;
+
+	explicit ResponseCache(const size_t capacity);
+
+	std::string get(const std::string &key, const Compute &compute);
+
+private:
+	typedef std::list<std::pair<std::string, std::string>> LRUList;
+
+	void insert(const std::string &request, const std::string &response);
+	void trim();
+
+	const size_t m_capacity;					/* Maximum total size of cached keys and responses in bytes */
+	size_t m_size;
+	LRUList m_lru;							/* Most recently used entry is at the front */
+	std::unordered_map<std::string, LRUList::iterator> m_index;
+	std::unordered_map<std::string, std::shared_future<std::string>> m_inFlight;
+	std::mutex m_lock;
+};
+
+#endif // RESPONSE_CACHE_H
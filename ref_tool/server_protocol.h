@@ -0,0 +1,247 @@
+#ifndef SERVER_PROTOCOL_H
+#define SERVER_PROTOCOL_H
+
+/*
+ * Framed protocol spoken by lemng_server over a Unix domain socket.
+ *
+ * Each message is sent as a frame that consists of a uint32_t length of the payload
+ * followed by the payload itself. The payload starts with a uint32_t message type.
+ * All values are stored in the native byte order as both ends run on the same machine.
+ * Strings are stored as uint32_t length followed by the characters without the terminating zero.
+ *
+ * MSG_EVALUATE (client -> server)
+ *   string   path to the JSON input file
+ *   int32_t  corrections (CORRECTION_* flags)
+ *   double   driving voltage (V)
+ *   double   total length of the capillary (m)
+ *   double   effective length of the capillary (m)
+ *   double   mobility of EOF
+ *   int32_t  nonzero if the conductivity electrophoregram shall be plotted
+ *
+ * MSG_RESULTS (server -> client)
+ *   double   pH, conductivity, ionic strength and buffer capacity of the BGE
+ *   uint32_t number of eigenzones followed by
+ *            int32_t type (LEMNG::EigenzoneType), int32_t tainted, double mobility, double uEMD, double a2t of each zone
+ *   uint32_t number of electrophoregram points followed by
+ *            double time, double value of each point
+ *
+ * MSG_ERROR (server -> client)
+ *   int32_t  LEMNG error code, E_INVALID_ARGUMENT for malformed or unknown requests and unreadable input files,
+ *            E_INTERNAL_ERROR for failures of the server itself
+ *   string   description of the error
+ *
+ * Requests on one connection are processed in the order they were sent,
+ * each request is answered by exactly one response. Requests for identical systems
+ * with identical concentrations and parameters are answered by identical responses
+ * so the server may answer them from its cache even if they name different input files.
+ * An input file that is modified is parsed again.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <errno.h>
+#include <unistd.h>
+
+namespace ServerProtocol {
+
+enum MessageType {
+	MSG_EVALUATE = 0x01,
+	MSG_RESULTS = 0x81,
+	MSG_ERROR = 0x82
+};
+
+enum Corrections {
+	CORRECTION_DEBYE_HUCKEL = 0x1,
+	CORRECTION_ONSAGER_FUOSS = 0x2,
+	CORRECTION_VISCOSITY = 0x4
+};
+
+static const uint32_t MAX_FRAME_SIZE = 64 * 1024 * 1024;	/* Guards against garbage on the socket */
+
+class MalformedMessage : public std::runtime_error {
+public:
+	MalformedMessage() :
+		std::runtime_error("Malformed message")
+	{}
+};
+
+class MessageWriter {
+public:
+	explicit MessageWriter(const MessageType type)
+	{
+		put(static_cast<uint32_t>(type));
+	}
+
+	const std::string & data() const
+	{
+		return m_data;
+	}
+
+	void put(const double v)
+	{
+		putRaw(&v, sizeof(v));
+	}
+
+	void put(const int32_t v)
+	{
+		putRaw(&v, sizeof(v));
+	}
+
+	void put(const uint32_t v)
+	{
+		putRaw(&v, sizeof(v));
+	}
+
+	void put(const std::string &s)
+	{
+		put(static_cast<uint32_t>(s.size()));
+		m_data.append(s);
+	}
+
+private:
+	void putRaw(const void *data, const size_t size)
+	{
+		m_data.append(static_cast<const char *>(data), size);
+	}
+
+	std::string m_data;
+};
+
+class MessageReader {
+public:
+	explicit MessageReader(const std::string &data) :
+		m_data(data),
+		m_pos(0)
+	{
+		m_type = static_cast<MessageType>(getUInt32());
+	}
+
+	MessageType type() const
+	{
+		return m_type;
+	}
+
+	double getDouble()
+	{
+		double v;
+		getRaw(&v, sizeof(v));
+		return v;
+	}
+
+	int32_t getInt32()
+	{
+		int32_t v;
+		getRaw(&v, sizeof(v));
+		return v;
+	}
+
+	uint32_t getUInt32()
+	{
+		uint32_t v;
+		getRaw(&v, sizeof(v));
+		return v;
+	}
+
+	std::string getString()
+	{
+		const uint32_t len = getUInt32();
+		if (len > m_data.size() - m_pos)
+			throw MalformedMessage();
+
+		const std::string s = m_data.substr(m_pos, len);
+		m_pos += len;
+
+		return s;
+	}
+
+private:
+	void getRaw(void *data, const size_t size)
+	{
+		if (size > m_data.size() - m_pos)
+			throw MalformedMessage();
+
+		std::memcpy(data, m_data.data() + m_pos, size);
+		m_pos += size;
+	}
+
+	const std::string &m_data;
+	size_t m_pos;
+	MessageType m_type;
+};
+
+inline
+bool readAll(const int fd, char *data, size_t size)
+{
+	while (size > 0) {
+		const ssize_t n = ::read(fd, data, size);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+
+		data += n;
+		size -= n;
+	}
+
+	return true;
+}
+
+inline
+bool writeAll(const int fd, const char *data, size_t size)
+{
+	while (size > 0) {
+		const ssize_t n = ::write(fd, data, size);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+
+		data += n;
+		size -= n;
+	}
+
+	return true;
+}
+
+/*
+ * Returns false if the connection was closed or the frame is too large
+ */
+inline
+bool readFrame(const int fd, std::string &payload)
+{
+	uint32_t size;
+
+	if (!readAll(fd, reinterpret_cast<char *>(&size), sizeof(size)))
+		return false;
+	if (size > MAX_FRAME_SIZE)
+		return false;
+
+	payload.resize(size);
+	if (size == 0)
+		return true;
+
+	return readAll(fd, &payload[0], size);
+}
+
+inline
+bool writeFrame(const int fd, const std::string &payload)
+{
+	const uint32_t size = payload.size();
+
+	if (!writeAll(fd, reinterpret_cast<const char *>(&size), sizeof(size)))
+		return false;
+
+	return writeAll(fd, payload.data(), size);
+}
+
+inline
+bool writeFrame(const int fd, const MessageWriter &msg)
+{
+	return writeFrame(fd, msg.data());
+}
+
+} // namespace ServerProtocol
+
+#endif // SERVER_PROTOCOL_H
@@ -0,0 +1,365 @@
+#include "lemng_p.h"
+#include "calculator_common.h"
+#include "calculator_linear.h"
+#include "calculator_nonlinear.h"
+#include "helpers.h"
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <new>
+
+#define USE_ECHMET_CONTAINERS
+#include <containers/echmetskmap_p.h>
+
+namespace ECHMET {
+namespace LEMNG {
+
+static const size_t OPTIMIZER_CANDIDATES = 4;		/*!< Number of step lengths tried in each iteration. Each candidate halves the step of the previous one */
+static const double OPTIMIZER_INITIAL_STEP = 0.25;	/*!< Initial step length relative to the width of the bounds */
+static const double OPTIMIZER_MINIMUM_STEP = 1.0e-4;	/*!< Search stops once the step length drops below this value */
+
+static
+const MutSKMapImpl<double>::STLMap & concentrationsSTL(const InAnalyticalConcentrationsMapPtr &acMap)
+{
+	return static_cast<const MutSKMapImpl<double> *>(acMap.get())->STL();
+}
+
+/*!
+ * Objective at one composition of the BGE. The gradient is filled in only for accepted compositions.
+ */
+class ObjectiveEvaluation {
+public:
+	RetCode status;
+	double value;
+	size_t first;			/*!< Index of the first eigenzone of the closest pair */
+	size_t second;			/*!< Index of the second eigenzone of the closest pair */
+	std::vector<double> gradient;	/*!< Derivatives of \p value by the concentrations of the optimized constituents */
+};
+
+/*!
+ * System that evaluates the candidate compositions together with its own copy of the BGE composition.
+ */
+class CandidateEvaluator {
+public:
+	CZESystemImpl *system;
+	InAnalyticalConcentrationsMapPtr acBGE;
+	std::vector<double> solvedPoint;	/*!< Composition whose solution the system currently holds, empty if none */
+};
+
+/*!
+ * Evaluates the objective from the linear model only. Ranking of the candidates
+ * needs nothing else, the expensive derivatives are left to \p objectiveGradient().
+ */
+RetCode CZESystemImpl::evaluateObjective(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acSample,
+					 const NonidealityCorrections corrections, const int32_t objective,
+					 double &value, size_t &first, size_t &second) noexcept
+{
+	static const int32_t ANALYTE_SEPARATION = static_cast<int32_t>(OptimizationObjective::OPT_ANALYTE_SEPARATION);
+	static const int32_t SYSTEM_ZONE_SEPARATION = static_cast<int32_t>(OptimizationObjective::OPT_SYSTEM_ZONE_SEPARATION);
+
+	RetCode tRet = setInput(acBGE, acSample, corrections);
+	if (tRet != RetCode::OK)
+		return tRet;
+
+	try {
+		const Calculator::LinearModel &linModel = linearModel();
+		const Calculator::ZoneCompositionVec &compositions = zoneCompositions();
+
+		bool found = false;
+		double closest = std::numeric_limits<double>::infinity();
+
+		for (size_t idx = 0; idx < compositions.size(); idx++) {
+			if (!compositions.at(idx).isAnalyteZone)
+				continue;
+
+			for (size_t jdx = 0; jdx < compositions.size(); jdx++) {
+				if (compositions.at(jdx).isAnalyteZone) {
+					/* Count each pair of analytes only once */
+					if (!(objective & ANALYTE_SEPARATION) || jdx <= idx)
+						continue;
+				} else if (!(objective & SYSTEM_ZONE_SEPARATION))
+					continue;
+
+				const double diff = std::abs(linModel.eigenmobilities(idx).real() - linModel.eigenmobilities(jdx).real());
+				if (diff < closest) {
+					closest = diff;
+					first = idx;
+					second = jdx;
+					found = true;
+				}
+			}
+		}
+
+		if (!found) {
+			m_lastErrorString = "System has no pair of eigenzones to separate";
+
+			return RetCode::E_INVALID_ARGUMENT;
+		}
+
+		value = closest;
+	} catch (std::bad_alloc &) {
+		m_lastErrorString = "Insufficient memory to evaluate optimization objective";
+
+		return RetCode::E_NO_MEMORY;
+	} catch (Calculator::CalculationException &ex) {
+		m_lastErrorString = ex.what();
+
+		return ex.errorCode();
+	}
+
+	return RetCode::OK;
+}
+
+/*!
+ * Calculates the gradient of the objective at the composition evaluated last by \p evaluateObjective().
+ * The gradient of the closest pair of eigenzones is a subgradient of the objective.
+ */
+RetCode CZESystemImpl::objectiveGradient(const std::vector<size_t> &columns, const size_t first, const size_t second, std::vector<double> &gradient) noexcept
+{
+	try {
+		const Calculator::LinearModel &linModel = linearModel();
+		const Calculator::DispersionModel &dispModel = dispersionModel();
+
+		const double sgn = Calculator::cxsgn(linModel.eigenmobilities(first).real() - linModel.eigenmobilities(second).real());
+
+		gradient.resize(columns.size());
+		for (size_t idx = 0; idx < columns.size(); idx++)
+			gradient[idx] = sgn * (dispModel.dLdC(first, columns[idx]) - dispModel.dLdC(second, columns[idx]));
+	} catch (std::bad_alloc &) {
+		m_lastErrorString = "Insufficient memory to evaluate gradient of optimization objective";
+
+		return RetCode::E_NO_MEMORY;
+	} catch (Calculator::CalculationException &ex) {
+		m_lastErrorString = ex.what();
+
+		return ex.errorCode();
+	}
+
+	return RetCode::OK;
+}
+
+RetCode ECHMET_CC CZESystemImpl::optimizeBGE(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acFull,
+					     const InAnalyticalConcentrationsMap *lowerBounds, const InAnalyticalConcentrationsMap *upperBounds,
+					     const int32_t objective, const NonidealityCorrections corrections, const int32_t maxIterations,
+					     InAnalyticalConcentrationsMap *acBGEOptimum, double &objectiveValue) noexcept
+{
+	static const int32_t ALL_OBJECTIVES = static_cast<int32_t>(OptimizationObjective::OPT_ANALYTE_SEPARATION) |
+					      static_cast<int32_t>(OptimizationObjective::OPT_SYSTEM_ZONE_SEPARATION);
+
+	typedef std::vector<double> Point;
+
+	if (acBGE == nullptr || acFull == nullptr || lowerBounds == nullptr || upperBounds == nullptr || acBGEOptimum == nullptr || maxIterations < 1) {
+		m_lastErrorString = "Invalid optimization parameters";
+		return RetCode::E_INVALID_ARGUMENT;
+	}
+
+	if (objective == 0 || (objective & ~ALL_OBJECTIVES)) {
+		m_lastErrorString = "Invalid optimization objective";
+		return RetCode::E_INVALID_ARGUMENT;
+	}
+
+	std::vector<std::string> names{};
+	std::vector<size_t> columns{};
+	Point lower{};
+	Point width{};
+	Point current{};
+
+	std::vector<CandidateEvaluator> evaluators{};
+	std::vector<std::unique_ptr<CZESystemImpl>> workers{};
+
+	auto fail = [this](RetCode tRet) {
+		m_warmStart = false;
+		return tRet;
+	};
+
+	try {
+		InAnalyticalConcentrationsMapPtr lowerCopy = copyConcentrationsMap(lowerBounds);
+
+		for (const auto &item : concentrationsSTL(lowerCopy)) {
+			const std::string &name = item.first;
+			double upper;
+
+			if (upperBounds->at(upper, name.c_str()) != ::ECHMET::RetCode::OK)
+				continue;
+
+			const double low = std::max(item.second, minimumSafeConcentration());
+			if (upper <= low)
+				continue;
+
+			if (!acBGE->contains(name.c_str())) {
+				m_lastErrorString = "Optimized constituent " + name + " is not present in the background electrolyte";
+				return RetCode::E_INVALID_ARGUMENT;
+			}
+
+			auto it = std::find_if(m_systemPack.constituents.cbegin(), m_systemPack.constituents.cend(),
+					       [&name](const Calculator::CalculatorConstituent &cc) { return !cc.isAnalyte && cc.name == name; });
+			if (it == m_systemPack.constituents.cend()) {
+				m_lastErrorString = "Optimized constituent " + name + " is not a constituent of the background electrolyte";
+				return RetCode::E_INVALID_ARGUMENT;
+			}
+
+			names.emplace_back(name);
+			columns.emplace_back(it - m_systemPack.constituents.cbegin());
+			lower.emplace_back(low);
+			width.emplace_back(upper - low);
+			current.emplace_back(std::min(std::max((*acBGE)[name.c_str()], low), upper));
+		}
+
+		if (names.empty()) {
+			m_lastErrorString = "No constituent has valid bounds";
+			return RetCode::E_INVALID_ARGUMENT;
+		}
+
+		evaluators.emplace_back(CandidateEvaluator{this, copyConcentrationsMap(acBGE), {}});
+#ifdef ECHMET_LEMNG_PARALLEL_NUM_OPS
+		/* Each candidate gets its own system so that the candidates can be solved concurrently */
+		for (size_t idx = 1; idx < OPTIMIZER_CANDIDATES; idx++) {
+			workers.emplace_back(std::unique_ptr<CZESystemImpl>{new CZESystemImpl{m_prepared}});
+			evaluators.emplace_back(CandidateEvaluator{workers.back().get(), copyConcentrationsMap(acBGE), {}});
+		}
+#endif // ECHMET_LEMNG_PARALLEL_NUM_OPS
+	} catch (std::bad_alloc &) {
+		m_lastErrorString = "Insufficient memory to prepare optimization";
+		return RetCode::E_NO_MEMORY;
+	}
+
+	auto evaluate = [&](CandidateEvaluator &ev, const Point &pt) {
+		ObjectiveEvaluation result{RetCode::OK, 0.0, 0, 0, {}};
+
+		for (size_t idx = 0; idx < names.size(); idx++)
+			ev.acBGE->item(names[idx].c_str()) = pt[idx];
+
+		ev.solvedPoint.clear();
+		result.status = ev.system->evaluateObjective(ev.acBGE.get(), acFull, corrections, objective, result.value, result.first, result.second);
+		/* Candidates of the subsequent iterations lie close to the last solved one */
+		if (result.status == RetCode::OK) {
+			ev.system->m_warmStart = true;
+			ev.solvedPoint = pt;
+		}
+
+		return result;
+	};
+
+	/* Only the accepted composition needs the gradient. The system that evaluated it still holds
+	 * its solution unless it has evaluated another candidate since, the composition is solved again
+	 * only in such a case. */
+	auto acceptGradient = [&](CandidateEvaluator &ev, const Point &pt, ObjectiveEvaluation &accepted) {
+		if (ev.solvedPoint != pt) {
+			const ObjectiveEvaluation again = evaluate(ev, pt);
+			if (again.status != RetCode::OK)
+				return again.status;
+		}
+
+		return ev.system->objectiveGradient(columns, accepted.first, accepted.second, accepted.gradient);
+	};
+
+	try {
+		ObjectiveEvaluation best = evaluate(evaluators.front(), current);
+		if (best.status != RetCode::OK)
+			return fail(best.status);
+
+		RetCode tRet = acceptGradient(evaluators.front(), current, best);
+		if (tRet != RetCode::OK)
+			return fail(tRet);
+
+		double step = OPTIMIZER_INITIAL_STEP;
+
+		for (int32_t iter = 0; iter < maxIterations && step >= OPTIMIZER_MINIMUM_STEP; iter++) {
+			/* Ascent direction in coordinates scaled by the widths of the bounds */
+			Point direction(names.size());
+			double norm = 0.0;
+			for (size_t idx = 0; idx < names.size(); idx++) {
+				direction[idx] = best.gradient[idx] * width[idx];
+				norm = std::max(norm, std::abs(direction[idx]));
+			}
+
+			if (norm == 0.0)
+				break;
+
+			std::vector<Point> candidates{};
+			std::vector<double> steps{};
+			for (size_t cdx = 0; cdx < OPTIMIZER_CANDIDATES; cdx++) {
+				const double t = step / (1 << cdx);
+				Point pt(names.size());
+
+				for (size_t idx = 0; idx < names.size(); idx++) {
+					const double c = current[idx] + t * direction[idx] / norm * width[idx];
+					pt[idx] = std::min(std::max(c, lower[idx]), lower[idx] + width[idx]);
+				}
+
+				candidates.emplace_back(std::move(pt));
+				steps.emplace_back(t);
+			}
+
+			std::vector<ObjectiveEvaluation> evaluated(candidates.size());
+#ifdef ECHMET_LEMNG_PARALLEL_NUM_OPS
+			std::vector<std::future<ObjectiveEvaluation>> futures(candidates.size());
+
+			for (size_t cdx = 0; cdx < candidates.size(); cdx++)
+				futures[cdx] = std::async(std::launch::async, evaluate, std::ref(evaluators[cdx]), std::cref(candidates[cdx]));
+
+			for (size_t cdx = 0; cdx < candidates.size(); cdx++)
+				evaluated[cdx] = futures[cdx].get();
+#else // ECHMET_LEMNG_PARALLEL_NUM_OPS
+			for (size_t cdx = 0; cdx < candidates.size(); cdx++)
+				evaluated[cdx] = evaluate(evaluators.front(), candidates[cdx]);
+#endif // ECHMET_LEMNG_PARALLEL_NUM_OPS
+
+			bool improved = false;
+			size_t bestCandidate = 0;
+			double bestValue = best.value;
+
+			for (size_t cdx = 0; cdx < candidates.size(); cdx++) {
+				const ObjectiveEvaluation &ev = evaluated[cdx];
+				if (ev.status == RetCode::E_NO_MEMORY)
+					throw std::bad_alloc{};
+
+				if (ev.status == RetCode::OK && ev.value > bestValue) {
+					bestValue = ev.value;
+					bestCandidate = cdx;
+					improved = true;
+				}
+			}
+
+			if (improved) {
+#ifdef ECHMET_LEMNG_PARALLEL_NUM_OPS
+				CandidateEvaluator &ev = evaluators[bestCandidate];
+#else
+				CandidateEvaluator &ev = evaluators.front();
+#endif // ECHMET_LEMNG_PARALLEL_NUM_OPS
+				ObjectiveEvaluation accepted = evaluated[bestCandidate];
+
+				/* A candidate whose gradient cannot be calculated ends the search at the last accepted point */
+				tRet = acceptGradient(ev, candidates[bestCandidate], accepted);
+				if (tRet == RetCode::E_NO_MEMORY)
+					throw std::bad_alloc{};
+				if (tRet != RetCode::OK)
+					break;
+
+				best = std::move(accepted);
+				current = candidates[bestCandidate];
+				step = std::min(1.0, 2.0 * steps[bestCandidate]);
+			} else
+				step = steps.back() / 2.0;
+		}
+
+		for (const auto &item : concentrationsSTL(evaluators.front().acBGE))
+			acBGEOptimum->item(item.first.c_str()) = item.second;
+		for (size_t idx = 0; idx < names.size(); idx++)
+			acBGEOptimum->item(names[idx].c_str()) = current[idx];
+
+		objectiveValue = best.value;
+	} catch (std::bad_alloc &) {
+		m_lastErrorString = "Insufficient memory to perform the optimization";
+
+		return fail(RetCode::E_NO_MEMORY);
+	}
+
+	m_warmStart = false;
+
+	return RetCode::OK;
+}
+
+} // namespace LEMNG
+} // namespace ECHMET
@@ -1,9 +1,11 @@
 #include "calculator_common.h"
 #include "helpers.h"
 #include <vector>
+#include <algorithm>
 #include <cassert>
 #include <iterator>
 #include <future>
+#include <unordered_map>
 
 #include "tracing/lemng_tracer_impl.h"
 #include <sstream>
@@ -45,17 +47,49 @@ const char * CalculationException::what() const noexcept
 static
 void buildSystemPackVectors(CalculatorConstituentVec &ccVec, CalculatorIonicFormVec &ifVec, const std::vector<const SysComp::Constituent *> &allConstituents,
 			    const SysComp::IonicForm *internalIFH3O, const SysComp::IonicForm *internalIFOH,
-			    const std::function<bool (const std::string &)> &isAnalyte,
-			    const bool includeUncharged)
+			    const std::function<bool (const std::string &)> &isAnalyte)
 {
+	/* Lookup tables are built once so that the construction
+	 * scales linearly with the size of the system */
+	std::unordered_map<std::string, CalculatorIonicForm *> ifByName{};
+	std::unordered_map<const SysComp::Constituent *, size_t> ctuentIdxByPtr{};
+	std::unordered_map<std::string, size_t> ctuentIdxByName{};
+	std::vector<bool> ctuentsAnalyteState{};
+
+	ifByName.reserve(ifVec.capacity());
+	ctuentIdxByPtr.reserve(allConstituents.size());
+	ctuentIdxByName.reserve(allConstituents.size());
+	ctuentsAnalyteState.reserve(allConstituents.size());
 
-	auto findInIfVec = [&ifVec](const char *name) -> CalculatorIonicForm * {
-		const std::string _name{name};
+	for (size_t idx = 0; idx < allConstituents.size(); idx++) {
+		const SysComp::Constituent *c = allConstituents.at(idx);
+		std::string name{c->name->c_str()};
+
+		ctuentsAnalyteState.emplace_back(isAnalyte(name));
+		ctuentIdxByPtr.emplace(c, idx);
+		ctuentIdxByName.emplace(std::move(name), idx);
+	}
+
+	auto findInIfVec = [&ifByName](const std::string &name) -> CalculatorIonicForm * {
+		const auto it = ifByName.find(name);
+
+		if (it == ifByName.cend())
+			return nullptr;
+		return it->second;
+	};
+
+	auto findLigandIdx = [&ctuentIdxByPtr, &ctuentIdxByName](const SysComp::Constituent *c) {
+		/* Ligands are expected to be the same objects as those in the list of constituents.
+		 * Fall back to lookup by name if they are not. */
+		const auto it = ctuentIdxByPtr.find(c);
+		if (it != ctuentIdxByPtr.cend())
+			return it->second;
 
-		for (const auto iF : ifVec)
-			if (iF->name == _name) return iF;
+		const auto nit = ctuentIdxByName.find(c->name->c_str());
+		if (nit != ctuentIdxByName.cend())
+			return nit->second;
 
-		return nullptr;
+		throw CalculationException{"Ligand index not found", RetCode::E_INTERNAL_ERROR};
 	};
 
 	assert(internalIFH3O->ifType == SysComp::IonicFormType::H);
@@ -65,7 +99,7 @@ void buildSystemPackVectors(CalculatorConstituentVec &ccVec, CalculatorIonicForm
 	for (size_t idx = 0; idx < allConstituents.size(); idx++) {
 		const SysComp::Constituent *ctuent = allConstituents.at(idx);
 		CalculatorIonicFormVec locIfVec{};
-		const bool ctuentIsAnalyte = isAnalyte(ctuent->name->c_str());
+		const bool ctuentIsAnalyte = ctuentsAnalyteState[idx];
 
 		locIfVec.reserve(ctuent->ionicForms->size());
 
@@ -73,34 +107,17 @@ void buildSystemPackVectors(CalculatorConstituentVec &ccVec, CalculatorIonicForm
 			const SysComp::IonicForm *iF = ctuent->ionicForms->at(ifIdx);
 			bool iFisAnalyte = ctuentIsAnalyte;
 
-			/* We do not need to represent uncharged ionic forms in the mobility matrices.
-			 * Leaving them out will spare us some unnecessary multiplications.
-			 */
-			if (iF->totalCharge == 0 && !includeUncharged)
-				continue;
-
 			/* We need to build a list of indices of all ligands that are present
 			 * in a given ionic form. This is necessary to have a reasonably efficient
 			 * function to calculate Kroenecker delta in makeMatrixM1().
 			 */
-			auto multiplicities = [&allConstituents, &isAnalyte, &iFisAnalyte](const SysComp::IonicForm *iF) {
-				auto findLigandIdx = [&allConstituents](const SysComp::Constituent *c) {
-					for (size_t idx = 0; idx < allConstituents.size(); idx++) {
-						const SysComp::Constituent *otherC = allConstituents.at(idx);
-
-						if (*(otherC->name) == *c->name)
-							return idx;
-					}
-
-					throw CalculationException{"Ligand index not found", RetCode::E_INTERNAL_ERROR};
-				};
-
+			auto multiplicities = [&findLigandIdx, &ctuentsAnalyteState, &iFisAnalyte](const SysComp::IonicForm *iF) {
 				const SysComp::IonicForm *ancestor = iF;
 				MultiplicityVec muls{};
 
 				while (ancestor->ligand != nullptr) {
 					const size_t idx = findLigandIdx(ancestor->ligand);
-					if (isAnalyte(ancestor->ligand->name->c_str()))
+					if (ctuentsAnalyteState[idx])
 						iFisAnalyte = true;
 
 					muls.emplace_back(idx, ancestor->ligandCount);
@@ -123,7 +140,8 @@ void buildSystemPackVectors(CalculatorConstituentVec &ccVec, CalculatorIonicForm
 			 * we only append it to the local iFs vector.
 			 */
 
-			CalculatorIonicForm *locIF = findInIfVec(iF->name->c_str());
+			std::string iFName{iF->name->c_str()};
+			CalculatorIonicForm *locIF = findInIfVec(iFName);
 			const bool treatAsAnalyte = locIF != nullptr ? locIF->isAnalyte : iFisAnalyte; /* Re-use the "is analyte" state
 													  if the form was added previously.
 													  Beacause of the N->L ordering the
@@ -131,12 +149,13 @@ void buildSystemPackVectors(CalculatorConstituentVec &ccVec, CalculatorIonicForm
 													  correct */
 			if (locIF == nullptr) {
 				try {
-					locIF = new CalculatorIonicForm{std::string{iF->name->c_str()}, iF->totalCharge,
+					locIF = new CalculatorIonicForm{iFName, iF->totalCharge,
 									iF,
 									iF->ionicConcentrationIndex,
 									ifVec.size(), /* This ionic form will be placed at this index in the global ifVec. */
 									std::move(multiplicities), treatAsAnalyte};
 					ifVec.emplace_back(locIF);
+					ifByName.emplace(std::move(iFName), locIF);
 				} catch (std::bad_alloc &) {
 					for (auto &&item : locIfVec)
 						delete item;
@@ -236,7 +255,7 @@ double calculateSolutionBufferCapacity(const SysComp::ChemicalSystem *chemSystem
 }
 
 SolutionProperties calculateSolutionProperties(const SysComp::ChemicalSystem *chemSystem, const RealVecPtr &concentrations, SysComp::CalculatedProperties *calcProps, const NonidealityCorrections corrections,
-					       const bool calcBufferCapacity, const bool useHighPrecision)
+					       const bool calcBufferCapacity, const bool useHighPrecision, const bool warmStart)
 {
 	auto sysCompToLEMNGVec = [](const auto &inVec) {
 		std::vector<double> outVec{};
@@ -248,7 +267,7 @@ SolutionProperties calculateSolutionProperties(const SysComp::ChemicalSystem *ch
 	};
 
 	ECHMET_TRACE(LEMNGTracing, CALC_COMMON_CALC_SOLPROPS_PROGRESS, "Solving equilibrium");
-	solveChemicalSystem(chemSystem, concentrations, calcProps, corrections, useHighPrecision);
+	solveChemicalSystem(chemSystem, concentrations, calcProps, corrections, useHighPrecision, warmStart);
 
 	auto analyticalConcentrations = sysCompToLEMNGVec(concentrations);
 	auto ionicConcentrations = sysCompToLEMNGVec(calcProps->ionicConcentrations);
@@ -269,9 +288,9 @@ SolutionProperties calculateSolutionProperties(const SysComp::ChemicalSystem *ch
 }
 
 SolutionProperties calculateSolutionProperties(const ChemicalSystemPtr &chemSystem, const RealVecPtr &concentrations, CalculatedPropertiesPtr &calcProps, const NonidealityCorrections corrections, const bool calcBufferCapacity,
-					       const bool useHighPrecision)
+					       const bool useHighPrecision, const bool warmStart)
 {
-	return calculateSolutionProperties(chemSystem.get(), concentrations, calcProps.get(), corrections, calcBufferCapacity, useHighPrecision);
+	return calculateSolutionProperties(chemSystem.get(), concentrations, calcProps.get(), corrections, calcBufferCapacity, useHighPrecision, warmStart);
 }
 
 template <>
@@ -302,9 +321,38 @@ bool isComplex<EMVectorC>(const EMVectorC &I)
 	return false;
 }
 
+/*!
+ * Builds the constituent x ionic form matrix of multiplicities from the per-ionic form lists
+ */
+static
+EMSparseMatrix makeMultiplicityMatrix(const size_t NCO, const CalculatorIonicFormVec &ifVec)
+{
+	std::vector<Eigen::Triplet<double>> triplets{};
+
+	for (size_t col = 0; col < ifVec.size(); col++) {
+		const MultiplicityVec &muls = ifVec.at(col)->multiplicities;
+
+		for (auto it = muls.cbegin(); it != muls.cend(); it++) {
+			const size_t row = it->first;
+
+			/* The list may contain the same ligand more than once,
+			 * the first occurrence is the one that counts. */
+			const auto sameRow = [row](const std::pair<size_t, int32_t> &m) { return m.first == row; };
+			if (std::find_if(muls.cbegin(), it, sameRow) != it)
+				continue;
+
+			triplets.emplace_back(row, col, it->second);
+		}
+	}
+
+	EMSparseMatrix M{static_cast<Eigen::Index>(NCO), static_cast<Eigen::Index>(ifVec.size())};
+	M.setFromTriplets(triplets.cbegin(), triplets.cend());
+
+	return M;
+}
+
 CalculatorSystemPack makeSystemPack(const ChemicalSystemPtr &chemSystem, const CalculatedPropertiesPtr &calcProps,
-				    const std::function<bool (const std::string &)> &isAnalyte,
-				    const bool includeUncharged)
+				    const std::function<bool (const std::string &)> &isAnalyte)
 {
 	CalculatorConstituentVec ccVec{};
 	CalculatorIonicFormVec ifVec{};
@@ -318,7 +366,7 @@ CalculatorSystemPack makeSystemPack(const ChemicalSystemPtr &chemSystem, const C
 	try {
 		buildSystemPackVectors(ccVec, ifVec, orderedConstituents,
 				       chemSystem->ionicForms->at(0), chemSystem->ionicForms->at(1),
-				       isAnalyte, includeUncharged);
+				       isAnalyte);
 	} catch (std::bad_alloc &) {
 		for (auto &&item : ifVec)
 			delete item;
@@ -327,7 +375,9 @@ CalculatorSystemPack makeSystemPack(const ChemicalSystemPtr &chemSystem, const C
 	}
 
 	try {
-		return CalculatorSystemPack{std::move(ccVec), std::move(ifVec), chemSystem.get(), calcProps.get()};
+		EMSparseMatrix multiplicities = makeMultiplicityMatrix(ccVec.size(), ifVec);
+
+		return CalculatorSystemPack{std::move(ccVec), std::move(ifVec), std::move(multiplicities), chemSystem.get(), calcProps.get()};
 	} catch (std::bad_alloc &) {
 		for (auto &&item : ifVec)
 			delete item;
@@ -336,50 +386,81 @@ CalculatorSystemPack makeSystemPack(const ChemicalSystemPtr &chemSystem, const C
 	}
 }
 
-void bindSystemPack(CalculatorSystemPack &systemPack, const RealVecPtr &analConcsBGELike, const RealVecPtr &analConcsSample)
+CalculatorSystemPack cloneSystemPack(const CalculatorSystemPack &systemPack, SysComp::CalculatedProperties *calcPropsRaw)
 {
-	const SysComp::ChemicalSystem *chemSystem = systemPack.chemSystemRaw;
-	const SysComp::CalculatedProperties *calcProps = systemPack.calcPropsRaw;
+	CalculatorConstituentVec ccVec{};
+	CalculatorIonicFormVec ifVec{};
 
-	/* Bind ionic forms to state of the fully resolved system */
-	for (size_t idx = 0; idx < systemPack.ionicForms.size() - 2; idx++) {
-		CalculatorIonicForm *iF = systemPack.ionicForms.at(idx);
-		const std::string &name = iF->name;
-		size_t mobilityIdx;
+	ccVec.reserve(systemPack.constituents.size());
+	ifVec.reserve(systemPack.ionicForms.size());
+
+	/* WARNING: Raw pointers inside!
+	 * Position of each ionic form in the global vector is stored in the
+	 * form itself so the per-constituent vectors can be remapped directly. */
+	try {
+		for (const CalculatorIonicForm *iF : systemPack.ionicForms)
+			ifVec.emplace_back(new CalculatorIonicForm{*iF});
 
-		if (chemSystem->ionicMobilitiesByName->at(mobilityIdx, name.c_str()) != ::ECHMET::RetCode::OK)
-			throw CalculationException{"Cannot find ionic form mobility index", RetCode::E_INTERNAL_ERROR};
-		iF->mobility = ECHMETRealToDouble(calcProps->ionicMobilities->at(mobilityIdx));
+		for (const CalculatorConstituent &cc : systemPack.constituents) {
+			CalculatorIonicFormVec locIfVec{};
+			locIfVec.reserve(cc.ionicForms.size());
 
-		if (iF->isAnalyte)
-			iF->concentration = 0.0;
-		else {
-			size_t concentrationIdx;
-			if (chemSystem->ionicConcentrationsByName->at(concentrationIdx, name.c_str()) != ::ECHMET::RetCode::OK)
-				throw CalculationException{"Cannot find ionic form concentration index", RetCode::E_INTERNAL_ERROR};
+			for (const CalculatorIonicForm *iF : cc.ionicForms)
+				locIfVec.emplace_back(ifVec.at(iF->globalIonicFormConcentrationIdx));
 
-			iF->concentration = ECHMETRealToDouble(calcProps->ionicConcentrations->at(concentrationIdx));
+			ccVec.emplace_back(std::string{cc.name}, std::move(locIfVec), cc.internalConstituent, cc.isAnalyte);
 		}
+	} catch (std::bad_alloc &) {
+		for (auto &&item : ifVec)
+			delete item;
+
+		throw;
 	}
 
-	/* H3O+ and OH- are at the end of the vector in LEMNG */
-	const size_t H3O_idx = systemPack.ionicForms.size() - 2;
-	const size_t OH_idx = systemPack.ionicForms.size() - 1;
-	systemPack.ionicForms[H3O_idx]->mobility = ECHMETRealToDouble(calcProps->ionicMobilities->at(0));		/* H3O+ is always on top of the SysComp vector */
-	systemPack.ionicForms[OH_idx]->mobility = ECHMETRealToDouble(calcProps->ionicMobilities->at(1));		/* OH- is always second in the SysComp vector */
-	systemPack.ionicForms[H3O_idx]->concentration = ECHMETRealToDouble(calcProps->ionicConcentrations->at(0));	/* H3O+ is always on top of the SysComp vector */
-	systemPack.ionicForms[OH_idx]->concentration = ECHMETRealToDouble(calcProps->ionicConcentrations->at(1));	/* OH- is always second in the SysComp vector */
+	CalculatorSystemPack clone{std::move(ccVec), std::move(ifVec), EMSparseMatrix{systemPack.multiplicities}, systemPack.chemSystemRaw, calcPropsRaw};
+	clone.ionicFormArrays = systemPack.ionicFormArrays;
+
+	return clone;
+}
+
+void bindSystemPack(CalculatorSystemPack &systemPack, const RealVecPtr &analConcsBGELike, const RealVecPtr &analConcsSample)
+{
+	const SysComp::CalculatedProperties *calcProps = systemPack.calcPropsRaw;
+
+	IonicFormArrays &arrays = systemPack.ionicFormArrays;
+
+	/* Bind ionic forms to state of the fully resolved system.
+	 * H3O+ and OH- are at the end of the vector in LEMNG and their indices
+	 * point to the top of the SysComp vectors. */
+	for (size_t idx = 0; idx < systemPack.ionicForms.size(); idx++) {
+		arrays.mobilities(idx) = ECHMETRealToDouble(calcProps->ionicMobilities->at(arrays.internalMobilityIndices[idx]));
+
+		if (systemPack.ionicForms[idx]->isAnalyte)
+			arrays.concentrations(idx) = 0.0;
+		else
+			arrays.concentrations(idx) = ECHMETRealToDouble(calcProps->ionicConcentrations->at(arrays.internalConcentrationIndices[idx]));
+	}
 
 	/* Bind constituents to analytical concentrations */
 	for (CalculatorConstituent &cc : systemPack.constituents) {
 		const size_t idx = cc.internalConstituent->analyticalConcentrationIndex;
 
-		cc.concentrationSample = analConcsSample->at(idx);
 		if (cc.isAnalyte)
 			cc.concentrationBGE = 0.0;
 		else
 			cc.concentrationBGE = analConcsBGELike->at(idx);
 	}
+
+	bindSampleConcentrations(systemPack, analConcsSample);
+}
+
+void bindSampleConcentrations(CalculatorSystemPack &systemPack, const RealVecPtr &analConcsSample)
+{
+	for (CalculatorConstituent &cc : systemPack.constituents) {
+		const size_t idx = cc.internalConstituent->analyticalConcentrationIndex;
+
+		cc.concentrationSample = analConcsSample->at(idx);
+	}
 }
 
 #ifdef ECHMET_LEMNG_SENSITIVE_NUMDERS
@@ -404,24 +485,18 @@ RealVecPtr makeAnalyticalConcentrationsForDerivator(const CalculatorSystemPack &
 }
 #endif // ECHMET_LEMNG_SENSITIVE_NUMDERS
 
-void precalculateConcentrationDeltas(CalculatorSystemPack &systemPack, CalculatorSystemPack &systemPackUncharged, DeltaPackVec &deltaPacks, DeltaPackVec &deltaPacksUncharged, const RealVecPtr &analyticalConcentrations, const NonidealityCorrections corrections)
+void precalculateConcentrationDeltas(CalculatorSystemPack &systemPack, DeltaPackVec &deltaPacks, const RealVecPtr &analyticalConcentrations, const NonidealityCorrections corrections)
 {
 	static const ECHMETReal H = DELTA_H;
 
-	static const auto mapDerivatives = [](const CalculatorIonicFormVec &ifVec, const RealVec *derivatives, EMVector &deltas) {
-		/* Use LEMNG ordering for concentration deltas */
-		const size_t NIF = ifVec.size();
-		const size_t H3O_idx = NIF - 2;
-		const size_t OH_idx = NIF - 1;
+	/* Derivatives are converted to doubles in one pass and then gathered into LEMNG ordering */
+	static const auto mapDerivatives = [](const IonicFormArrays &arrays, const RealVec *derivatives, std::vector<double> &converted, EMVector &deltas) {
+		const ECHMETReal *raw = derivatives->cdata();
 
-		for (size_t iFIdx = 0; iFIdx < NIF - 2; iFIdx++) {
-			const CalculatorIonicForm *iF = ifVec.at(iFIdx);
-
-			deltas(iFIdx) = ECHMETRealToDouble(derivatives->at(iF->internalIonicFormConcentrationIdx));
-		}
+		for (size_t idx = 0; idx < converted.size(); idx++)
+			converted[idx] = ECHMETRealToDouble(raw[idx]);
 
-		deltas(H3O_idx) = ECHMETRealToDouble(derivatives->at(0));
-		deltas(OH_idx) = ECHMETRealToDouble(derivatives->at(1));
+		gatherConcentrations(arrays.internalConcentrationIndices, converted, deltas);
 	};
 
 	const size_t NCO = systemPack.constituents.size();
@@ -438,19 +513,18 @@ void precalculateConcentrationDeltas(CalculatorSystemPack &systemPack, Calculato
 	RealVec *derivatives = nullptr;
 
 	deltaPacks.reserve(NCO);
-	deltaPacksUncharged.reserve(NCO);
 
 	::ECHMET::RetCode tRet = CAES::prepareDerivatorContext(derivatives, solver, chemSystemRaw, corrections);
 	if (tRet != ::ECHMET::RetCode::OK)
 		throw CalculationException{std::string{"Cannot make derivator context: "} + std::string{errorToString(tRet)}, coreLibsErrorToNativeError(tRet)};
 
 #if ECHMET_LEMNG_PARALLEL_NUM_OPS
-	typedef std::tuple<DeltaPack, DeltaPack> WorkerResult;
+	typedef DeltaPack WorkerResult;
 
 	const size_t ND = derivatives->size();
 	auto worker = [&](const SysComp::Constituent *perturbedConstituent) -> WorkerResult {
 		EMVector deltas(systemPack.ionicForms.size());
-		EMVector deltasUncharged(systemPackUncharged.ionicForms.size());
+		std::vector<double> converted(ND);
 		ECHMETReal conductivityDerivative;
 		RealVec *_derivatives = ::ECHMET::createRealVec(ND);
 		if (_derivatives == nullptr)
@@ -470,13 +544,11 @@ void precalculateConcentrationDeltas(CalculatorSystemPack &systemPack, Calculato
 			throw CalculationException{"Cannot calculate concentration derivatives for M2", coreLibsErrorToNativeError(tRet)};
 		}
 
-		mapDerivatives(systemPack.ionicForms, _derivatives, deltas);
-		mapDerivatives(systemPackUncharged.ionicForms, _derivatives, deltasUncharged);
+		mapDerivatives(systemPack.ionicFormArrays, _derivatives, converted, deltas);
 
 		_derivatives->destroy();
 
-		return {DeltaPack{std::move(deltas), ECHMETRealToDouble(conductivityDerivative), perturbedConstituent},
-			DeltaPack{std::move(deltasUncharged), ECHMETRealToDouble(conductivityDerivative), perturbedConstituent}};
+		return DeltaPack{std::move(deltas), ECHMETRealToDouble(conductivityDerivative), perturbedConstituent};
 	};
 
 	std::vector<std::future<WorkerResult>> results{};
@@ -497,11 +569,8 @@ void precalculateConcentrationDeltas(CalculatorSystemPack &systemPack, Calculato
 			results.emplace_back(std::async(std::launch::async, worker, perturbedConstituent));
 		}
 
-		for (auto &f : results) {
-			auto &&r = f.get();
-			deltaPacks.emplace_back(std::move(std::get<0>(r)));
-			deltaPacksUncharged.emplace_back(std::move(std::get<1>(r)));
-		}
+		for (auto &f : results)
+			deltaPacks.emplace_back(f.get());
 	} catch (const CalculationException &ex) {
 		for (auto &f : results) {
 			if (f.valid())
@@ -514,11 +583,12 @@ void precalculateConcentrationDeltas(CalculatorSystemPack &systemPack, Calculato
 		throw ex;
 	}
 #else // ECHMET_LEMNG_PARALLEL_NUM_OPS
+	std::vector<double> converted(derivatives->size());
+
 	for (size_t cIdx = 0; cIdx < NCO; cIdx++) {
 		const SysComp::Constituent *perturbedConstituent = systemPack.constituents.at(cIdx).internalConstituent;
 		ECHMETReal conductivityDerivative;
 		EMVector deltas(systemPack.ionicForms.size());
-		EMVector deltasUncharged(systemPackUncharged.ionicForms.size());
 
 		tRet = CAES::calculateFirstConcentrationDerivatives_prepared(derivatives, conductivityDerivative,
 									     solver, H, corrections,
@@ -532,12 +602,10 @@ void precalculateConcentrationDeltas(CalculatorSystemPack &systemPack, Calculato
 			throw CalculationException{"Cannot calculate concentration derivatives for M2", coreLibsErrorToNativeError(tRet)};
 		}
 
-		mapDerivatives(systemPack.ionicForms, derivatives, deltas);
-		mapDerivatives(systemPackUncharged.ionicForms, derivatives, deltasUncharged);
+		mapDerivatives(systemPack.ionicFormArrays, derivatives, converted, deltas);
 
 		try {
 			deltaPacks.emplace_back(std::move(deltas), ECHMETRealToDouble(conductivityDerivative), perturbedConstituent);
-			deltaPacksUncharged.emplace_back(std::move(deltasUncharged), ECHMETRealToDouble(conductivityDerivative), perturbedConstituent);
 		} catch (std::bad_alloc &) {
 			solver->context()->destroy();
 			solver->destroy();
@@ -551,7 +619,8 @@ void precalculateConcentrationDeltas(CalculatorSystemPack &systemPack, Calculato
 	derivatives->destroy();
 }
 
-void prepareModelData(CalculatorSystemPack &systemPack, CalculatorSystemPack &systemPackUncharged, DeltaPackVec &deltaPacks, DeltaPackVec &deltaPacksUncharged, const RealVecPtr &analConcsBGELike, const RealVecPtr &analConcsSample, Calculator::SolutionProperties &BGELikeProps, const NonidealityCorrections corrections)
+void prepareModelData(CalculatorSystemPack &systemPack, DeltaPackVec &deltaPacks, const RealVecPtr &analConcsBGELike, const RealVecPtr &analConcsSample, Calculator::SolutionProperties &BGELikeProps, const NonidealityCorrections corrections,
+		      const bool warmStart)
 {
 	/* Step 1 - Identify the target and its flaws, there are always flaws... oops, not this "step one"...
 	 *
@@ -582,19 +651,18 @@ void prepareModelData(CalculatorSystemPack &systemPack, CalculatorSystemPack &sy
 	 *
 	 * Solve the almost-like-BGE system to get ionic concentrations and corrected ionic mobilities.
 	 */
-	BGELikeProps = calculateSolutionProperties(systemPack.chemSystemRaw, analConcsBGELike, systemPack.calcPropsRaw, corrections, false, true);
+	BGELikeProps = calculateSolutionProperties(systemPack.chemSystemRaw, analConcsBGELike, systemPack.calcPropsRaw, corrections, false, true, warmStart);
 
 	/* Step 2 - Bind the now known properties of the present ionic forms to the SystemPack.
 	 */
 	bindSystemPack(systemPack, analConcsBGELike, analConcsSample);
-	bindSystemPack(systemPackUncharged, analConcsBGELike, analConcsSample);
 
 	/* Step 3 - Precalculate concentration derivatives */
-	precalculateConcentrationDeltas(systemPack, systemPackUncharged, deltaPacks, deltaPacksUncharged, analConcsBGELike, corrections);
+	precalculateConcentrationDeltas(systemPack, deltaPacks, analConcsBGELike, corrections);
 }
 
 void solveChemicalSystem(const SysComp::ChemicalSystem *chemSystem, const RealVecPtr &concentrations, SysComp::CalculatedProperties *calcProps, const NonidealityCorrections corrections,
-			 const bool useHighPrecision)
+			 const bool useHighPrecision, const bool warmStart)
 {
 	using EnumOps::operator|;
 
@@ -620,15 +688,27 @@ void solveChemicalSystem(const SysComp::ChemicalSystem *chemSystem, const RealVe
 		throw CalculationException{"Failed to create solver", RetCode::E_NO_MEMORY};
 	}
 
-	tRet = solver->estimateDistributionSafe(concentrations.get(), *calcProps);
-	if (tRet != ::ECHMET::RetCode::OK) {
-		solver->destroy();
-		solverCtx->destroy();
-		throw CalculationException{"Failed to estimate distribution: " + std::string(errorToString(tRet)), coreLibsErrorToNativeError(tRet)};
+	CAES::SolverIterations solvIters{};
+
+	/* Distribution stored in calcProps by the previous solution is used as the initial guess
+	 * if we are asked to. Should the solver fail to converge from there, we start over
+	 * from the estimated distribution. */
+	if (warmStart) {
+		tRet = solver->solve(concentrations.get(), *calcProps, SOLVER_MAX_ITERATIONS, &solvIters);
+		if (tRet != ::ECHMET::RetCode::OK)
+			ECHMET_TRACE(LEMNGTracing, CALC_COMMON_CALC_SOLPROPS_PROGRESS, "Warm start failed, estimating distribution");
 	}
 
-	CAES::SolverIterations solvIters{};
-	tRet = solver->solve(concentrations.get(), *calcProps, SOLVER_MAX_ITERATIONS, &solvIters);
+	if (!warmStart || tRet != ::ECHMET::RetCode::OK) {
+		tRet = solver->estimateDistributionSafe(concentrations.get(), *calcProps);
+		if (tRet != ::ECHMET::RetCode::OK) {
+			solver->destroy();
+			solverCtx->destroy();
+			throw CalculationException{"Failed to estimate distribution: " + std::string(errorToString(tRet)), coreLibsErrorToNativeError(tRet)};
+		}
+
+		tRet = solver->solve(concentrations.get(), *calcProps, SOLVER_MAX_ITERATIONS, &solvIters);
+	}
 	if (tRet != ::ECHMET::RetCode::OK) {
 		solver->destroy();
 		solverCtx->destroy();
@@ -646,9 +726,10 @@ void solveChemicalSystem(const SysComp::ChemicalSystem *chemSystem, const RealVe
 	calcIonicProperties(chemSystem, concentrations, calcProps, corrections);
 }
 
-void solveChemicalSystem(const ChemicalSystemPtr chemSystem, const RealVecPtr &concentrations, CalculatedPropertiesPtr &calcProps, const NonidealityCorrections corrections, const bool useHighPrecision)
+void solveChemicalSystem(const ChemicalSystemPtr chemSystem, const RealVecPtr &concentrations, CalculatedPropertiesPtr &calcProps, const NonidealityCorrections corrections, const bool useHighPrecision,
+			 const bool warmStart)
 {
-	return solveChemicalSystem(chemSystem.get(), concentrations, calcProps.get(), corrections, useHighPrecision);
+	return solveChemicalSystem(chemSystem.get(), concentrations, calcProps.get(), corrections, useHighPrecision, warmStart);
 }
 
 std::vector<const SysComp::Constituent *> sysCompToLEMNGOrdering(const ChemicalSystemPtr &chemSystem)
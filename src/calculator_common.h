@@ -28,32 +28,52 @@ private:
 };
 
 SolutionProperties calculateSolutionProperties(const SysComp::ChemicalSystem *chemSystem, const RealVecPtr &concentrations, SysComp::CalculatedProperties *calcProps, const NonidealityCorrections corrections, const bool calcBufferCapacity = false,
-					       const bool useHighPrecision = false);
+					       const bool useHighPrecision = false, const bool warmStart = false);
 SolutionProperties calculateSolutionProperties(const ChemicalSystemPtr &chemSystem, const RealVecPtr &concentrations, CalculatedPropertiesPtr &calcProps, const NonidealityCorrections corrections, const bool calcBufferCapacity = false,
-					       const bool useHighPrecision = false);
+					       const bool useHighPrecision = false, const bool warmStart = false);
 
 template <typename T>
 bool isComplex(const T &I);
 
+/*!
+ * Gathers values related to ionic forms from a vector in CoreLibs ordering to LEMNG ordering.
+ *
+ * @param[in] indices Gather indices, see \p IonicFormArrays::internalConcentrationIndices
+ * @param[in] source Values in CoreLibs ordering.
+ * @param[out] output Values in LEMNG ordering.
+ */
+template <typename Output>
+void gatherConcentrations(const std::vector<size_t> &indices, const std::vector<double> &source, Output &&output)
+{
+	for (size_t idx = 0; idx < indices.size(); idx++)
+		output(idx) = source[indices[idx]];
+}
+
+void bindSampleConcentrations(CalculatorSystemPack &systemPack, const RealVecPtr &analConcsSample);
 RealVecPtr makeAnalyticalConcentrationsForDerivator(const CalculatorSystemPack &systemPack);
+CalculatorSystemPack cloneSystemPack(const CalculatorSystemPack &systemPack, SysComp::CalculatedProperties *calcPropsRaw);
 CalculatorSystemPack makeSystemPack(const ChemicalSystemPtr &chemSystem, const CalculatedPropertiesPtr &calcProps,
-				    const std::function<bool (const std::string &)> &isAnalyte,
-				    const bool includeUncharged);
-void prepareModelData(CalculatorSystemPack &systemPack, CalculatorSystemPack &systemPackUncharged, DeltaPackVec &deltaPacks, DeltaPackVec &deltaPacksUncharged, const RealVecPtr &analConcsBGELike, const RealVecPtr &analConcsSample, Calculator::SolutionProperties &BGELikeProps, const NonidealityCorrections corrections);
-void solveChemicalSystem(const SysComp::ChemicalSystem *chemSystem, const RealVecPtr &concentrations, SysComp::CalculatedProperties *calcProps, const NonidealityCorrections corrections, const bool useHighPrecision);
-void solveChemicalSystem(const ChemicalSystemPtr &chemSystem, const RealVecPtr &concentrations, CalculatedPropertiesPtr &calcProps, const NonidealityCorrections corrections, const bool useHighPrecision);
+				    const std::function<bool (const std::string &)> &isAnalyte);
+void prepareModelData(CalculatorSystemPack &systemPack, DeltaPackVec &deltaPacks, const RealVecPtr &analConcsBGELike, const RealVecPtr &analConcsSample, Calculator::SolutionProperties &BGELikeProps, const NonidealityCorrections corrections,
+		      const bool warmStart = false);
+void solveChemicalSystem(const SysComp::ChemicalSystem *chemSystem, const RealVecPtr &concentrations, SysComp::CalculatedProperties *calcProps, const NonidealityCorrections corrections, const bool useHighPrecision,
+			 const bool warmStart = false);
+void solveChemicalSystem(const ChemicalSystemPtr &chemSystem, const RealVecPtr &concentrations, CalculatedPropertiesPtr &calcProps, const NonidealityCorrections corrections, const bool useHighPrecision,
+			 const bool warmStart = false);
 std::vector<const SysComp::Constituent *> sysCompToLEMNGOrdering(const ChemicalSystemPtr &chemSystem);
 
-#ifdef ECHMET_LEMNG_SENSITIVE_NUMDERS	/*!< Use much finer delta and lower analytes concentrations to calculate numerical derivatives. This comes with some additional memory and performance overhead */
+static const double ANALYTE_CONCENTRATION = 1.0e-13;
+
+/* Derivatives are taken at the composition of the BGE-like system so that they belong
+ * to the same point as the linear model. Analytes must therefore be kept at ANALYTE_CONCENTRATION. */
+#ifdef ECHMET_LEMNG_SENSITIVE_NUMDERS	/*!< Use much finer delta to calculate numerical derivatives. This comes with some additional memory and performance overhead */
 static const ECHMETReal DELTA_H = 1.0e-33;
-static const double ANALYTE_CONCENTRATION_NUMDERS = 1.0e-13;
+static const double ANALYTE_CONCENTRATION_NUMDERS = ANALYTE_CONCENTRATION;
 #else
 static const ECHMETReal DELTA_H = 1.0e-17;
-static const double ANALYTE_CONCENTRATION_NUMDERS = 1.0e-13;
+static const double ANALYTE_CONCENTRATION_NUMDERS = ANALYTE_CONCENTRATION;
 #endif // ECHMET_LEMNG_SENSITIVE_NUMDERS
 
-static const double ANALYTE_CONCENTRATION = 1.0e-13;
-
 } // namespace Calculator
 } // namespace LEMNG
 } // namespace ECHMET
@@ -2,6 +2,7 @@
 #include "calculator_common.h"
 #include "calculator_matrices.h"
 #include "helpers.h"
+#include <algorithm>
 #include <cmath>
 
 #ifndef ECHMET_IMPORT_INTERNAL
@@ -16,7 +17,16 @@ namespace ECHMET {
 namespace LEMNG {
 namespace Calculator {
 
-typedef Eigen::ComplexEigenSolver<EMMatrixC> EMSolverC;
+/*!
+ * Largest number of constituents for which the eigenproblem is solved
+ * with matrices of fixed maximum size that are kept on the stack.
+ * Only the decomposition itself uses them, see \p decomposeMobilityMatrix().
+ */
+static const int SMALL_SYSTEM_MAX_NCO = 8;
+
+typedef Eigen::Matrix<std::complex<double>, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor, SMALL_SYSTEM_MAX_NCO, SMALL_SYSTEM_MAX_NCO> EMMatrixCSmall;
+
+static const double OVERLAP_TIE_TOLERANCE = 1.0e-12;	/*!< Normalized overlaps of eigenvectors closer than this are considered equal */
 
 Eigenzone::Eigenzone(const double zoneMobility, const bool isAnalyteZone, const size_t dummySize) :
 	constituentConcentrations(std::vector<double>(dummySize)),
@@ -57,66 +67,220 @@ Eigenzone::Eigenzone(Eigenzone &&other) noexcept :
 {
 }
 
-LinearResults::LinearResults(std::vector<Eigenzone> &&eigenzones, const QLQRPack &QLQR, const EMMatrix &M1, const EMMatrix &M2, const bool allZonesValid) :
-	eigenzones(eigenzones),
-	QLQR{QLQR},
-	M1{M1},
-	M2{M2},
-	allZonesValid{allZonesValid}
+LinearModel::LinearModel(MatrixM1 &&M1, EMMatrix &&M2, EMVectorC &&eigenmobilities, QLQRPack &&QLQR, std::vector<EMMatrixC> &&PMatrices,
+			 const double referenceOverlap) noexcept :
+	M1(std::move(M1)),
+	M2(std::move(M2)),
+	eigenmobilities(std::move(eigenmobilities)),
+	QLQR{std::move(QLQR)},
+	PMatrices(std::move(PMatrices)),
+	referenceOverlap{referenceOverlap}
+{
+}
+
+LinearModel::LinearModel(const LinearModel &other) :
+	M1(other.M1),
+	M2(other.M2),
+	eigenmobilities(other.eigenmobilities),
+	QLQR{other.QLQR},
+	PMatrices(other.PMatrices),
+	referenceOverlap{other.referenceOverlap}
+{
+}
+
+LinearModel::LinearModel(LinearModel &&other) noexcept :
+	M1(std::move(other.M1)),
+	M2(std::move(other.M2)),
+	eigenmobilities(std::move(other.eigenmobilities)),
+	QLQR{std::move(other.QLQR)},
+	PMatrices(std::move(other.PMatrices)),
+	referenceOverlap{other.referenceOverlap}
+{
+}
+
+ZoneComposition::ZoneComposition(const double zoneMobility, std::vector<double> &&constituentConcentrations, const bool tainted, const bool isAnalyteZone) noexcept :
+	constituentConcentrations(std::move(constituentConcentrations)),
+	zoneMobility{zoneMobility},
+	tainted{tainted},
+	isAnalyteZone{isAnalyteZone}
 {
 }
 
-LinearResults::LinearResults(std::vector<Eigenzone> &&eigenzones, QLQRPack &&QLQR, EMMatrix &&M1, EMMatrix &&M2, const bool allZonesValid) noexcept :
-	eigenzones(eigenzones),
-	QLQR{QLQR},
-	M1{M1},
-	M2{M2},
+LinearResults::LinearResults(std::vector<Eigenzone> &&eigenzones, const bool allZonesValid) noexcept :
+	eigenzones(std::move(eigenzones)),
 	allZonesValid{allZonesValid}
 {
 }
 
 LinearResults::LinearResults(const LinearResults &other) :
 	eigenzones(other.eigenzones),
-	QLQR{other.QLQR},
-	M1{other.M1},
-	M2{other.M2},
 	allZonesValid{other.allZonesValid}
 {
 }
 
 LinearResults::LinearResults(LinearResults &&other) noexcept :
 	eigenzones(std::move(other.eigenzones)),
-	QLQR{std::move(other.QLQR)},
-	M1{std::move(other.M1)},
-	M2{std::move(other.M2)},
 	allZonesValid{other.allZonesValid}
 {
 }
 
+template <typename MatrixC>
 static
-std::vector<EMMatrixC> calculatePMatrices(const EMMatrixC &QL, const EMMatrixC &QR)
+std::vector<EMMatrixC> calculatePMatrices(const MatrixC &QL, const MatrixC &QR)
 {
 	std::vector<EMMatrixC> PMatrices{};
 
 	PMatrices.reserve(QR.rows());
 
-	for (int idx = 0; idx < QR.rows(); idx++) {
-		const EMMatrixC qRi = QR.col(idx);
-		const EMMatrixC qLi = QL.row(idx);
-
-		PMatrices.emplace_back(qRi * qLi);
-	}
+	for (int idx = 0; idx < QR.rows(); idx++)
+		PMatrices.emplace_back(QR.col(idx) * QL.row(idx));
 
 	return PMatrices;
 }
 
+/*!
+ * Solves the eigenproblem of the mobility matrix and derives the projection matrices.
+ *
+ * @param[in] MFin The mobility matrix.
+ * @param[out] eigenmobs Eigenvalues of the mobility matrix.
+ * @param[out] PMatrices Projection matrices.
+ *
+ * @return QL and QR eigenvector matrices
+ *
+ * \p MatrixC is either the dynamically sized \p EMMatrixC or the stack-allocated
+ * \p EMMatrixCSmall. With \p EMMatrixCSmall the complex copy of \p MFin, the workspace
+ * of the solver, \p QR and its inverse need no heap allocations. The outputs are still
+ * converted to the dynamically sized types the \p LinearModel stores: eigenvalues, \p QL and
+ * \p QR and the projection matrices are allocated on the heap. M1, M2 and the dispersion
+ * stage do not depend on \p MatrixC at all.
+ */
+template <typename MatrixC>
 static
-QLQRPack calculateQLQR(EMSolverC &ces)
+QLQRPack decomposeMobilityMatrix(const EMMatrix &MFin, EMVectorC &eigenmobs, std::vector<EMMatrixC> &PMatrices)
 {
-	EMMatrixC QR = ces.eigenvectors();
-	EMMatrixC QL = QR.inverse();
+	/* Eigenvectors of the previous point are used only to order the eigenpairs afterwards,
+	 * they do not seed the decomposition. ComplexEigenSolver cannot start from an initial guess
+	 * and a subspace iteration seeded with them needs several products with the full matrix per
+	 * eigenpair to converge. For the handful of constituents these systems have that costs about
+	 * as much as the Schur decomposition and converges poorly exactly where two eigenmobilities cross. */
+	const MatrixC MFinC = MFin.cast<std::complex<double>>();
+	const Eigen::ComplexEigenSolver<MatrixC> ces{MFinC};
+
+	eigenmobs = ces.eigenvalues();
+	ECHMET_TRACE(LEMNGTracing, CALC_EIGENMOBS, std::cref(eigenmobs));
+	if (isComplex(eigenmobs))
+		throw CalculationException{"Detected complex eigenmobilities", RetCode::E_COMPLEX_EIGENMOBILITIES};
 
-	return QLQRPack{QL, QR};
+	const MatrixC QR = ces.eigenvectors();
+	const MatrixC QL = QR.inverse();
+
+	PMatrices = calculatePMatrices(QL, QR);
+
+	return QLQRPack{EMMatrixC(QL), EMMatrixC(QR)};
+}
+
+/*!
+ * Reorders the eigenpairs so that each of them takes the position of the eigenpair of the reference
+ * decomposition it corresponds to. This keeps the eigenzones in the same order across consecutive
+ * evaluations of a system whose composition changes only slightly.
+ *
+ * The correspondence is given by the overlap of the new right eigenvectors with the reference left
+ * eigenvectors. As <tt>QL * QR = I</tt>, the overlaps of corresponding eigenvectors are close to one
+ * and the remaining ones are close to zero. Pairs are assigned greedily, the most overlapping first.
+ * Overlaps that differ by less than \p OVERLAP_TIE_TOLERANCE are considered equal. Such ties are
+ * resolved in favor of keeping the eigenpair at its position and then by the lowest indices so that
+ * the order never depends on rounding noise.
+ *
+ * How far the eigenvectors have turned since the reference is reported in \p referenceOverlap
+ * as the smallest cosine of the angle between a reordered right eigenvector and the reference
+ * right eigenvector at the same position. It drops when the eigenvectors of zones whose
+ * eigenmobilities are about to cross start to mix.
+ *
+ * @param[in] reference Decomposition to follow, may be \p nullptr.
+ * @param[in,out] eigenmobs Eigenvalues of the mobility matrix.
+ * @param[in] QLQR QL and QR eigenvector matrices.
+ * @param[in,out] PMatrices Projection matrices.
+ * @param[out] referenceOverlap Smallest overlap of the matched right eigenvectors, one if there is no reference.
+ *
+ * @return Reordered QL and QR eigenvector matrices
+ */
+static
+QLQRPack followReference(const QLQRPack *reference, EMVectorC &eigenmobs, QLQRPack &&QLQR, std::vector<EMMatrixC> &PMatrices, double &referenceOverlap)
+{
+	referenceOverlap = 1.0;
+
+	if (reference == nullptr || reference->QL().rows() != QLQR.QR().cols())
+		return std::move(QLQR);
+
+	const EMMatrixC &refQL = reference->QL();
+	const EMMatrixC &QL = QLQR.QL();
+	const EMMatrixC &QR = QLQR.QR();
+	const int N = QR.cols();
+
+	EMMatrix overlaps = (refQL * QR).cwiseAbs();
+	for (int row = 0; row < N; row++)
+		overlaps.row(row) /= refQL.row(row).norm();
+	for (int col = 0; col < N; col++)
+		overlaps.col(col) /= QR.col(col).norm();
+
+	std::vector<int> permutation(N, -1);
+	std::vector<bool> assigned(N, false);
+	for (int pair = 0; pair < N; pair++) {
+		int bestRow = -1;
+		int bestCol = -1;
+
+		for (int row = 0; row < N; row++) {
+			if (permutation[row] >= 0)
+				continue;
+
+			for (int col = 0; col < N; col++) {
+				if (assigned[col])
+					continue;
+
+				if (bestRow < 0) {
+					bestRow = row;
+					bestCol = col;
+					continue;
+				}
+
+				const double diff = overlaps(row, col) - overlaps(bestRow, bestCol);
+				if (diff > OVERLAP_TIE_TOLERANCE ||
+				    (diff >= -OVERLAP_TIE_TOLERANCE && row == col && bestRow != bestCol)) {
+					bestRow = row;
+					bestCol = col;
+				}
+			}
+		}
+
+		permutation[bestRow] = bestCol;
+		assigned[bestCol] = true;
+	}
+
+	ECHMET_TRACE(LEMNGTracing, CALC_LIN_EIGENPAIR_ORDER, std::cref(permutation));
+
+	EMVectorC orderedEigenmobs{N};
+	EMMatrixC orderedQL{N, N};
+	EMMatrixC orderedQR{N, N};
+	std::vector<EMMatrixC> orderedPMatrices{};
+
+	orderedPMatrices.reserve(N);
+	for (int idx = 0; idx < N; idx++) {
+		orderedEigenmobs(idx) = eigenmobs(permutation[idx]);
+		orderedQL.row(idx) = QL.row(permutation[idx]);
+		orderedQR.col(idx) = QR.col(permutation[idx]);
+		orderedPMatrices.emplace_back(std::move(PMatrices[permutation[idx]]));
+	}
+
+	const EMMatrixC &refQR = reference->QR();
+	for (int idx = 0; idx < N; idx++) {
+		const double overlap = std::abs(refQR.col(idx).dot(orderedQR.col(idx))) / (refQR.col(idx).norm() * orderedQR.col(idx).norm());
+		referenceOverlap = std::min(referenceOverlap, overlap);
+	}
+
+	eigenmobs = std::move(orderedEigenmobs);
+	PMatrices = std::move(orderedPMatrices);
+
+	return QLQRPack{orderedQL, orderedQR};
 }
 
 static
@@ -176,56 +340,88 @@ std::vector<std::tuple<std::vector<double>, bool, bool>> calculateEigenzoneCompo
 	return ezPackVec;
 }
 
-LinearResults calculateLinear(const CalculatorSystemPack &systemPack, const DeltaPackVec &deltaPacks, const NonidealityCorrections corrections)
+static
+MatrixM1 makeMobilityMatrices(const CalculatorSystemPack &systemPack, const DeltaPackVec &deltaPacks, EMMatrix &M2, EMMatrix &MFin)
 {
-	/* Calculate the mobility matrix. */
-	EMMatrix M1{};
-	EMMatrix M2{};
-	EMMatrix MFin{};
-
-	ECHMET_TRACE(LEMNGTracing, CALC_LIN_PROGRESS, "Starting");
-
 	try {
-		M1 = makeMatrixM1(systemPack);
+		MatrixM1 M1 = makeMatrixM1(systemPack);
 		M2 = makeMatrixM2(systemPack, deltaPacks);
-		MFin = M1 * M2;
+		MFin = M1.multiply(M2);
 
 		ECHMET_TRACE(LEMNGTracing, CALC_LIN_MFIN, std::cref(MFin));
+
+		return M1;
 	} catch (std::bad_alloc &) {
 		throw CalculationException{"Insufficient memory to calculate mobility matrix", RetCode::E_NO_MEMORY};
 	}
+}
 
-	ECHMET_TRACE(LEMNGTracing, CALC_LIN_PROGRESS, "Solving eigenzones' compositions");
+LinearModel makeLinearModel(const CalculatorSystemPack &systemPack, const DeltaPackVec &deltaPacks, const QLQRPack *reference)
+{
+	/* Calculate the mobility matrix. */
+	EMMatrix M2{};
+	EMMatrix MFin{};
 
-	if (MFin.rows() < 1)
-		return LinearResults{{}, QLQRPack{EMMatrixC{0,0}, EMMatrixC{0,0}}, std::move(M1), std::move(M2), true};
+	ECHMET_TRACE(LEMNGTracing, CALC_LIN_PROGRESS, "Starting");
+
+	MatrixM1 M1 = makeMobilityMatrices(systemPack, deltaPacks, M2, MFin);
 
+	if (MFin.rows() < 1)
+		return LinearModel{std::move(M1), std::move(M2), EMVectorC{0}, QLQRPack{EMMatrixC{0,0}, EMMatrixC{0,0}}, {}, 1.0};
 
-	/* Calculate eigenmobilites and zone compositions.
-	 * Eigenmobilities are the eigenvalues of the MFin matrix.
+	/* Eigenmobilities are the eigenvalues of the MFin matrix.
 	 * Zone composition are derived from the QL and QR eigenvectors.
 	 */
 	try {
-		EMSolverC ces{MFin};
-		EMVectorC eigenmobs = ces.eigenvalues();
-		ECHMET_TRACE(LEMNGTracing, CALC_EIGENMOBS, std::cref(eigenmobs));
-		if (isComplex(eigenmobs))
-			throw CalculationException{"Detected complex eigenmobilities", RetCode::E_COMPLEX_EIGENMOBILITIES};
+		EMVectorC eigenmobs{};
+		std::vector<EMMatrixC> PMatrices{};
+		double referenceOverlap;
+		QLQRPack QLQR = followReference(reference, eigenmobs,
+						(MFin.rows() <= SMALL_SYSTEM_MAX_NCO) ? decomposeMobilityMatrix<EMMatrixCSmall>(MFin, eigenmobs, PMatrices)
+										      : decomposeMobilityMatrix<EMMatrixC>(MFin, eigenmobs, PMatrices),
+						PMatrices, referenceOverlap);
+
+		return LinearModel{std::move(M1), std::move(M2), std::move(eigenmobs), std::move(QLQR), std::move(PMatrices), referenceOverlap};
+	} catch (std::bad_alloc &) {
+		throw CalculationException{"Insufficient memory to calculate eigenmobilities", RetCode::E_NO_MEMORY};
+	}
+}
 
-		const QLQRPack QLQR = calculateQLQR(ces);
-		const std::vector<EMMatrixC> PMatrices = calculatePMatrices(QLQR.QL(), QLQR.QR());
-		auto eigenzoneCompositions = calculateEigenzoneCompositions(PMatrices, systemPack);
+ZoneCompositionVec calculateZoneCompositions(const LinearModel &linModel, const CalculatorSystemPack &systemPack)
+{
+	ECHMET_TRACE(LEMNGTracing, CALC_LIN_PROGRESS, "Calculating eigenzones' compositions");
 
-		std::vector<Eigenzone> eigenzones{};
-		eigenzones.reserve(eigenzoneCompositions.size());
-		bool allZonesValid = true;
+	try {
+		const EMVectorC &eigenmobs = linModel.eigenmobilities;
+		auto eigenzoneCompositions = calculateEigenzoneCompositions(linModel.PMatrices, systemPack);
+
+		ZoneCompositionVec compositions{};
+		compositions.reserve(eigenzoneCompositions.size());
 		for (size_t idx = 0; idx < eigenzoneCompositions.size(); idx++) {
 			auto &&ez = std::get<0>(eigenzoneCompositions.at(idx));
 			const bool tainted = std::get<1>(eigenzoneCompositions.at(idx));
 			const bool isAnalyteZone = std::get<2>(eigenzoneCompositions.at(idx));
+
+			compositions.emplace_back(eigenmobs(idx).real(), std::move(ez), tainted, isAnalyteZone);
+		}
+
+		return compositions;
+	} catch (std::bad_alloc &) {
+		throw CalculationException{"Insufficient memory to calculate eigenzone compositions", RetCode::E_NO_MEMORY};
+	}
+}
+
+LinearResults solveEigenzones(const ZoneCompositionVec &compositions, const CalculatorSystemPack &systemPack, const NonidealityCorrections corrections)
+{
+	ECHMET_TRACE(LEMNGTracing, CALC_LIN_PROGRESS, "Solving eigenzones' compositions");
+
+	try {
+		std::vector<Eigenzone> eigenzones{};
+		eigenzones.reserve(compositions.size());
+		bool allZonesValid = true;
+		for (const ZoneComposition &zc : compositions) {
 			RealVecPtr zoneConcsVec = makeAnalyticalConcentrationsVec(systemPack.chemSystemRaw);
 			CalculatedPropertiesPtr zoneCalcProps = makeCalculatedProperties(systemPack.chemSystemRaw);
-			const double zoneMobility = eigenmobs(idx).real();
 
 			/* Analytical concentrations in eigenzones are ordered by the CalculatorSystemPack
 			 * ordering which may not correspond to the SysComp ordering.
@@ -235,21 +431,21 @@ LinearResults calculateLinear(const CalculatorSystemPack &systemPack, const Delt
 				const CalculatorConstituent &cc = systemPack.constituents.at(jdx);
 				const size_t scIdx = cc.internalConstituent->analyticalConcentrationIndex;
 
-				(*zoneConcsVec)[scIdx] = ez.at(jdx);
+				(*zoneConcsVec)[scIdx] = zc.constituentConcentrations.at(jdx);
 			}
 
 			try {
 				SolutionProperties zoneProps = calculateSolutionProperties(systemPack.chemSystemRaw, zoneConcsVec, zoneCalcProps.get(), corrections);
-				eigenzones.emplace_back(zoneMobility, std::move(ez), std::move(zoneProps), tainted, isAnalyteZone);
+				eigenzones.emplace_back(zc.zoneMobility, std::vector<double>{zc.constituentConcentrations}, std::move(zoneProps), zc.tainted, zc.isAnalyteZone);
 			} catch (CalculationException &) {
-				eigenzones.emplace_back(zoneMobility, isAnalyteZone, eigenzoneCompositions.size());
+				eigenzones.emplace_back(zc.zoneMobility, zc.isAnalyteZone, compositions.size());
 				allZonesValid = false;
 			}
 		}
 
 		ECHMET_TRACE(LEMNGTracing, CALC_LIN_PROGRESS, "Done");
 
-		return LinearResults{std::move(eigenzones), std::move(QLQR), std::move(M1), std::move(M2), allZonesValid};
+		return LinearResults{std::move(eigenzones), allZonesValid};
 	} catch (std::bad_alloc &) {
 		throw CalculationException{"Insufficient memory to calculate eigenzone compositions", RetCode::E_NO_MEMORY};
 	} catch (SysCompException &ex) {
@@ -257,6 +453,14 @@ LinearResults calculateLinear(const CalculatorSystemPack &systemPack, const Delt
 	}
 }
 
+LinearResults calculateLinear(const LinearModel &linModel, const CalculatorSystemPack &systemPack, const NonidealityCorrections corrections)
+{
+	if (linModel.PMatrices.size() < 1)
+		return LinearResults{{}, true};
+
+	return solveEigenzones(calculateZoneCompositions(linModel, systemPack), systemPack, corrections);
+}
+
 } // namespace Calculator
 } // namespace LEMNG
 
@@ -292,6 +496,18 @@ ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_LIN_ZONE_TAINTED, const int zoneNum,
 }
 ECHMET_END_MAKE_LOGGER
 
+ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_LIN_EIGENPAIR_ORDER, "Order of eigenpairs following the previous evaluation")
+ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_LIN_EIGENPAIR_ORDER, const std::vector<int> &permutation)
+{
+	std::ostringstream ss{};
+
+	for (size_t idx = 0; idx < permutation.size(); idx++)
+		ss << "Eigenpair " << permutation[idx] << " follows eigenpair " << idx << "\n";
+
+	return ss.str();
+}
+ECHMET_END_MAKE_LOGGER
+
 ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_EIGENMOBS, "Eigenmobilities")
 ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_EIGENMOBS, const LEMNG::Calculator::EMVectorC &mobilities)
 {
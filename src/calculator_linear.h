@@ -24,21 +24,53 @@ public:
 	const bool valid;
 };
 
+/*!
+ * Part of the linear model that depends only on the composition of the background electrolyte.
+ */
+class LinearModel {
+public:
+	LinearModel(MatrixM1 &&M1, EMMatrix &&M2, EMVectorC &&eigenmobilities, QLQRPack &&QLQR, std::vector<EMMatrixC> &&PMatrices,
+		    const double referenceOverlap) noexcept;
+	LinearModel(const LinearModel &other);
+	LinearModel(LinearModel &&other) noexcept;
+
+	const MatrixM1 M1;
+	const EMMatrix M2;
+	const EMVectorC eigenmobilities;		/*!< Eigenvalues of the <tt>M1 * M2</tt> matrix */
+	const QLQRPack QLQR;
+	const std::vector<EMMatrixC> PMatrices;		/*!< Projection matrices used to resolve compositions of the eigenzones */
+	const double referenceOverlap;			/*!< Smallest cosine of the angle between a right eigenvector and the right eigenvector
+							     of the reference it has been matched to. One if there was no reference. */
+};
+
+/*!
+ * Analytical composition of an eigenzone as predicted by the linear model.
+ */
+class ZoneComposition {
+public:
+	ZoneComposition(const double zoneMobility, std::vector<double> &&constituentConcentrations, const bool tainted, const bool isAnalyteZone) noexcept;
+
+	const std::vector<double> constituentConcentrations;	/*!< Ordered by the constituents in the \p CalculatorSystemPack */
+	const double zoneMobility;
+	const bool tainted;
+	const bool isAnalyteZone;
+};
+typedef std::vector<ZoneComposition> ZoneCompositionVec;
+
 class LinearResults {
 public:
-	LinearResults(std::vector<Eigenzone> &&eigenzones, const QLQRPack &QLQR, const EMMatrix &M1, const EMMatrix &M2, const bool allZonesValid);
-	LinearResults(std::vector<Eigenzone> &&eigenzones, QLQRPack &&QLQR, EMMatrix &&M1, EMMatrix &&M2, const bool allZonesValid) noexcept;
+	LinearResults(std::vector<Eigenzone> &&eigenzones, const bool allZonesValid) noexcept;
 	LinearResults(const LinearResults &other);
 	LinearResults(LinearResults &&other) noexcept;
 
 	const std::vector<Eigenzone> eigenzones;
-	const QLQRPack QLQR;
-	const EMMatrix M1;
-	const EMMatrix M2;
 	const bool allZonesValid;
 };
 
-LinearResults calculateLinear(const CalculatorSystemPack &systemPack, const DeltaPackVec &deltaPacks, const NonidealityCorrections corrections);
+LinearModel makeLinearModel(const CalculatorSystemPack &systemPack, const DeltaPackVec &deltaPacks, const QLQRPack *reference = nullptr);
+ZoneCompositionVec calculateZoneCompositions(const LinearModel &linModel, const CalculatorSystemPack &systemPack);
+LinearResults solveEigenzones(const ZoneCompositionVec &compositions, const CalculatorSystemPack &systemPack, const NonidealityCorrections corrections);
+LinearResults calculateLinear(const LinearModel &linModel, const CalculatorSystemPack &systemPack, const NonidealityCorrections corrections);
 
 } // namespace Calculator
 } // namespace LEMNG
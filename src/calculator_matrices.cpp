@@ -16,130 +16,84 @@ namespace ECHMET {
 namespace LEMNG {
 namespace Calculator {
 
+/*!
+ * Calculates <tt>sum(c * u * sgn(z) * d)</tt> over all ionic forms of each constituent
+ */
 static
-int multiplicity(const size_t i, const MultiplicityVec &mList)
+EMColVector conductivityTerms(const CalculatorSystemPack &systemPack)
 {
-	for (const auto &m : mList)
-		if (i == m.first) return m.second;
+	const IonicFormArrays &arrays = systemPack.ionicFormArrays;
 
-	return 0;
+	EMColVector uIcI = systemPack.conductivityWeights * arrays.concentrations.cwiseProduct(arrays.mobilities).cwiseProduct(arrays.signs);
+
+	ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_UICIF_OUTPUT, std::cref(uIcI), std::cref(systemPack.constituents));
+
+	return uIcI;
 }
 
-EMMatrix makeM1Derivative(const CalculatorSystemPack &systemPack, const DeltaPack &deltaPack) noexcept
+M1DerivativeFactors::M1DerivativeFactors(EMColVector &&conductivityRatios, EMMatrix &&T) noexcept :
+	conductivityRatios(std::move(conductivityRatios)),
+	T(std::move(T))
 {
-	const size_t ROWS = systemPack.constituents.size();
-	const size_t COLS = systemPack.ionicForms.size();
-	const size_t H3O_idx = COLS - 2;
-	const size_t OH_idx = COLS - 1;
-	EMMatrix MOneDer{ROWS, COLS};
+}
 
-	const CalculatorConstituentVec &ccVec = systemPack.constituents;
-	const CalculatorIonicFormVec &ifVec = systemPack.ionicForms;
+/*!
+ * Derivative of matrix M1 with respect to concentration of constituent J has the same structure as M1 itself,
+ * <tt>dM1/dc_J = -(dK_J / K) * S + t_J * b^T</tt>, where \p S and \p b are taken from \p MatrixM1.
+ * Column \p t_J of the matrix \p T is
+ * <tt>t_J = F * (2 * dK_J / K^2 * R * c - R * dc/dc_J / K)</tt>, where <tt>R(i, j) = u_j * sgn(z_j) * d_ij</tt>
+ * for ionic forms \p j that contain constituent \p i. All columns are obtained with one product <tt>R * M2</tt>
+ * since the columns of M2 are the concentration deltas. \p R is restricted to charged ionic forms like M2 is.
+ */
+M1DerivativeFactors makeM1DerivativeFactors(const CalculatorSystemPack &systemPack, const DeltaPackVec &deltaPacks, const EMMatrix &MTwo)
+{
+	const size_t ROWS = systemPack.constituents.size();
 	const double baseConductivity = systemPack.conductivity * 1.0e9;
-	const double dKdcJ = deltaPack.conductivityDelta * 1.0e9;
-
-	ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_DM1_INPUT, baseConductivity, std::cref(deltaPack.concentrationDeltas));
-
-	for (size_t row = 0; row < ROWS; row++) {
-		const CalculatorConstituent &c = ccVec.at(row);
-
-		const double uIcIdKdC = [&c, baseConductivity, dKdcJ]() {
-			double s = 0.0;
-
-			for (const CalculatorIonicForm *iF : c.ionicForms) {
-				const int d = (iF->internalIonicForm->ligand != nullptr) ? iF->internalIonicForm->ligandCount : 1;
-				s += iF->concentration * iF->mobility * cxsgn(iF->charge) * d;
-				ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_DM1_UICIDKDC, s, iF->mobility, cxsgn(iF->charge), d);
-			}
-
-			return s * 2.0 / std::pow(baseConductivity, 2) * dKdcJ;
-		}();
-
-		const double uIdcIdcJ = [&c, &deltaPack, baseConductivity]() {
-			double s = 0.0;
-
-			for (const CalculatorIonicForm *iF : c.ionicForms) {
-				const int d = (iF->internalIonicForm->ligand != nullptr) ? iF->internalIonicForm->ligandCount : 1;
-				s += iF->mobility * cxsgn(iF->charge) * deltaPack.concentrationDeltas(iF->globalIonicFormConcentrationIdx) * d;
-				ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_DM1_UIDCIDCJ, std::cref(iF->name), iF->globalIonicFormConcentrationIdx,
-					     deltaPack.concentrationDeltas(iF->globalIonicFormConcentrationIdx), s, d);
-			}
-
-			return -s / baseConductivity;
-		}();
 
-		const double termTwo = (uIcIdKdC + uIdcIdcJ) * PhChConsts::F;
+	const IonicFormArrays &arrays = systemPack.ionicFormArrays;
 
-		for (size_t col = 0; col < COLS - 2; col++) {
-			const CalculatorIonicForm *iF = ifVec.at(col);
-			const auto &multiplicities = iF->multiplicities;
-			const int32_t charge = iF->charge;
-			const double mobility = iF->mobility;
-			const int d = multiplicity(row, multiplicities);
+	const EMColVector uIcI = conductivityTerms(systemPack);
+	EMColVector dKdc{ROWS};
 
-			double result = -d * cxsgn(charge) * dKdcJ / baseConductivity;
-			result += termTwo * std::abs(charge);
-			result *= mobility;
+	for (size_t col = 0; col < ROWS; col++) {
+		const DeltaPack &deltaPack = deltaPacks.at(col);
 
-			ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_DM1_KRD, d);
+		ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_DM1_INPUT, baseConductivity, std::cref(deltaPack.concentrationDeltas));
 
-			MOneDer(row, col) = result;
-		}
-
-		const double H3OMob = ifVec.at(H3O_idx)->mobility;
-		const double OHMob = ifVec.at(OH_idx)->mobility;
+		dKdc(col) = deltaPack.conductivityDelta * 1.0e9;
+	}
 
-		ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_DM1_ROW_BLOCK, uIcIdKdC, uIdcIdcJ, termTwo, H3OMob, OHMob);
+	const EMSparseMatrix R = systemPack.conductivityWeights * arrays.mobilities.cwiseProduct(arrays.signs).asDiagonal() * arrays.chargedSelector;
 
-		/* H3O+ and OH- are in the last two columns */
-		MOneDer(row, H3O_idx) = termTwo * H3OMob;
-		MOneDer(row, OH_idx) = termTwo * OHMob;
-	}
+	EMMatrix T = (2.0 / std::pow(baseConductivity, 2)) * uIcI * dKdc.transpose();
+	T.noalias() -= (R * MTwo) / baseConductivity;
+	T *= PhChConsts::F;
 
-	ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_DM1_OUTPUT, std::cref(MOneDer));
+	ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_DM1_OUTPUT, std::cref(T));
 
-	return MOneDer;
+	return M1DerivativeFactors{dKdc / baseConductivity, std::move(T)};
 }
 
-EMMatrix makeM2Derivative(const CalculatorSystemPack &systemPack, const RealVecPtr &analyticalConcentrations, const SysComp::Constituent *pivotalConstituent, CAES::Solver *solver, RealVec *derivatives)
+void makeM2DerivativeColumn(const CalculatorSystemPack &systemPack, const RealVec *analyticalConcentrations, const SysComp::Constituent *pivotalConstituent, const size_t col,
+			    CAES::Solver *solver, RealVec *derivatives, EMMatrix &MTwoDer)
 {
 	const ECHMETReal H = DELTA_H;
 
-	const size_t ROWS = systemPack.ionicForms.size();
-	const size_t COLS = systemPack.constituents.size();
-	const size_t H3O_idx = ROWS - 2;
-	const size_t OH_idx = ROWS - 1;
-#ifdef ECHMET_LEMNG_SENSITIVE_NUMDERS
-	(void)analyticalConcentrations;
-	const RealVecPtr analyticalConcentrationsForDiffs = makeAnalyticalConcentrationsForDerivator(systemPack);
-#else
-	const RealVecPtr &analyticalConcentrationsForDiffs = analyticalConcentrations;
-#endif
-	EMMatrix MTwoDer{ROWS, COLS};
-
 	SysComp::ChemicalSystem chemSystemRaw = *systemPack.chemSystemRaw;
 	const SysComp::CalculatedProperties *calcPropsRaw = systemPack.calcPropsRaw;
+	const SysComp::Constituent *cK = systemPack.constituents.at(col).internalConstituent;
 
-	for (size_t col = 0; col < COLS; col++) {
-		const SysComp::Constituent *cK = systemPack.constituents.at(col).internalConstituent;
-
-		::ECHMET::RetCode tRet = CAES::calculateCrossConcentrationDerivatives_prepared(derivatives, solver, H, chemSystemRaw, analyticalConcentrationsForDiffs.get(), pivotalConstituent, cK, calcPropsRaw->ionicStrength);
-		if (tRet != ::ECHMET::RetCode::OK)
-			throw CalculationException{"Cannot calculate concentration derivatives for M2 derivative", coreLibsErrorToNativeError(tRet)};
+	::ECHMET::RetCode tRet = CAES::calculateCrossConcentrationDerivatives_prepared(derivatives, solver, H, chemSystemRaw, analyticalConcentrations, pivotalConstituent, cK, calcPropsRaw->ionicStrength);
+	if (tRet != ::ECHMET::RetCode::OK)
+		throw CalculationException{"Cannot calculate concentration derivatives for M2 derivative", coreLibsErrorToNativeError(tRet)};
 
-		for (size_t row = 0; row < ROWS - 2; row++) {
-			const CalculatorIonicForm *iF = systemPack.ionicForms.at(row);
+	/* H3O+ and OH- map onto the first two elements of the CoreLibs vector */
+	const std::vector<size_t> &indices = systemPack.ionicFormArrays.internalConcentrationIndices;
+	const std::vector<size_t> &charged = systemPack.ionicFormArrays.chargedIndices;
+	const ECHMETReal *raw = derivatives->cdata();
 
-			MTwoDer(row, col) = ECHMETRealToDouble(derivatives->at(iF->internalIonicFormConcentrationIdx));
-		}
-
-		MTwoDer(H3O_idx, col) = ECHMETRealToDouble(derivatives->at(0));
-		MTwoDer(OH_idx, col) = ECHMETRealToDouble(derivatives->at(1));
-	}
-
-	ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_DM2_OUTPUT, std::cref(MTwoDer));
-
-	return MTwoDer;
+	for (size_t row = 0; row < charged.size(); row++)
+		MTwoDer(row, col) = ECHMETRealToDouble(raw[indices[charged[row]]]);
 }
 
 EMMatrix makeMatrixD1(const CalculatorSystemPack &systemPack, const ERVector &diffusionCoefficients)
@@ -148,47 +102,22 @@ EMMatrix makeMatrixD1(const CalculatorSystemPack &systemPack, const ERVector &di
 	const size_t COLS = systemPack.ionicForms.size();
 	const size_t H3O_idx = COLS - 2;
 	const size_t OH_idx = COLS - 1;
-	EMMatrix DOne{ROWS, COLS};
-
-	const CalculatorConstituentVec &ccVec = systemPack.constituents;
-	const CalculatorIonicFormVec &ifVec = systemPack.ionicForms;
 
 	ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_D1_DIMS, ROWS, COLS);
 
-	for (size_t row = 0; row < ROWS; row++) {
-		const CalculatorConstituent &c = ccVec.at(row);
-
-		const double uIcIFSum = [](const CalculatorConstituent &c, const double conductivity) {
-			double s = 0.0;
-
-			ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_D1_UICIF_BLOCK, c.name.c_str());
-
-			for (size_t idx = 0; idx < c.ionicForms.size(); idx++) {
-				const CalculatorIonicForm *iF = c.ionicForms.at(idx);
+	const EMColVector uIcIF = conductivityTerms(systemPack) * PhChConsts::F / (systemPack.conductivity * 1.0e9);
+	EMColVector charges = systemPack.ionicFormArrays.charges;
 
-				const int d = (iF->internalIonicForm->ligand != nullptr) ? iF->internalIonicForm->ligandCount : 1;
-				s += iF->concentration * iF->mobility * cxsgn(iF->charge) * d;
-				ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_D1_UICIF_INTERMEDIATE, s, iF, d);
-			}
+	/* H3O+ and OH- are in the last two columns and the conductivity term
+	 * enters their columns with a positive sign */
+	charges(H3O_idx) = -1.0;
+	charges(OH_idx) = -1.0;
 
-			return s * PhChConsts::F / (conductivity * 1.0e9);
-		}(c, systemPack.conductivity);
+	const Eigen::Map<const EMColVector> diffCoeffs{diffusionCoefficients.data(), static_cast<Eigen::Index>(COLS)};
 
-		for (size_t col = 0; col < COLS - 2; col++) {
-			const CalculatorIonicForm *iF = ifVec.at(col);
-			const auto &multiplicities = iF->multiplicities;
-			const double diffCoeff = diffusionCoefficients.at(col);
-			const int d = multiplicity(row, multiplicities);
-
-			ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_D1_ROW_BLOCK, std::cref(iF->name), d, col, diffCoeff);
-
-			DOne(row, col) = (d - uIcIFSum * iF->charge) * diffCoeff;
-		}
-
-		/* H3O+ and OH- are in the last two columns */
-		DOne(row, H3O_idx) = uIcIFSum * diffusionCoefficients.at(H3O_idx);
-		DOne(row, OH_idx) = uIcIFSum * diffusionCoefficients.at(OH_idx);
-	}
+	EMMatrix DOne = EMMatrix(systemPack.multiplicities);
+	DOne.noalias() -= uIcIF * charges.transpose();
+	DOne *= diffCoeffs.asDiagonal();
 
 	ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_D1_OUTPUT, std::cref(DOne), std::cref(systemPack.constituents), std::cref(systemPack.ionicForms));
 
@@ -212,73 +141,55 @@ EMMatrix makeMatrixD2(const CalculatorSystemPack &systemPack, const DeltaPackVec
 	return DTwo;
 }
 
-EMMatrix makeMatrixM1(const CalculatorSystemPack &systemPack)
+/*!
+ * Builds matrix M1 over the charged ionic forms only. Uncharged forms have <tt>sgn(z) = |z| = 0</tt>
+ * so their columns of M1 are zero and they would not contribute to any product with M1.
+ */
+MatrixM1 makeMatrixM1(const CalculatorSystemPack &systemPack)
 {
-	const size_t ROWS = systemPack.constituents.size();
-	const size_t COLS = systemPack.ionicForms.size();
-	const size_t H3O_idx = COLS - 2;
-	const size_t OH_idx = COLS - 1;
-	EMMatrix MOne{ROWS, COLS};
+	const IonicFormArrays &arrays = systemPack.ionicFormArrays;
 
-	const CalculatorConstituentVec &ccVec = systemPack.constituents;
-	const CalculatorIonicFormVec &ifVec = systemPack.ionicForms;
+	const size_t ROWS = systemPack.constituents.size();
+	const size_t COLS = arrays.chargedIndices.size();
 
 	ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_M1_DIMS, ROWS, COLS);
 
-	for (size_t row = 0; row < ROWS; row++) {
-		const CalculatorConstituent &c = ccVec.at(row);
+	EMColVector a = conductivityTerms(systemPack) * PhChConsts::F / (systemPack.conductivity * 1.0e9);
+	EMColVector b = arrays.chargedSelector.transpose() * arrays.absCharges.cwiseProduct(arrays.mobilities);
 
-		const double uIcIFSum = [](const CalculatorConstituent &c, const double conductivity) {
-			double s = 0.0;
+	/* Only the constituents that an ionic form is made of contribute to the sparse part.
+	 * Columns of H3O+ and OH- are empty. */
+	EMSparseMatrix S = systemPack.multiplicities * arrays.signs.cwiseProduct(arrays.mobilities).asDiagonal() * arrays.chargedSelector;
+	S.prune(0.0);
 
-			ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_M1_UICIF_BLOCK, c.name.c_str());
-
-			for (size_t idx = 0; idx < c.ionicForms.size(); idx++) {
-				const CalculatorIonicForm *iF = c.ionicForms.at(idx);
-
-				const int d = (iF->internalIonicForm->ligand != nullptr) ? iF->internalIonicForm->ligandCount : 1;
-				s += iF->concentration * iF->mobility * cxsgn(iF->charge) * d;
-				ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_M1_UICIF_INTERMEDIATE, s, iF, d);
-			}
-
-			return s * PhChConsts::F / (conductivity * 1.0e9);
-		}(c, systemPack.conductivity);
-
-		for (size_t col = 0; col < COLS - 2; col++) {
-			const CalculatorIonicForm *iF = ifVec.at(col);
-			const auto &multiplicities = iF->multiplicities;
-			const int32_t charge = iF->charge;
-			const double mobility = iF->mobility;
-			const int d = multiplicity(row, multiplicities);
-
-			ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_M1_ROW_BLOCK, std::cref(c.name), std::cref(iF->name), d, col, mobility);
-
-			MOne(row, col) = (d * cxsgn(charge) - uIcIFSum * std::abs(charge)) * mobility;
-		}
-
-		/* H3O+ and OH- are in the last two columns */
-		MOne(row, H3O_idx) = -uIcIFSum * ifVec.at(H3O_idx)->mobility;
-		MOne(row, OH_idx) = -uIcIFSum * ifVec.at(OH_idx)->mobility;
-	}
+	MatrixM1 MOne{std::move(S), std::move(a), std::move(b)};
 
-	ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_M1_OUTPUT, std::cref(MOne), std::cref(systemPack.constituents), std::cref(systemPack.ionicForms));
+	ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_M1_OUTPUT, std::cref(MOne), std::cref(systemPack.constituents), std::cref(systemPack.ionicForms), std::cref(arrays.chargedIndices));
 
 	return MOne;
 }
 
+/*!
+ * Builds matrix M2 over the charged ionic forms only to match the columns of M1.
+ */
 EMMatrix makeMatrixM2(const CalculatorSystemPack &systemPack, const DeltaPackVec &deltaPacks)
 {
-	const size_t ROWS = systemPack.ionicForms.size();
+	const std::vector<size_t> &charged = systemPack.ionicFormArrays.chargedIndices;
+
+	const size_t ROWS = charged.size();
 	const size_t COLS = systemPack.constituents.size();
 	EMMatrix MTwo{ROWS, COLS};
 
 	ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_M2_DIMS, ROWS, COLS);
 
-	for (size_t col = 0; col < COLS; col++)
-		MTwo.col(col) = deltaPacks.at(col).concentrationDeltas;
+	for (size_t col = 0; col < COLS; col++) {
+		const EMVector &deltas = deltaPacks.at(col).concentrationDeltas;
 
+		for (size_t row = 0; row < ROWS; row++)
+			MTwo(row, col) = deltas(charged[row]);
+	}
 
-	ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_M2_OUTPUT, std::cref(MTwo), std::cref(systemPack.constituents), std::cref(systemPack.ionicForms));
+	ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_M2_OUTPUT, std::cref(MTwo), std::cref(systemPack.constituents), std::cref(systemPack.ionicForms), std::cref(charged));
 
 	return MTwo;
 }
@@ -308,72 +219,28 @@ ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_M2_DIMS, const size_t rows, c
 }
 ECHMET_END_MAKE_LOGGER
 
-ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_MATRIX_M1_UICIF_BLOCK, "Matrix M1 uIcIF intermediate block beginning")
-ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_M1_UICIF_BLOCK, const char *block)
-{
-	std::ostringstream ss{};
-
-	ss << "Entering Matrix M1 uIcIF block " << block;
-	return ss.str();
-}
-ECHMET_END_MAKE_LOGGER
-
-ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_MATRIX_M1_UICIF_INTERMEDIATE, "Matrix M1 uIcIF intermediate block output")
-ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_M1_UICIF_INTERMEDIATE, const double s, const ECHMET::LEMNG::Calculator::CalculatorIonicForm *ccIf, const int d)
-{
-	std::ostringstream ss{};
-	const std::string &name = ccIf->name;
-
-	ss << "Entering Matrix M1 uIcIF intermediate(" << name << "):\n"
-	   << "s(current) = " << s << "\n"
-	   << "concentration = " << ccIf->concentration << "\n"
-	   << "totalCharge = " << ccIf->charge << "\n"
-	   << "mobility = " << ccIf->mobility << "\n"
-	   << "ligand " << [](const auto iF) {
-		   if (iF->ligand == nullptr)
-			   return "(NO LIGAND)";
-		   else
-			   return iF->ligand->name->c_str();
-	   }(ccIf->internalIonicForm)
-	   << " multiplicity = " << d << "\n";
-
-	return ss.str();
-}
-ECHMET_END_MAKE_LOGGER
-
-ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_MATRIX_M1_ROW_BLOCK, "Matrix M1 row block")
-ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_M1_ROW_BLOCK, const std::string &cName, const std::string &iFName, const int mul, const size_t col, const double mobility)
-{
-	std::ostringstream ss{};
-
-	ss << "M1 row block[" << cName << "], multiplicity = " << mul << ", col = " << col << "[" << iFName << "], mobility = " << mobility;
-
-	return ss.str();
-}
-ECHMET_END_MAKE_LOGGER
-
 ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_MATRIX_M1_OUTPUT, "Matrix M1 output")
-ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_M1_OUTPUT, const ECHMET::LEMNG::Calculator::EMMatrix &MOne, const ECHMET::LEMNG::Calculator::CalculatorConstituentVec &ccVec, const ECHMET::LEMNG::Calculator::CalculatorIonicFormVec &cIfVec)
+ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_M1_OUTPUT, const ECHMET::LEMNG::Calculator::MatrixM1 &MOne, const ECHMET::LEMNG::Calculator::CalculatorConstituentVec &ccVec, const ECHMET::LEMNG::Calculator::CalculatorIonicFormVec &cIfVec, const std::vector<size_t> &chargedIndices)
 {
 	std::ostringstream ss{};
 
 	ss << "-- Matrix M1 --\n";
 	ss << "Columns -> ";
-	for (auto *iF : cIfVec)
-		ss << iF->name << "; ";
+	for (const size_t idx : chargedIndices)
+		ss << cIfVec[idx]->name << "; ";
 	ss << "\nRows -> ";
 	for (auto &cc : ccVec)
 		ss << cc.name << "; ";
 	ss << "\n";
 
-	ss << "---\n\n" << MOne << "\n\n---";
+	ss << "---\n\n" << MOne.dense() << "\n\n---";
 
 	return ss.str();
 }
 ECHMET_END_MAKE_LOGGER
 
 ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_MATRIX_M2_OUTPUT, "Matrix M2 output")
-ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_M2_OUTPUT, const ECHMET::LEMNG::Calculator::EMMatrix &MTwo, const ECHMET::LEMNG::Calculator::CalculatorConstituentVec &ccVec, const ECHMET::LEMNG::Calculator::CalculatorIonicFormVec &cIfVec)
+ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_M2_OUTPUT, const ECHMET::LEMNG::Calculator::EMMatrix &MTwo, const ECHMET::LEMNG::Calculator::CalculatorConstituentVec &ccVec, const ECHMET::LEMNG::Calculator::CalculatorIonicFormVec &cIfVec, const std::vector<size_t> &chargedIndices)
 {
 	std::ostringstream ss{};
 
@@ -382,8 +249,8 @@ ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_M2_OUTPUT, const ECHMET::LEMN
 	for (auto &cc : ccVec)
 		ss << cc.name << "; ";
 	ss << "\nColumns ->";
-	for (auto *iF : cIfVec)
-		ss << iF->name << "; ";
+	for (const size_t idx : chargedIndices)
+		ss << cIfVec[idx]->name << "; ";
 
 	ss << "\n";
 
@@ -407,70 +274,13 @@ ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_DM1_INPUT, const double baseC
 }
 ECHMET_END_MAKE_LOGGER
 
-ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_MATRIX_DM1_UICIDKDC, "dM1/dC dConductivity/dC")
-ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_DM1_UICIDKDC, const double s, const double mobility, const int32_t absCharge, const int d)
-{
-	std::ostringstream ss{};
-
-	ss << "dM1/dC dConductivity/dC\n"
-	   << "s = " << s << ", mobility = " << mobility << ", charge = " << absCharge << ", multiplicity = " << d;
-
-	return ss.str();
-}
-ECHMET_END_MAKE_LOGGER
-
-ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_MATRIX_DM1_UIDCIDCJ, "dM1/dC dCi/dCj")
-ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_DM1_UIDCIDCJ, const std::string &name, const size_t gIdx, const double cDelta, const double s, const double d)
-{
-	std::ostringstream ss{};
-
-	ss << "dM1/dC dCi/dCj\n"
-	   << name << ", Global IFIdx = " << gIdx << ", concDelta = " << cDelta << ", s = " << s << ", multiplicity = " << d;
-
-	return ss.str();
-}
-ECHMET_END_MAKE_LOGGER
-
-ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_MATRIX_DM1_KRD, "dM1/dC Kroenecker delta")
-ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_DM1_KRD, const int KrD)
-{
-	return std::string{"Kroenecker delta = "} + std::to_string(KrD);
-}
-ECHMET_END_MAKE_LOGGER
-
-ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_MATRIX_DM1_ROW_BLOCK, "dM1/dC row block")
-ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_DM1_ROW_BLOCK, const double uIcIcKdC, const double uIdcIdcJ, const double termTwo, const double H3OMob, const double OHMob)
-{
-	std::ostringstream ss{};
-
-	ss << "dM1/dC row block\n"
-	   << "uIcIcKcD = " << uIcIcKdC << ", uIdcIdcJ = " << uIdcIdcJ << "\n"
-	   << "termTwo = " << termTwo
-	   << "water mobs = " << H3OMob << ", " << OHMob;
-
-	return ss.str();
-}
-ECHMET_END_MAKE_LOGGER
-
 ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_MATRIX_DM1_OUTPUT, "dM1/dC output")
-ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_DM1_OUTPUT, const ECHMET::LEMNG::Calculator::EMMatrix &MOneDer)
-{
-	std::ostringstream ss{};
-
-	ss << "-- Matrix dM1/dC --\n"
-	   << "---\n\n" << MOneDer << "\n\n---";
-
-	return ss.str();
-}
-ECHMET_END_MAKE_LOGGER
-
-ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_MATRIX_DM2_OUTPUT, "dM2/dC output")
-ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_DM2_OUTPUT, const ECHMET::LEMNG::Calculator::EMMatrix &MTwoDer)
+ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_DM1_OUTPUT, const ECHMET::LEMNG::Calculator::EMMatrix &T)
 {
 	std::ostringstream ss{};
 
-	ss << "-- Matrix dM2/dC --\n"
-	   << "---\n\n" << MTwoDer << "\n\n---";
+	ss << "-- Matrix of dM1/dC rank-one factors --\n"
+	   << "---\n\n" << T << "\n\n---";
 
 	return ss.str();
 }
@@ -496,17 +306,6 @@ ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_D2_DIMS, const size_t rows, c
 }
 ECHMET_END_MAKE_LOGGER
 
-ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_MATRIX_D1_ROW_BLOCK, "Matrix D1 row block")
-ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_D1_ROW_BLOCK, const std::string &name, const int mul, const size_t col, const double diffCoeff)
-{
-	std::ostringstream ss{};
-
-	ss << "D1 row block[" << name << "], multiplicity = " << mul << ", col = " << col << ", diffCoeff = " << diffCoeff;
-
-	return ss.str();
-}
-ECHMET_END_MAKE_LOGGER
-
 ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_MATRIX_D1_OUTPUT, "Matrix D1 output")
 ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_D1_OUTPUT, const ECHMET::LEMNG::Calculator::EMMatrix &DOne, const ECHMET::LEMNG::Calculator::CalculatorConstituentVec &ccVec, const ECHMET::LEMNG::Calculator::CalculatorIonicFormVec &cIfVec)
 {
@@ -547,34 +346,14 @@ ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_D2_OUTPUT, const ECHMET::LEMN
 }
 ECHMET_END_MAKE_LOGGER
 
-ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_MATRIX_D1_UICIF_BLOCK, "Matrix D1 uIcIF intermediate block beginning")
-ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_D1_UICIF_BLOCK, const char *block)
+ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_MATRIX_UICIF_OUTPUT, "Conductivity terms of constituents")
+ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_UICIF_OUTPUT, const ECHMET::LEMNG::Calculator::EMColVector &uIcI, const ECHMET::LEMNG::Calculator::CalculatorConstituentVec &ccVec)
 {
 	std::ostringstream ss{};
 
-	ss << "Entering Matrix D1 uIcIF block " << block;
-	return ss.str();
-}
-ECHMET_END_MAKE_LOGGER
-
-ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_MATRIX_D1_UICIF_INTERMEDIATE, "Matrix D1 uIcIF intermediate block output")
-ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_D1_UICIF_INTERMEDIATE, const double s, const ECHMET::LEMNG::Calculator::CalculatorIonicForm *ccIf, const int d)
-{
-	std::ostringstream ss{};
-	const std::string &name = ccIf->name;
-
-	ss << "Entering Matrix D1 uIcIF intermediate(" << name << "):\n"
-	   << "s(current) = " << s << "\n"
-	   << "concentration = " << ccIf->concentration << "\n"
-	   << "totalCharge = " << ccIf->charge << "\n"
-	   << "mobility = " << ccIf->mobility << "\n"
-	   << "ligand " << [](const auto iF) {
-		   if (iF->ligand == nullptr)
-			   return "(NO LIGAND)";
-		   else
-			   return iF->ligand->name->c_str();
-	   }(ccIf->internalIonicForm)
-	   << " multiplicity = " << d << "\n";
+	ss << "Conductivity terms uIcIF:\n";
+	for (size_t idx = 0; idx < ccVec.size(); idx++)
+		ss << ccVec.at(idx).name << " = " << uIcI(idx) << "\n";
 
 	return ss.str();
 }
@@ -16,6 +16,18 @@ namespace Calculator {
 
 typedef std::vector<EMMatrix> EMMatrixVec;
 
+/*!
+ * Factors of the rank-one updates that make up derivatives of matrix M1
+ * with respect to concentrations of all constituents
+ */
+class M1DerivativeFactors {
+public:
+	M1DerivativeFactors(EMColVector &&conductivityRatios, EMMatrix &&T) noexcept;
+
+	const EMColVector conductivityRatios;	/*!< <tt>dK_J / K</tt> for each constituent \p J */
+	const EMMatrix T;			/*!< Column \p J is the rank-one factor <tt>t_J</tt> of <tt>dM1/dc_J</tt> */
+};
+
 CalculatorSystemPack makeIonicFormPack(const ChemicalSystemPtr &BGESystem, const CalculatedPropertiesPtr &BGEcalcProps,
 				       const ChemicalSystemPtr &fullSystem, CalculatedPropertiesPtr &fullCalcProps,
 				       const RealVecPtr &analConcsBGE,
@@ -23,10 +35,11 @@ CalculatorSystemPack makeIonicFormPack(const ChemicalSystemPtr &BGESystem, const
 				       const bool correctForIonicStrength);
 EMMatrix makeMatrixD1(const CalculatorSystemPack &systemPack, const ERVector &diffusionCoefficients);
 EMMatrix makeMatrixD2(const CalculatorSystemPack &systemPack, const DeltaPackVec &deltaPacks);
-EMMatrix makeMatrixM1(const CalculatorSystemPack &systemPack);
+MatrixM1 makeMatrixM1(const CalculatorSystemPack &systemPack);
 EMMatrix makeMatrixM2(const CalculatorSystemPack &systemPack, const DeltaPackVec &deltaPacks);
-EMMatrix makeM1Derivative(const CalculatorSystemPack &systemPack, const DeltaPack &deltaPack) noexcept;
-EMMatrix makeM2Derivative(const CalculatorSystemPack &systemPack, const RealVecPtr &analyticalConcentrations, const SysComp::Constituent *pivotalConstituent, CAES::Solver *solver, RealVec *derivatives);
+M1DerivativeFactors makeM1DerivativeFactors(const CalculatorSystemPack &systemPack, const DeltaPackVec &deltaPacks, const EMMatrix &MTwo);
+void makeM2DerivativeColumn(const CalculatorSystemPack &systemPack, const RealVec *analyticalConcentrations, const SysComp::Constituent *pivotalConstituent, const size_t col,
+			    CAES::Solver *solver, RealVec *derivatives, EMMatrix &MTwoDer);
 
 } // namespace Calculator
 } // namespace LEMNG
@@ -3,7 +3,9 @@
 #include "calculator_matrices.h"
 #include "calculator_linear.h"
 #include "helpers.h"
+#include <algorithm>
 #include <future>
+#include <thread>
 
 #ifndef ECHMET_IMPORT_INTERNAL
 #define ECHMET_IMPORT_INTERNAL
@@ -24,14 +26,24 @@ EigenzoneDispersion::EigenzoneDispersion(const double a2t, const double uEMD) :
 {
 }
 
+DispersionModel::DispersionModel(std::vector<double> &&a2t, std::vector<double> &&dLdW, EMMatrix &&dLdC) noexcept :
+	a2t(std::move(a2t)),
+	dLdW(std::move(dLdW)),
+	dLdC(std::move(dLdC))
+{
+}
+
 static
-EigenzoneDispersionVec calculateEigenzoneDispersion(const QLQRPack &QLQR, const EMMatrixVec &MDerivatives, const EMMatrix &concentrationDeltas, const EMMatrix &diffMatrix, const size_t NCO)
+DispersionModel calculateDispersionParameters(const QLQRPack &QLQR, const EMMatrixVec &MDerivatives, const EMMatrix &diffMatrix, const size_t NCO)
 {
 	const EMMatrixC &QL = QLQR.QL();
 	const EMMatrixC &QR = QLQR.QR();
-	EigenzoneDispersionVec ezDisps{};
+	std::vector<double> a2ts{};
+	std::vector<double> dLdWs{};
+	EMMatrix dLdC{NCO, NCO};
 
-	ezDisps.reserve(NCO);
+	a2ts.reserve(NCO);
+	dLdWs.reserve(NCO);
 
 	/* Precalculate QL * dM/dcK * QR products */
 	std::vector<EMMatrixC> LMRs{};
@@ -43,12 +55,6 @@ EigenzoneDispersionVec calculateEigenzoneDispersion(const QLQRPack &QLQR, const
 		LMRs.emplace_back(LMR);
 	}
 
-	/* Transformation to w domain.
-	 * Hruška V, Riesová M, Gaš B, ELECTROPHORESIS 2012, Volume: 33, Pages: 923-930 (DOI: 10.1002/elps.201100554)
-	 * states equation 18 in reverse order c = QR * w, we use QL to get w from concentration deltas.
-	 */
-	const EMMatrixC wVec = QL * concentrationDeltas;
-
 	/* Diffusive parameters */
 	const EMMatrixC LDiffR = QL * diffMatrix * QR;
 
@@ -64,8 +70,7 @@ EigenzoneDispersionVec calculateEigenzoneDispersion(const QLQRPack &QLQR, const
 			return v;
 		}(idx);
 
-		/* Calculate uEMD parameter of the eigenzone
-		 * Step 1: Calculate dLambda/dW
+		/* Calculate dLambda/dW
 		 * Uses equation 22 from Hruška V, Riesová M, Gaš B, ELECTROPHORESIS 2012, Volume: 33, Pages: 923-930 (DOI: 10.1002/elps.201100554)
 		 */
 		double dLdW = 0.0;
@@ -77,64 +82,68 @@ EigenzoneDispersionVec calculateEigenzoneDispersion(const QLQRPack &QLQR, const
 		for (size_t k = 0; k < NCO; k++)
 			dLdW += QR(k, idx).real() * LMRs.at(k)(idx, idx).real();
 
-		/* Step 2: Calculate uEMD */
-		const double uEMD = dLdW * wVec(idx).real();
+		/* First-order perturbation of the eigenvalue, dLambda_i/dc_k = (QL * dM/dc_k * QR)_ii.
+		 * dM/dc_k is evaluated at the BGE-like composition the eigenvectors come from. */
+		for (size_t k = 0; k < NCO; k++)
+			dLdC(idx, k) = LMRs.at(k)(idx, idx).real();
 
-		ezDisps.emplace_back(a2t, uEMD);
+		a2ts.emplace_back(a2t);
+		dLdWs.emplace_back(dLdW);
 	}
 
-	return ezDisps;
+	return DispersionModel{std::move(a2ts), std::move(dLdWs), std::move(dLdC)};
 }
 
 static
-EMMatrixVec calculateMDerivatives(const EMMatrix &MOne, const EMMatrix &MTwo, const EMMatrixVec &MOneDerivatives, const EMMatrixVec &MTwoDerivatives)
+EigenzoneDispersionVec calculateEigenzoneDispersion(const DispersionModel &dispModel, const QLQRPack &QLQR, const EMMatrix &concentrationDeltas, const size_t NCO)
 {
-	EMMatrixVec MDerivatives{};
-	MDerivatives.reserve(MOneDerivatives.size());
-
-#ifdef ECHMET_LEMNG_PARALLEL_NUM_OPS
-	const auto worker = [&](const size_t idx) -> EMMatrix {
-		const EMMatrix MLeft = MOneDerivatives.at(idx) * MTwo;
-		const EMMatrix MRight = MOne * MTwoDerivatives.at(idx);
-
-		return MLeft + MRight;
-	};
-
-	const size_t N = MOneDerivatives.size();
+	const EMMatrixC &QL = QLQR.QL();
+	EigenzoneDispersionVec ezDisps{};
 
-	std::vector<std::future<EMMatrix>> results{};
-	results.reserve(N);
+	ezDisps.reserve(NCO);
 
-	for (size_t idx = 0; idx < N; idx++)
-		results.emplace_back(std::async(std::launch::async, worker, idx));
+	/* Transformation to w domain.
+	 * Hruška V, Riesová M, Gaš B, ELECTROPHORESIS 2012, Volume: 33, Pages: 923-930 (DOI: 10.1002/elps.201100554)
+	 * states equation 18 in reverse order c = QR * w, we use QL to get w from concentration deltas.
+	 */
+	const EMMatrixC wVec = QL * concentrationDeltas;
 
-	for (auto &f: results)
-		MDerivatives.emplace_back(f.get());
-#else // ECHMET_LEMNG_PARALLEL_NUM_OPS
-	for (size_t idx = 0; idx < MOneDerivatives.size(); idx++) {
-		const EMMatrix MLeft = MOneDerivatives.at(idx) * MTwo;
-		const EMMatrix MRight = MOne * MTwoDerivatives.at(idx);
+	for (size_t idx = 0; idx < NCO; idx++) {
+		const double uEMD = dispModel.dLdW.at(idx) * wVec(idx).real();
 
-		MDerivatives.emplace_back(MLeft + MRight);
+		ezDisps.emplace_back(dispModel.a2t.at(idx), uEMD);
 	}
-#endif // ECHMET_LEMNG_PARALLEL_NUM_OPS
 
-	return MDerivatives;
+	return ezDisps;
 }
 
+/*!
+ * Calculates <tt>dM/dc_J = dM1/dc_J * M2 + M1 * dM2/dc_J</tt> for all constituents.
+ * <tt>dM1/dc_J * M2</tt> is assembled from products <tt>S * M2</tt> and <tt>b^T * M2</tt>
+ * that are shared by all constituents.
+ */
 static
-EMMatrixVec calculateM1Derivatives(const CalculatorSystemPack &systemPack, const DeltaPackVec &deltaPacks)
+EMMatrixVec calculateMDerivatives(const MatrixM1 &MOne, const EMMatrix &MTwo, const M1DerivativeFactors &MOneDerFactors, const EMMatrixVec &MTwoDerivatives)
 {
-	EMMatrixVec M1Derivatives{};
+	EMMatrixVec MDerivatives{};
+	MDerivatives.reserve(MTwoDerivatives.size());
+
+	const EMMatrix SM2 = MOne.S * MTwo;
+	const EMVector bM2 = MOne.b.transpose() * MTwo;
 
-	M1Derivatives.reserve(deltaPacks.size());
+	const auto left = [&](const size_t idx) -> EMMatrix {
+		EMMatrix MLeft = -MOneDerFactors.conductivityRatios(idx) * SM2;
+		MLeft.noalias() += MOneDerFactors.T.col(idx) * bM2;
+
+		return MLeft;
+	};
 
 #ifdef ECHMET_LEMNG_PARALLEL_NUM_OPS
 	const auto worker = [&](const size_t idx) -> EMMatrix {
-		return makeM1Derivative(systemPack, deltaPacks.at(idx));
+		return left(idx) + MOne.multiply(MTwoDerivatives.at(idx));
 	};
 
-	const size_t N = deltaPacks.size();
+	const size_t N = MTwoDerivatives.size();
 
 	std::vector<std::future<EMMatrix>> results{};
 	results.reserve(N);
@@ -142,25 +151,55 @@ EMMatrixVec calculateM1Derivatives(const CalculatorSystemPack &systemPack, const
 	for (size_t idx = 0; idx < N; idx++)
 		results.emplace_back(std::async(std::launch::async, worker, idx));
 
-	for (auto &f : results)
-		M1Derivatives.emplace_back(f.get());
+	for (auto &f: results)
+		MDerivatives.emplace_back(f.get());
 #else // ECHMET_LEMNG_PARALLEL_NUM_OPS
-	for (const auto &dPack : deltaPacks)
-		M1Derivatives.emplace_back(makeM1Derivative(systemPack, dPack));
+	for (size_t idx = 0; idx < MTwoDerivatives.size(); idx++)
+		MDerivatives.emplace_back(left(idx) + MOne.multiply(MTwoDerivatives.at(idx)));
 #endif // ECHMET_LEMNG_PARALLEL_NUM_OPS
 
-	return M1Derivatives;
+	return MDerivatives;
 }
 
+/*!
+ * Calculates the whole tensor of M2 derivatives by finite differences.
+ * Each (pivotal constituent, column) pair requires a separate numerical
+ * cross derivative solved by CAES.
+ *
+ * There is no analytic second-derivative path that would obtain the whole tensor
+ * from one factorization of the equilibrium Jacobian. It cannot be implemented on top
+ * of the current CAES interface which exposes neither the Jacobian of the equilibrium
+ * system nor its derivatives. The pairs are merely distributed among a bounded number
+ * of workers that share one derivator context and write directly into the result;
+ * this changes the scheduling, not the number of solves.
+ *
+ * Second derivatives do not depend on the order of differentiation so
+ * column \p k of the derivative by constituent \p j equals column \p j of the
+ * derivative by constituent \p k. Only pairs with <tt>j <= k</tt> are calculated,
+ * the rest is mirrored.
+ */
 static
 EMMatrixVec calculateM2Derivatives(const CalculatorSystemPack &systemPack, const RealVecPtr &analyticalConcentrations, const NonidealityCorrections corrections)
 {
 	const size_t NCO = systemPack.constituents.size();
-	EMMatrixVec M2Derivatives{};
-
-	M2Derivatives.reserve(NCO);
+	const size_t NCH = systemPack.ionicFormArrays.chargedIndices.size();
+	EMMatrixVec M2Derivatives(NCO, EMMatrix{NCH, NCO});
+
+	std::vector<std::pair<size_t, size_t>> tasks{};
+	tasks.reserve(NCO * (NCO + 1) / 2);
+	for (size_t pivot = 0; pivot < NCO; pivot++) {
+		for (size_t col = pivot; col < NCO; col++)
+			tasks.emplace_back(pivot, col);
+	}
+	const size_t NTasks = tasks.size();
 
 	const SysComp::ChemicalSystem &chemSystemRaw = *systemPack.chemSystemRaw;
+#ifdef ECHMET_LEMNG_SENSITIVE_NUMDERS
+	(void)analyticalConcentrations;
+	const RealVecPtr analyticalConcentrationsForDiffs = makeAnalyticalConcentrationsForDerivator(systemPack);
+#else
+	const RealVecPtr &analyticalConcentrationsForDiffs = analyticalConcentrations;
+#endif // ECHMET_LEMNG_SENSITIVE_NUMDERS
 
 	CAES::Solver *solver = nullptr;
 	::ECHMET::RealVec *derivatives = nullptr;
@@ -169,9 +208,31 @@ EMMatrixVec calculateM2Derivatives(const CalculatorSystemPack &systemPack, const
 	if (tRet != ::ECHMET::RetCode::OK)
 		throw CalculationException{std::string{"Cannot make derivator context: "} + std::string{errorToString(tRet)}, coreLibsErrorToNativeError(tRet)};
 
+	const auto releaseContext = [&]() {
+		solver->context()->destroy();
+		solver->destroy();
+		derivatives->destroy();
+	};
+
+	const auto calculateTasks = [&](RealVec *_derivatives, const size_t first, const size_t stride) {
+		for (size_t task = first; task < NTasks; task += stride) {
+			const size_t pivot = tasks[task].first;
+			const size_t col = tasks[task].second;
+			const SysComp::Constituent *pivotalConstituent = systemPack.constituents.at(pivot).internalConstituent;
+
+			makeM2DerivativeColumn(systemPack, analyticalConcentrationsForDiffs.get(), pivotalConstituent, col, solver, _derivatives, M2Derivatives[pivot]);
+		}
+	};
+
 #ifdef ECHMET_LEMNG_PARALLEL_NUM_OPS
-	const auto worker = [&](const size_t idx) -> EMMatrix {
-		const SysComp::Constituent *pivotalConstituent = systemPack.constituents.at(idx).internalConstituent;
+	const size_t NWorkers = [NTasks]() -> size_t {
+		const size_t n = std::thread::hardware_concurrency();
+		if (n < 1)
+			return 1;
+		return std::min(n, std::max(NTasks, size_t(1)));
+	}();
+
+	const auto worker = [&](const size_t first) {
 		RealVec *_derivatives = ::ECHMET::createRealVec(derivatives->size());
 		if (_derivatives == nullptr)
 			throw CalculationException{"Cannot allocate thread-local derivatives vector", RetCode::E_NO_MEMORY};
@@ -180,62 +241,62 @@ EMMatrixVec calculateM2Derivatives(const CalculatorSystemPack &systemPack, const
 			throw CalculationException{"Cannot resize thread-local derivatives vector", RetCode::E_NO_MEMORY};
 		}
 
-		const EMMatrix res = makeM2Derivative(systemPack, analyticalConcentrations, pivotalConstituent, solver, _derivatives);
+		try {
+			calculateTasks(_derivatives, first, NWorkers);
+		} catch (...) {
+			_derivatives->destroy();
+			throw;
+		}
 		_derivatives->destroy();
-		return res;
 	};
 
-	std::vector<std::future<EMMatrix>> results{};
+	std::vector<std::future<void>> results{};
 	try {
-		results.reserve(NCO);
+		results.reserve(NWorkers);
 	} catch (std::bad_alloc &) {
-		solver->context()->destroy();
-		solver->destroy();
-		derivatives->destroy();
+		releaseContext();
 		throw;
 	}
 
 	try {
-		for (size_t idx = 0; idx < NCO; idx++)
+		for (size_t idx = 0; idx < NWorkers; idx++)
 			results.emplace_back(std::async(std::launch::async, worker, idx));
 
 		for (auto &f : results)
-			M2Derivatives.emplace_back(f.get());
-	} catch (CalculationException &) {
-			for (auto &f : results) {
-				if (f.valid())
-					f.wait();
-			}
-
-			solver->context()->destroy();
-			solver->destroy();
-			derivatives->destroy();
-			throw;
+			f.get();
+	} catch (...) {
+		for (auto &f : results) {
+			if (f.valid())
+				f.wait();
+		}
+
+		releaseContext();
+		throw;
 	}
 #else // ECHMET_LEMNG_PARALLEL_NUM_OPS
-	for (size_t idx = 0; idx < NCO; idx++) {
-		const SysComp::Constituent *pivotalConstituent = systemPack.constituents.at(idx).internalConstituent;
-
-		try {
-			M2Derivatives.emplace_back(makeM2Derivative(systemPack, analyticalConcentrations, pivotalConstituent, solver, derivatives));
-		} catch (CalculationException &ex) {
-			solver->context()->destroy();
-			solver->destroy();
-			derivatives->destroy();
-			throw CalculationException{"Cannot calculate concentration derivatives for M2 derivative", coreLibsErrorToNativeError(tRet)};
-		}
+	try {
+		calculateTasks(derivatives, 0, 1);
+	} catch (CalculationException &) {
+		releaseContext();
+		throw;
 	}
 #endif // ECHMET_LEMNG_PARALLEL_NUM_OPS
 
-	solver->context()->destroy();
-	solver->destroy();
-	derivatives->destroy();
+	releaseContext();
+
+	for (size_t pivot = 0; pivot < NCO; pivot++) {
+		for (size_t col = pivot + 1; col < NCO; col++)
+			M2Derivatives[col].col(pivot) = M2Derivatives[pivot].col(col);
+	}
+
+	for (const EMMatrix &MTwoDer : M2Derivatives)
+		ECHMET_TRACE(LEMNGTracing, CALC_MATRIX_DM2_OUTPUT, std::cref(MTwoDer));
 
 	return M2Derivatives;
 }
 
 static
-EMMatrix makeDiffusionMatrix(const CalculatorSystemPack &systemPackUncharged, const DeltaPackVec &deltaPackUncharged)
+EMMatrix makeDiffusionMatrix(const CalculatorSystemPack &systemPack, const DeltaPackVec &deltaPacks)
 {
 	static const auto calcDiffCoeff = [](const double mobility, const int32_t charge) {
 		const int32_t _charge = charge == 0 ? 1 : charge;
@@ -243,9 +304,9 @@ EMMatrix makeDiffusionMatrix(const CalculatorSystemPack &systemPackUncharged, co
 		return mobility * ECHMET::PhChConsts::Tlab * ECHMET::PhChConsts::bk / (std::abs(_charge) * ECHMET::PhChConsts::e);
 	};
 
-	const CalculatorIonicFormVec &ionicForms = systemPackUncharged.ionicForms;
+	const CalculatorIonicFormVec &ionicForms = systemPack.ionicForms;
 	const size_t NIF = ionicForms.size();
-	const SysComp::CalculatedProperties *calcPropsRaw = systemPackUncharged.calcPropsRaw;
+	const SysComp::CalculatedProperties *calcPropsRaw = systemPack.calcPropsRaw;
 
 	ERVector diffusionCoefficients{};
 
@@ -337,10 +398,10 @@ EMMatrix makeDiffusionMatrix(const CalculatorSystemPack &systemPackUncharged, co
 		diffusionCoefficients.emplace_back(calcDiffCoeff(mobility, iF->totalCharge));
 	}
 
-	ECHMET_TRACE(LEMNGTracing, CALC_NONLIN_DIFFUSION_COEFFS, std::cref(systemPackUncharged), std::cref(diffusionCoefficients));
+	ECHMET_TRACE(LEMNGTracing, CALC_NONLIN_DIFFUSION_COEFFS, std::cref(systemPack), std::cref(diffusionCoefficients));
 
-	const EMMatrix DOne = makeMatrixD1(systemPackUncharged, diffusionCoefficients);
-	const EMMatrix DTwo = makeMatrixD2(systemPackUncharged, deltaPackUncharged);
+	const EMMatrix DOne = makeMatrixD1(systemPack, diffusionCoefficients);
+	const EMMatrix DTwo = makeMatrixD2(systemPack, deltaPacks);
 
 	const EMMatrix diffMatrix = DOne * DTwo;
 
@@ -364,24 +425,30 @@ EMMatrix makeConcentrationDeltas(const CalculatorSystemPack &systemPack)
 	return deltaCVec;
 }
 
-EigenzoneDispersionVec calculateNonlinear(const CalculatorSystemPack &systemPack, const CalculatorSystemPack &systemPackUncharged,
-					  const RealVecPtr &analyticalConcentrations,
-					  const DeltaPackVec &deltaPacks, const DeltaPackVec &deltaPacksUncharged,
-					  const EMMatrix &M1, const EMMatrix &M2, const QLQRPack &QLQR,
-					  const NonidealityCorrections corrections)
+DispersionModel makeDispersionModel(const CalculatorSystemPack &systemPack,
+				    const RealVecPtr &analyticalConcentrations,
+				    const DeltaPackVec &deltaPacks,
+				    const LinearModel &linModel,
+				    const NonidealityCorrections corrections)
 {
 	ECHMET_TRACE(LEMNGTracing, CALC_NONLIN_PROGRESS, "Starting");
 
-	const EMMatrixVec M1Derivatives = calculateM1Derivatives(systemPack, deltaPacks);
+	const M1DerivativeFactors M1DerFactors = makeM1DerivativeFactors(systemPack, deltaPacks, linModel.M2);
 	const EMMatrixVec M2Derivatives = calculateM2Derivatives(systemPack, analyticalConcentrations, corrections);
 
 	ECHMET_TRACE(LEMNGTracing, CALC_NONLIN_PROGRESS, "Individual matrix derivatives solved");
 
-	const EMMatrix diffMatrix = makeDiffusionMatrix(systemPackUncharged, deltaPacksUncharged);
-	const EMMatrixVec MDerivatives = calculateMDerivatives(M1, M2, M1Derivatives, M2Derivatives);
+	const EMMatrix diffMatrix = makeDiffusionMatrix(systemPack, deltaPacks);
+	const EMMatrixVec MDerivatives = calculateMDerivatives(linModel.M1, linModel.M2, M1DerFactors, M2Derivatives);
+
+	return calculateDispersionParameters(linModel.QLQR, MDerivatives, diffMatrix, systemPack.constituents.size());
+}
+
+EigenzoneDispersionVec calculateNonlinear(const DispersionModel &dispModel, const LinearModel &linModel, const CalculatorSystemPack &systemPack)
+{
 	const EMMatrix deltaCVec = makeConcentrationDeltas(systemPack);
 
-	return calculateEigenzoneDispersion(QLQR, MDerivatives, deltaCVec, diffMatrix, systemPack.constituents.size());
+	return calculateEigenzoneDispersion(dispModel, linModel.QLQR, deltaCVec, systemPack.constituents.size());
 }
 
 } // namespace Calculator
@@ -389,6 +456,18 @@ EigenzoneDispersionVec calculateNonlinear(const CalculatorSystemPack &systemPack
 
 #ifndef ECHMET_TRACER_DISABLE_TRACING
 
+ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_MATRIX_DM2_OUTPUT, "dM2/dC output")
+ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_MATRIX_DM2_OUTPUT, const ECHMET::LEMNG::Calculator::EMMatrix &MTwoDer)
+{
+	std::ostringstream ss{};
+
+	ss << "-- Matrix dM2/dC --\n"
+	   << "---\n\n" << MTwoDer << "\n\n---";
+
+	return ss.str();
+}
+ECHMET_END_MAKE_LOGGER
+
 ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_NONLIN_PROGRESS, "Nonlinear calculations progress reports")
 ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_NONLIN_PROGRESS, const char *stage)
 {
@@ -419,13 +498,13 @@ ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_NONLIN_NERNST_EINST_INPUT, const dou
 ECHMET_END_MAKE_LOGGER
 
 ECHMET_MAKE_TRACEPOINT_NOINLINE(LEMNGTracing, CALC_NONLIN_DIFFUSION_COEFFS, "Diffusion coefficients")
-ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_NONLIN_DIFFUSION_COEFFS, const ECHMET::LEMNG::Calculator::CalculatorSystemPack &systemPackUncharged, const ECHMET::LEMNG::Calculator::ERVector &diffCoeffs)
+ECHMET_BEGIN_MAKE_LOGGER(LEMNGTracing, CALC_NONLIN_DIFFUSION_COEFFS, const ECHMET::LEMNG::Calculator::CalculatorSystemPack &systemPack, const ECHMET::LEMNG::Calculator::ERVector &diffCoeffs)
 {
 	std::ostringstream ss{};
 
 	ss << "-- Diffusion coefficients --\n";
-	for (size_t ifIdx = 0; ifIdx < systemPackUncharged.ionicForms.size(); ifIdx++)
-		ss << systemPackUncharged.ionicForms.at(ifIdx)->name << "; " << diffCoeffs[ifIdx] << "\n";
+	for (size_t ifIdx = 0; ifIdx < systemPack.ionicForms.size(); ifIdx++)
+		ss << systemPack.ionicForms.at(ifIdx)->name << "; " << diffCoeffs[ifIdx] << "\n";
 
 	return ss.str();
 }
@@ -3,6 +3,7 @@
 
 #include "lemng_p.h"
 #include "calculator_types.h"
+#include "calculator_linear.h"
 #include <vector>
 
 namespace ECHMET {
@@ -18,11 +19,28 @@ public:
 };
 typedef std::vector<EigenzoneDispersion> EigenzoneDispersionVec;
 
-EigenzoneDispersionVec calculateNonlinear(const CalculatorSystemPack &systemPack, const CalculatorSystemPack &systemPackUncharged,
-					  const RealVecPtr &analyticalConcentrations,
-					  const DeltaPackVec &deltaPacks, const DeltaPackVec &deltaPacksUncharged,
-					  const EMMatrix &M1, const EMMatrix &M2, const QLQRPack &QLQR,
-					  const NonidealityCorrections corrections);
+/*!
+ * Part of the nonlinear model that depends only on the composition of the background electrolyte.
+ */
+class DispersionModel {
+public:
+	DispersionModel(std::vector<double> &&a2t, std::vector<double> &&dLdW, EMMatrix &&dLdC) noexcept;
+
+	const std::vector<double> a2t;	/*!< Time-independent diffusive parameters of the eigenzones. */
+	const std::vector<double> dLdW;	/*!< Derivatives of the eigenmobilities by the respective w-domain concentrations. */
+	const EMMatrix dLdC;		/*!< Derivatives of the eigenmobilities (rows) by the concentrations of the constituents (columns)
+					     in the BGE-like system. All matrix derivatives are taken at the BGE-like composition
+					     even with \p ECHMET_LEMNG_SENSITIVE_NUMDERS, which changes only the step of the derivator.
+					     Ionic mobilities are held constant, with the Onsager-Fuoss correction their dependence
+					     on the ionic strength enters only through the conductivity. */
+};
+
+DispersionModel makeDispersionModel(const CalculatorSystemPack &systemPack,
+				    const RealVecPtr &analyticalConcentrations,
+				    const DeltaPackVec &deltaPacks,
+				    const LinearModel &linModel,
+				    const NonidealityCorrections corrections);
+EigenzoneDispersionVec calculateNonlinear(const DispersionModel &dispModel, const LinearModel &linModel, const CalculatorSystemPack &systemPack);
 
 } // namespace Calculator
 } // namespace LEMNG
@@ -1,5 +1,11 @@
 #include "calculator_types.h"
 #include "tracing/lemng_tracer_impl.h"
+#include <cstdlib>
+
+#ifndef ECHMET_IMPORT_INTERNAL
+#define ECHMET_IMPORT_INTERNAL
+#endif // ECHMET_IMPORT_INTERNAL
+#include <echmetsyscomp.h>
 
 namespace ECHMET {
 namespace LEMNG {
@@ -16,9 +22,18 @@ CalculatorIonicForm::CalculatorIonicForm(std::string name, const int32_t charge,
 	internalIonicFormConcentrationIdx{ internalIonicFormConcentrationIdx },
 	globalIonicFormConcentrationIdx{ globalIonicFormConcentrationIdx },
 	multiplicities(std::move(multiplicities)),
-	isAnalyte{ isAnalyte },
-	concentration{ -1 },
-	mobility{ -1 }
+	isAnalyte{ isAnalyte }
+{
+}
+
+CalculatorIonicForm::CalculatorIonicForm(const CalculatorIonicForm &other) :
+	name{ other.name },
+	charge{ other.charge },
+	internalIonicForm{ other.internalIonicForm },
+	internalIonicFormConcentrationIdx{ other.internalIonicFormConcentrationIdx },
+	globalIonicFormConcentrationIdx{ other.globalIonicFormConcentrationIdx },
+	multiplicities(other.multiplicities),
+	isAnalyte{ other.isAnalyte }
 {
 }
 
@@ -31,8 +46,6 @@ CalculatorIonicForm & CalculatorIonicForm::operator=(const CalculatorIonicForm &
 	const_cast<size_t&>(globalIonicFormConcentrationIdx) = other.globalIonicFormConcentrationIdx;
 	const_cast<MultiplicityVec&>(multiplicities) = other.multiplicities;
 	const_cast<bool&>(isAnalyte) = other.isAnalyte;
-	mobility = other.mobility;
-	concentration = other.concentration;
 
 	return *this;
 }
@@ -46,12 +59,70 @@ CalculatorIonicForm & CalculatorIonicForm::operator=(CalculatorIonicForm &&other
 	const_cast<size_t&>(globalIonicFormConcentrationIdx) = other.globalIonicFormConcentrationIdx;
 	const_cast<MultiplicityVec&>(multiplicities) = std::move(other.multiplicities);
 	const_cast<bool&>(isAnalyte) = other.isAnalyte;
-	mobility = other.mobility;
-	concentration = other.concentration;
 
 	return *this;
 }
 
+IonicFormArrays::IonicFormArrays()
+{
+}
+
+IonicFormArrays::IonicFormArrays(const CalculatorIonicFormVec &ifVec) :
+	charges{static_cast<Eigen::Index>(ifVec.size())},
+	signs{static_cast<Eigen::Index>(ifVec.size())},
+	absCharges{static_cast<Eigen::Index>(ifVec.size())},
+	concentrations{EMColVector::Constant(ifVec.size(), -1.0)},
+	mobilities{EMColVector::Constant(ifVec.size(), -1.0)}
+{
+	internalConcentrationIndices.reserve(ifVec.size());
+	internalMobilityIndices.reserve(ifVec.size());
+	chargedIndices.reserve(ifVec.size());
+
+	for (size_t idx = 0; idx < ifVec.size(); idx++) {
+		const int32_t charge = ifVec[idx]->charge;
+
+		internalConcentrationIndices.emplace_back(ifVec[idx]->internalIonicFormConcentrationIdx);
+		internalMobilityIndices.emplace_back(ifVec[idx]->internalIonicForm->ionicMobilityIndex);
+		charges(idx) = charge;
+		signs(idx) = (charge > 0) - (charge < 0);
+		absCharges(idx) = std::abs(charge);
+
+		if (charge != 0)
+			chargedIndices.emplace_back(idx);
+	}
+
+	std::vector<Eigen::Triplet<double>> triplets{};
+	triplets.reserve(chargedIndices.size());
+	for (size_t col = 0; col < chargedIndices.size(); col++)
+		triplets.emplace_back(chargedIndices[col], col, 1.0);
+
+	chargedSelector.resize(ifVec.size(), chargedIndices.size());
+	chargedSelector.setFromTriplets(triplets.cbegin(), triplets.cend());
+}
+
+/*!
+ * Builds the constituent x ionic form matrix of weights of ionic forms in the conductivity terms.
+ * Ionic forms that contain a ligand are weighted by the number of ligands, all others by one.
+ */
+static
+EMSparseMatrix makeConductivityWeights(const CalculatorConstituentVec &ccVec, const size_t NIF)
+{
+	std::vector<Eigen::Triplet<double>> triplets{};
+
+	for (size_t row = 0; row < ccVec.size(); row++) {
+		for (const CalculatorIonicForm *iF : ccVec[row].ionicForms) {
+			const int d = (iF->internalIonicForm->ligand != nullptr) ? iF->internalIonicForm->ligandCount : 1;
+
+			triplets.emplace_back(row, iF->globalIonicFormConcentrationIdx, d);
+		}
+	}
+
+	EMSparseMatrix W{static_cast<Eigen::Index>(ccVec.size()), static_cast<Eigen::Index>(NIF)};
+	W.setFromTriplets(triplets.cbegin(), triplets.cend());
+
+	return W;
+}
+
 CalculatorConstituent::CalculatorConstituent(const std::string &name, const CalculatorIonicFormVec &ifVec, const SysComp::Constituent *internalConstituent, const bool isAnalyte) :
 	name{ name },
 	ionicForms(ifVec),
@@ -132,9 +203,13 @@ CalculatorSystemPack::CalculatorSystemPack() :
 {
 }
 
-CalculatorSystemPack::CalculatorSystemPack(const CalculatorConstituentVec &ccVec, const CalculatorIonicFormVec &ifVec, const SysComp::ChemicalSystem *chemSystemRaw, SysComp::CalculatedProperties *calcPropsRaw) :
+CalculatorSystemPack::CalculatorSystemPack(const CalculatorConstituentVec &ccVec, const CalculatorIonicFormVec &ifVec, const EMSparseMatrix &multiplicities,
+					   const SysComp::ChemicalSystem *chemSystemRaw, SysComp::CalculatedProperties *calcPropsRaw) :
 	constituents(ccVec),
 	ionicForms(ifVec),
+	multiplicities(multiplicities),
+	conductivityWeights(makeConductivityWeights(constituents, ionicForms.size())),
+	ionicFormArrays(ionicForms),
 	chemSystemRaw{ chemSystemRaw },
 	calcPropsRaw{ calcPropsRaw },
 	conductivity{ -1 },
@@ -142,9 +217,13 @@ CalculatorSystemPack::CalculatorSystemPack(const CalculatorConstituentVec &ccVec
 {
 }
 
-CalculatorSystemPack::CalculatorSystemPack(CalculatorConstituentVec &&ccVec, CalculatorIonicFormVec &&ifVec, const SysComp::ChemicalSystem *chemSystemRaw, SysComp::CalculatedProperties *calcPropsRaw) noexcept:
+CalculatorSystemPack::CalculatorSystemPack(CalculatorConstituentVec &&ccVec, CalculatorIonicFormVec &&ifVec, EMSparseMatrix &&multiplicities,
+					   const SysComp::ChemicalSystem *chemSystemRaw, SysComp::CalculatedProperties *calcPropsRaw) noexcept:
 	constituents(ccVec),
 	ionicForms(ifVec),
+	multiplicities(std::move(multiplicities)),
+	conductivityWeights(makeConductivityWeights(constituents, ionicForms.size())),
+	ionicFormArrays(ionicForms),
 	chemSystemRaw{ chemSystemRaw },
 	calcPropsRaw{ calcPropsRaw },
 	conductivity{ -1 },
@@ -155,6 +234,9 @@ CalculatorSystemPack::CalculatorSystemPack(CalculatorConstituentVec &&ccVec, Cal
 CalculatorSystemPack::CalculatorSystemPack(CalculatorSystemPack &&other) noexcept :
 constituents(std::move(other.constituents)),
 	ionicForms(std::move(other.ionicForms)),
+	multiplicities(std::move(other.multiplicities)),
+	conductivityWeights(std::move(other.conductivityWeights)),
+	ionicFormArrays(std::move(other.ionicFormArrays)),
 	chemSystemRaw{ other.chemSystemRaw },
 	calcPropsRaw{ other.calcPropsRaw },
 	conductivity{ other.conductivity },
@@ -167,6 +249,9 @@ CalculatorSystemPack & CalculatorSystemPack::operator=(CalculatorSystemPack &&ot
 {
 	constituents = std::move(other.constituents);
 	const_cast<CalculatorIonicFormVec&>(ionicForms) = std::move(other.ionicForms);
+	const_cast<EMSparseMatrix&>(multiplicities) = std::move(other.multiplicities);
+	const_cast<EMSparseMatrix&>(conductivityWeights) = std::move(other.conductivityWeights);
+	ionicFormArrays = std::move(other.ionicFormArrays);
 	chemSystemRaw = other.chemSystemRaw;
 	calcPropsRaw = other.calcPropsRaw;
 	conductivity = other.conductivity;
@@ -227,6 +312,51 @@ const EMMatrixC & QLQRPack::QR() const
 	return *m_QR;
 }
 
+MatrixM1::MatrixM1(EMSparseMatrix &&S, EMColVector &&a, EMColVector &&b) noexcept :
+	S(std::move(S)),
+	a(std::move(a)),
+	b(std::move(b))
+{
+}
+
+MatrixM1::MatrixM1(const MatrixM1 &other) :
+	S(other.S),
+	a(other.a),
+	b(other.b)
+{
+}
+
+MatrixM1::MatrixM1(MatrixM1 &&other) noexcept :
+	S(std::move(other.S)),
+	a(std::move(other.a)),
+	b(std::move(other.b))
+{
+}
+
+EMMatrix MatrixM1::dense() const
+{
+	EMMatrix M = EMMatrix(S);
+	M.noalias() -= a * b.transpose();
+
+	return M;
+}
+
+/*!
+ * Calculates <tt>M1 * rhs</tt> at the cost proportional to the number of nonzero elements of \p S
+ */
+EMMatrix MatrixM1::multiply(const EMMatrix &rhs) const
+{
+	EMMatrix result = S * rhs;
+	result.noalias() -= a * (b.transpose() * rhs);
+
+	return result;
+}
+
+Eigen::Index MatrixM1::rows() const noexcept
+{
+	return S.rows();
+}
+
 SolutionProperties::SolutionProperties() :
 	bufferCapacity{-1},
 	conductivity{-1},
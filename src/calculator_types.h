@@ -5,6 +5,7 @@
 #include <memory>
 #include <vector>
 #include <Eigen/Dense>
+#include <Eigen/Sparse>
 
 namespace ECHMET {
 
@@ -24,6 +25,8 @@ typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> EMMatrix;
 typedef Eigen::Matrix<double, 1, Eigen::Dynamic>  EMVector;
 typedef Eigen::Matrix<std::complex<double>, Eigen::Dynamic, Eigen::Dynamic>  EMMatrixC;
 typedef Eigen::Matrix<std::complex<double>, 1, Eigen::Dynamic>  EMVectorC;
+typedef Eigen::Matrix<double, Eigen::Dynamic, 1> EMColVector;
+typedef Eigen::SparseMatrix<double> EMSparseMatrix;
 
 typedef std::vector<const SysComp::Constituent *> InternalConstituentVec;
 typedef std::vector<std::pair<size_t, int32_t>> MultiplicityVec;
@@ -38,6 +41,7 @@ public:
 			    const size_t internalIonicFormConcentrationIdx,
 			    const size_t globalIonicFormConcentrationIdx,
 			    MultiplicityVec containedConstituents, const bool isAnaylte) noexcept;
+	CalculatorIonicForm(const CalculatorIonicForm &other);
 
 	const std::string name;					/*!< Name of the ionic form, useful only for debugging purposes */
 	const int32_t charge;					/*!< Total electric charge of the ionic form */
@@ -47,16 +51,34 @@ public:
 	const MultiplicityVec multiplicities;
 	const bool isAnalyte;					/*!< Ionic form is a form of an analyte */
 
-	double concentration;					/*!< Concentration of the ionic form. This cannot be set by the c-tor because the
-								     internal system representation is reusable. */
-	double mobility;					/*!< Actual ionic mobility of the ionic form. This cannot be set by the c-tor because
-								     the internal system representation is reusable. */
-
 	CalculatorIonicForm & operator=(const CalculatorIonicForm &other);
 	CalculatorIonicForm & operator=(CalculatorIonicForm &&other) noexcept;
 };
 typedef std::vector<CalculatorIonicForm *> CalculatorIonicFormVec;
 
+/*!
+ * Numerical properties of all ionic forms stored as contiguous arrays.
+ * Elements are ordered in the same way as \p CalculatorIonicFormVec of the system.
+ */
+class IonicFormArrays {
+public:
+	IonicFormArrays();
+	explicit IonicFormArrays(const CalculatorIonicFormVec &ifVec);
+
+	EMColVector charges;		/*!< Total electric charge of the ionic form */
+	EMColVector signs;		/*!< Sign of the total electric charge */
+	EMColVector absCharges;		/*!< Absolute value of the total electric charge */
+	EMColVector concentrations;	/*!< Concentrations of the ionic forms. These cannot be set by the c-tor because the
+					     internal system representation is reusable. */
+	EMColVector mobilities;		/*!< Actual ionic mobilities of the ionic forms. These cannot be set by the c-tor because
+					     the internal system representation is reusable. */
+	std::vector<size_t> internalConcentrationIndices;	/*!< Gather indices into the vector of ionic concentrations used by CoreLibs */
+	std::vector<size_t> internalMobilityIndices;		/*!< Gather indices into the vector of ionic mobilities used by CoreLibs */
+	std::vector<size_t> chargedIndices;	/*!< Indices of the ionic forms with nonzero charge, H3O+ and OH- included.
+						     Uncharged forms have zero columns in M1 so the mobility matrices use only these. */
+	EMSparseMatrix chargedSelector;		/*!< <tt>NIF x NCH</tt> matrix that picks the columns of charged ionic forms */
+};
+
 /*!
  * Constituent representation used internally by the \p Calculator
  */
@@ -88,8 +110,10 @@ typedef std::vector<CalculatorConstituent> CalculatorConstituentVec;
 class CalculatorSystemPack {
 public:
 	CalculatorSystemPack();
-	CalculatorSystemPack(const CalculatorConstituentVec &ccVec, const CalculatorIonicFormVec &ifVec, const SysComp::ChemicalSystem *chemSystemRaw, SysComp::CalculatedProperties *calcProps);
-	CalculatorSystemPack(CalculatorConstituentVec &&ccVec, CalculatorIonicFormVec &&ifVec, const SysComp::ChemicalSystem *chemSystemRaw, SysComp::CalculatedProperties *calcProps) noexcept;
+	CalculatorSystemPack(const CalculatorConstituentVec &ccVec, const CalculatorIonicFormVec &ifVec, const EMSparseMatrix &multiplicities,
+			     const SysComp::ChemicalSystem *chemSystemRaw, SysComp::CalculatedProperties *calcProps);
+	CalculatorSystemPack(CalculatorConstituentVec &&ccVec, CalculatorIonicFormVec &&ifVec, EMSparseMatrix &&multiplicities,
+			     const SysComp::ChemicalSystem *chemSystemRaw, SysComp::CalculatedProperties *calcProps) noexcept;
 	CalculatorSystemPack(const CalculatorSystemPack &other) = delete;
 	CalculatorSystemPack(CalculatorSystemPack &&other) noexcept;
 	~CalculatorSystemPack();
@@ -100,6 +124,11 @@ public:
 	CalculatorConstituentVec constituents;		/*!< Vector of all constituents in the system. */
 	const InternalConstituentVec internalConstituents;
 	const CalculatorIonicFormVec ionicForms;	/*!< Vector of all ionic forms in the system. */
+	const EMSparseMatrix multiplicities;		/*!< Number of times a constituent (row) is contained in an ionic form (column).
+							     Columns of H3O+ and OH- are empty. */
+	const EMSparseMatrix conductivityWeights;	/*!< Weights of the ionic forms (columns) that contain a constituent (row)
+							     in the conductivity term of the constituent */
+	IonicFormArrays ionicFormArrays;		/*!< Numerical properties of \p ionicForms laid out for vectorized access */
 	const SysComp::ChemicalSystem *chemSystemRaw;	/*!< Raw pointer to \p SysComp::ChemicalSystem object corresponding to
 							     ECHMETCoreLibs representation of the system. */
 	SysComp::CalculatedProperties *calcPropsRaw;	/*!< Raw pointer to \p SysComp::CalculatedProperties object corresponding to
@@ -139,6 +168,27 @@ private:
 	std::unique_ptr<EMMatrixC> m_QR;
 };
 
+/*!
+ * Matrix M1 stored as a sparse part and a rank-one correction, <tt>M1 = S - a * b^T</tt>.
+ * \p S holds the contributions of the constituents to the ionic forms they are part of,
+ * the rank-one correction comes from the conductivity term that spans the whole row.
+ * Only the columns of charged ionic forms are stored, see \p IonicFormArrays::chargedIndices.
+ */
+class MatrixM1 {
+public:
+	MatrixM1(EMSparseMatrix &&S, EMColVector &&a, EMColVector &&b) noexcept;
+	MatrixM1(const MatrixM1 &other);
+	MatrixM1(MatrixM1 &&other) noexcept;
+
+	EMMatrix dense() const;
+	EMMatrix multiply(const EMMatrix &rhs) const;
+	Eigen::Index rows() const noexcept;
+
+	const EMSparseMatrix S;		/*!< Sparse part, <tt>NCO x NCH</tt> */
+	const EMColVector a;		/*!< Conductivity term of each constituent */
+	const EMColVector b;		/*!< <tt>|z| * u</tt> of each charged ionic form */
+};
+
 class SolutionProperties {
 public:
 	SolutionProperties();
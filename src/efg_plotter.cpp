@@ -94,6 +94,21 @@ double inputPlotTimeToTime(const double inputTime, const double longestZoneTime)
 	return guessPlotToTime(longestZoneTime);
 }
 
+static
+bool hasDispersionParameters(const REigenzoneVec *eigenzones) noexcept
+{
+	/* Dispersion parameters are not available when the nonlinear
+	 * stage of the model was skipped */
+	for (size_t idx = 0; idx < eigenzones->size(); idx++) {
+		const REigenzone &ez = eigenzones->at(idx);
+
+		if (ez.valid && (std::isnan(ez.a2t) || std::isnan(ez.uEMD)))
+			return false;
+	}
+
+	return true;
+}
+
 static
 void makeEigenzonePlotParams(const REigenzoneVec *eigenzones,
 			     const EFGResponseType respType,
@@ -380,6 +395,8 @@ RetCode ECHMET_CC findEigenzoneEnvelopes(REigenzoneEnvelopeVec *&envelopes, cons
 		return RetCode::E_INVALID_DETECTOR_POSITION;
 	if (injectionZoneLength <= 0.0)
 		return RetCode::E_INVALID_ARGUMENT;
+	if (!hasDispersionParameters(results.eigenzones))
+		return RetCode::E_INVALID_ARGUMENT;
 
 	const double E = drivingVoltage / totalLength;		/* Electric field intensity */
 	const double EOFVelocity = EOFMobility * E * 1.0e-9;
@@ -440,6 +457,8 @@ RetCode ECHMET_CC plotElectrophoregram(EFGPairVec *&electrophoregram,
 		return RetCode::E_INVALID_ARGUMENT;
 	if (injectionZoneLength <= 0.0)
 		return RetCode::E_INVALID_ARGUMENT;
+	if (!hasDispersionParameters(results.eigenzones))
+		return RetCode::E_INVALID_ARGUMENT;
 
 	const double E = drivingVoltage / totalLength;	/* Electric field intensity */
 	const double EOFVelocity = EOFMobility * E * 1.0e-9;
@@ -0,0 +1,110 @@
+#include "evaluation_state.h"
+
+namespace ECHMET {
+namespace LEMNG {
+
+static
+bool sameConcentrations(const std::vector<double> &stored, const RealVecPtr &current)
+{
+	if (stored.size() != current->size())
+		return false;
+
+	for (size_t idx = 0; idx < stored.size(); idx++) {
+		if (stored[idx] != ECHMETRealToDouble(current->at(idx)))
+			return false;
+	}
+
+	return true;
+}
+
+static
+void storeConcentrations(std::vector<double> &stored, const RealVecPtr &current)
+{
+	stored.resize(current->size());
+
+	for (size_t idx = 0; idx < stored.size(); idx++)
+		stored[idx] = ECHMETRealToDouble(current->at(idx));
+}
+
+EvaluationState::EvaluationState() :
+	m_corrections{},
+	m_valid{false}
+{
+}
+
+/*!
+ * Discards all stages together with the eigenvectors the linear models follow.
+ */
+void EvaluationState::clear()
+{
+	m_valid = false;
+
+	resetSample();
+
+	BGEProps = nullptr;
+	BGELikeProps = nullptr;
+	deltaPacks.clear();
+	linearModel = nullptr;
+	previousQLQR = nullptr;
+	pinnedQLQR = nullptr;
+	dispersionModel = nullptr;
+}
+
+bool EvaluationState::matches(const RealVecPtr &analConcsBGE, const RealVecPtr &analConcsBGELike, const NonidealityCorrections corrections) const
+{
+	if (!m_valid)
+		return false;
+	if (corrections != m_corrections)
+		return false;
+
+	return sameConcentrations(m_analConcsBGE, analConcsBGE) && sameConcentrations(m_analConcsBGELike, analConcsBGELike);
+}
+
+void EvaluationState::reset(const RealVecPtr &analConcsBGE, const RealVecPtr &analConcsBGELike, const NonidealityCorrections corrections)
+{
+	m_valid = false;
+
+	resetSample();
+
+	BGEProps = nullptr;
+	BGELikeProps = nullptr;
+	deltaPacks.clear();
+	if (linearModel != nullptr)
+		previousQLQR = std::unique_ptr<Calculator::QLQRPack>{new Calculator::QLQRPack{linearModel->QLQR}};
+	linearModel = nullptr;
+	dispersionModel = nullptr;
+
+	storeConcentrations(m_analConcsBGE, analConcsBGE);
+	storeConcentrations(m_analConcsBGELike, analConcsBGELike);
+	m_corrections = corrections;
+
+	m_valid = true;
+}
+
+const Calculator::QLQRPack * EvaluationState::reference() const
+{
+	if (pinnedQLQR != nullptr)
+		return pinnedQLQR.get();
+
+	return previousQLQR.get();
+}
+
+/*!
+ * Discards all stages and makes the next linear model follow \p reference.
+ */
+void EvaluationState::restart(const Calculator::QLQRPack &reference)
+{
+	clear();
+
+	previousQLQR = std::unique_ptr<Calculator::QLQRPack>{new Calculator::QLQRPack{reference}};
+}
+
+void EvaluationState::resetSample()
+{
+	zoneCompositions = nullptr;
+	linearResults = nullptr;
+	dispersions = nullptr;
+}
+
+} // namespace LEMNG
+} // namespace ECHMET
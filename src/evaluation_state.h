@@ -0,0 +1,57 @@
+#ifndef ECHMET_LEMNG_EVALUATION_STATE_H
+#define ECHMET_LEMNG_EVALUATION_STATE_H
+
+#include "base_types.h"
+#include "calculator_linear.h"
+#include "calculator_nonlinear.h"
+
+namespace ECHMET {
+namespace LEMNG {
+
+/*!
+ * Intermediate results of the last evaluation.
+ *
+ * The BGE-like system is built from the BGE concentrations only, therefore
+ * everything derived from it can be reused for as long as the BGE concentrations
+ * and nonideality corrections stay the same. Stages that depend on the sample
+ * are discarded by \p resetSample(). Each stage is stored only once it has
+ * been computed successfully.
+ */
+class EvaluationState {
+public:
+	EvaluationState();
+
+	void clear();
+	bool matches(const RealVecPtr &analConcsBGE, const RealVecPtr &analConcsBGELike, const NonidealityCorrections corrections) const;
+	void reset(const RealVecPtr &analConcsBGE, const RealVecPtr &analConcsBGELike, const NonidealityCorrections corrections);
+	void resetSample();
+	void restart(const Calculator::QLQRPack &reference);
+	const Calculator::QLQRPack * reference() const;
+
+	std::unique_ptr<Calculator::SolutionProperties> BGEProps;		/*!< Properties of the plain BGE */
+	std::unique_ptr<Calculator::SolutionProperties> BGELikeProps;		/*!< Properties of the BGE-like system. Set once the concentration
+										     deltas have been calculated and the system packs are bound. */
+	Calculator::DeltaPackVec deltaPacks;
+	std::unique_ptr<Calculator::LinearModel> linearModel;
+	std::unique_ptr<Calculator::QLQRPack> previousQLQR;			/*!< Eigenvectors of the last linear model of a different BGE.
+										     Eigenpairs of a new linear model are ordered to follow them. */
+	std::shared_ptr<const Calculator::QLQRPack> pinnedQLQR;		/*!< Eigenvectors of the first solvable point of a grid scan.
+										     Takes precedence over \p previousQLQR while set so that
+										     all workers follow the same reference. */
+	std::unique_ptr<Calculator::DispersionModel> dispersionModel;
+
+	std::unique_ptr<Calculator::ZoneCompositionVec> zoneCompositions;
+	std::unique_ptr<Calculator::LinearResults> linearResults;
+	std::unique_ptr<Calculator::EigenzoneDispersionVec> dispersions;
+
+private:
+	std::vector<double> m_analConcsBGE;
+	std::vector<double> m_analConcsBGELike;
+	NonidealityCorrections m_corrections;
+	bool m_valid;
+};
+
+} // namespace LEMNG
+} // namespace ECHMET
+
+#endif // ECHMET_LEMNG_EVALUATION_STATE_H
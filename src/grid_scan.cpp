@@ -0,0 +1,344 @@
+#include "grid_scan.h"
+#include "calculator_common.h"
+#include "calculator_linear.h"
+#include "calculator_nonlinear.h"
+#include "evaluation_state.h"
+#include "helpers.h"
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <new>
+#include <thread>
+
+namespace ECHMET {
+namespace LEMNG {
+
+/*!
+ * Evaluation context of one worker of a grid scan.
+ */
+class ScanWorker {
+public:
+	CZESystemImpl *system;
+	InAnalyticalConcentrationsMapPtr acBGE;
+	InAnalyticalConcentrationsMapPtr acFull;
+};
+
+std::string checkGridAxes(const GridScanAxis *axes, const int32_t numAxes, size_t &numPoints)
+{
+	static const int32_t SWEEP_BOTH = static_cast<int32_t>(SweepTarget::SWEEP_BOTH);
+
+	if (axes == nullptr || numAxes < 1)
+		return "No axes of the grid were given";
+
+	numPoints = 1;
+	for (int32_t idx = 0; idx < numAxes; idx++) {
+		const GridScanAxis &axis = axes[idx];
+
+		if (axis.constituent == nullptr || axis.values == nullptr || axis.values->size() < 1)
+			return "Invalid grid axis";
+		if (axis.target == 0 || (axis.target & ~SWEEP_BOTH))
+			return "Invalid target of grid axis";
+
+		for (int32_t jdx = 0; jdx < idx; jdx++) {
+			if (std::string{axes[jdx].constituent} == axis.constituent)
+				return "Constituent " + std::string{axis.constituent} + " is varied by more than one axis";
+		}
+
+		if (numPoints > std::numeric_limits<size_t>::max() / axis.values->size())
+			return "Grid is too large";
+		numPoints *= axis.values->size();
+	}
+
+	return "";
+}
+
+/*!
+ * Maps the position in the serpentine traversal of the grid to the indices of the point along the axes.
+ * Direction of each axis is reversed on every other pass so that the consecutive points
+ * differ by one step along a single axis.
+ *
+ * @param[in] axes Axes of the grid.
+ * @param[in] numAxes Number of axes.
+ * @param[in] position Position in the traversal.
+ * @param[out] indices Indices of the point along the axes.
+ *
+ * @return Row-major index of the point.
+ */
+static
+size_t serpentinePoint(const GridScanAxis *axes, const int32_t numAxes, const size_t position, std::vector<size_t> &indices)
+{
+	size_t rem = position;
+
+	for (int32_t idx = numAxes - 1; idx > 0; idx--) {
+		const size_t N = axes[idx].values->size();
+		const size_t pass = rem / N;
+		const size_t step = rem % N;
+
+		indices[idx] = (pass & 1) ? N - 1 - step : step;
+		rem = pass;
+	}
+	indices[0] = rem;
+
+	size_t pointIdx = 0;
+	for (int32_t idx = 0; idx < numAxes; idx++)
+		pointIdx = pointIdx * axes[idx].values->size() + indices[idx];
+
+	return pointIdx;
+}
+
+RetCode CZESystemImpl::scanPoint(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acSample, const NonidealityCorrections corrections,
+				 const bool calcDispersion, RGridScanBuffer *buffer, const size_t pointIdx) noexcept
+{
+	const size_t offset = pointIdx * buffer->zonesPerPoint;
+
+	for (size_t idx = 0; idx < buffer->zonesPerPoint; idx++) {
+		buffer->mobilities[offset + idx] = std::numeric_limits<double>::quiet_NaN();
+		buffer->uEMDs[offset + idx] = std::numeric_limits<double>::quiet_NaN();
+		buffer->a2ts[offset + idx] = std::numeric_limits<double>::quiet_NaN();
+		buffer->ztypes[offset + idx] = static_cast<int32_t>(EigenzoneType::INVALID);
+	}
+
+	RetCode tRet = setInput(acBGE, acSample, corrections);
+	if (tRet != RetCode::OK)
+		return tRet;
+
+	try {
+		const Calculator::LinearModel &linModel = linearModel();
+		const Calculator::ZoneCompositionVec &compositions = zoneCompositions();
+
+		for (size_t idx = 0; idx < compositions.size(); idx++) {
+			buffer->mobilities[offset + idx] = linModel.eigenmobilities(idx).real();
+			buffer->ztypes[offset + idx] = static_cast<int32_t>(compositions.at(idx).isAnalyteZone ? EigenzoneType::ANALYTE : EigenzoneType::SYSTEM);
+		}
+
+		if (calcDispersion) {
+			const Calculator::EigenzoneDispersionVec &ezDisps = dispersions();
+
+			for (size_t idx = 0; idx < ezDisps.size(); idx++) {
+				buffer->uEMDs[offset + idx] = ezDisps.at(idx).uEMD;
+				buffer->a2ts[offset + idx] = ezDisps.at(idx).a2t;
+			}
+		}
+	} catch (std::bad_alloc &) {
+		m_lastErrorString = "Insufficient memory to evaluate grid point";
+
+		return RetCode::E_NO_MEMORY;
+	} catch (Calculator::CalculationException &ex) {
+		m_lastErrorString = ex.what();
+
+		return ex.errorCode();
+	}
+
+	return RetCode::OK;
+}
+
+RetCode ECHMET_CC CZESystemImpl::makeGridScanBuffer(const GridScanAxis *axes, const int32_t numAxes, RGridScanBuffer *&buffer) const noexcept
+{
+	size_t numPoints;
+
+	if (!checkGridAxes(axes, numAxes, numPoints).empty())
+		return RetCode::E_INVALID_ARGUMENT;
+
+	const size_t zonesPerPoint = m_chemicalSystemFull->constituents->size();
+	if (zonesPerPoint > 0 && numPoints > std::numeric_limits<size_t>::max() / zonesPerPoint)
+		return RetCode::E_DATA_TOO_LARGE;
+	const size_t numValues = numPoints * zonesPerPoint;
+
+	RGridScanBuffer *buf = new (std::nothrow) RGridScanBuffer{numPoints, zonesPerPoint, nullptr, nullptr, nullptr, nullptr, nullptr};
+	if (buf == nullptr)
+		return RetCode::E_NO_MEMORY;
+
+	try {
+		buf->status = new int32_t[numPoints];
+		buf->mobilities = new double[numValues];
+		buf->uEMDs = new double[numValues];
+		buf->a2ts = new double[numValues];
+		buf->ztypes = new int32_t[numValues];
+	} catch (std::bad_alloc &) {
+		releaseGridScanBuffer(buf);
+
+		return RetCode::E_NO_MEMORY;
+	}
+
+	buffer = buf;
+
+	return RetCode::OK;
+}
+
+RetCode ECHMET_CC CZESystemImpl::gridScan(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acFull,
+					  const GridScanAxis *axes, const int32_t numAxes, const NonidealityCorrections corrections,
+					  const bool calcDispersion, RGridScanBuffer *buffer) noexcept
+{
+	static const int32_t SWEEP_BGE = static_cast<int32_t>(SweepTarget::SWEEP_BGE);
+	static const int32_t SWEEP_SAMPLE = static_cast<int32_t>(SweepTarget::SWEEP_SAMPLE);
+
+	if (acBGE == nullptr || acFull == nullptr || buffer == nullptr) {
+		m_lastErrorString = "Invalid grid scan parameters";
+		return RetCode::E_INVALID_ARGUMENT;
+	}
+
+	size_t numPoints;
+	const std::string axesError = checkGridAxes(axes, numAxes, numPoints);
+	if (!axesError.empty()) {
+		m_lastErrorString = axesError;
+		return RetCode::E_INVALID_ARGUMENT;
+	}
+
+	if (buffer->numPoints != numPoints || buffer->zonesPerPoint != m_chemicalSystemFull->constituents->size()) {
+		m_lastErrorString = "Dimensions of the grid scan buffer do not match the grid";
+		return RetCode::E_INVALID_ARGUMENT;
+	}
+
+	for (int32_t idx = 0; idx < numAxes; idx++) {
+		const GridScanAxis &axis = axes[idx];
+
+		if (((axis.target & SWEEP_BGE) && !acBGE->contains(axis.constituent)) ||
+		    ((axis.target & SWEEP_SAMPLE) && !acFull->contains(axis.constituent))) {
+			m_lastErrorString = "Varied constituent " + std::string{axis.constituent} + " is not present in the targeted composition";
+			return RetCode::E_INVALID_ARGUMENT;
+		}
+	}
+
+#ifdef ECHMET_LEMNG_PARALLEL_NUM_OPS
+	const size_t NWorkers = [numPoints]() -> size_t {
+		const size_t n = std::thread::hardware_concurrency();
+		if (n < 1)
+			return 1;
+		return std::min(n, numPoints);
+	}();
+#else // ECHMET_LEMNG_PARALLEL_NUM_OPS
+	const size_t NWorkers = 1;
+#endif // ECHMET_LEMNG_PARALLEL_NUM_OPS
+
+	std::vector<ScanWorker> workers{};
+	std::vector<std::unique_ptr<CZESystemImpl>> systems{};
+
+	try {
+		workers.reserve(NWorkers);
+
+		/* The first block is scanned by this system, the other workers get their own
+		 * systems that share the prepared data of this one. */
+		workers.emplace_back(ScanWorker{this, copyConcentrationsMap(acBGE), copyConcentrationsMap(acFull)});
+		for (size_t idx = 1; idx < NWorkers; idx++) {
+			systems.emplace_back(std::unique_ptr<CZESystemImpl>{new CZESystemImpl{m_prepared}});
+			workers.emplace_back(ScanWorker{systems.back().get(), copyConcentrationsMap(acBGE), copyConcentrationsMap(acFull)});
+		}
+	} catch (std::bad_alloc &) {
+		m_lastErrorString = "Insufficient memory to prepare grid scan";
+		return RetCode::E_NO_MEMORY;
+	}
+
+	/* Sets the concentrations of the worker to the point at the given position of the traversal */
+	const auto moveTo = [&](ScanWorker &w, const size_t position, std::vector<size_t> &indices) {
+		const size_t pointIdx = serpentinePoint(axes, numAxes, position, indices);
+
+		for (int32_t idx = 0; idx < numAxes; idx++) {
+			const GridScanAxis &axis = axes[idx];
+			const double c = ECHMETRealToDouble(axis.values->at(indices[idx]));
+
+			if (axis.target & SWEEP_BGE)
+				w.acBGE->item(axis.constituent) = c;
+			if (axis.target & SWEEP_SAMPLE)
+				w.acFull->item(axis.constituent) = c;
+		}
+
+		return pointIdx;
+	};
+
+	const auto scanBlock = [&](ScanWorker &w, const size_t first, const size_t last) {
+		std::vector<size_t> indices(numAxes);
+
+		for (size_t position = first; position < last; position++) {
+			const size_t pointIdx = moveTo(w, position, indices);
+
+			const RetCode tRet = w.system->scanPoint(w.acBGE.get(), w.acFull.get(), corrections, calcDispersion, buffer, pointIdx);
+			buffer->status[pointIdx] = static_cast<int32_t>(tRet);
+
+			/* Next point is one step away from this one */
+			w.system->m_warmStart = tRet == RetCode::OK;
+		}
+		w.system->m_warmStart = false;
+	};
+
+	const size_t blockSize = (numPoints + NWorkers - 1) / NWorkers;
+
+	try {
+		/* Every worker would otherwise order the eigenzones to follow whatever it evaluated last
+		 * and the order would depend on the division of the grid into blocks. All workers follow
+		 * the first point of the traversal that can be solved instead, this system finds it
+		 * with no reference so that the order does not depend on its previous evaluations either.
+		 * Unlike a sweep, the points are not chained to their neighbors as that would make the order
+		 * depend on the blocks again. The price is that zones whose eigenmobilities cross between
+		 * the first point and a distant one may be matched the other way round. */
+		std::shared_ptr<const Calculator::QLQRPack> reference{};
+		{
+			ScanWorker &w = workers.front();
+			std::vector<size_t> indices(numAxes);
+
+			m_evalState->clear();
+			for (size_t position = 0; position < numPoints && reference == nullptr; position++) {
+				const size_t pointIdx = moveTo(w, position, indices);
+
+				const RetCode tRet = scanPoint(w.acBGE.get(), w.acFull.get(), corrections, false, buffer, pointIdx);
+				if (m_evalState->linearModel != nullptr)
+					reference = std::make_shared<const Calculator::QLQRPack>(m_evalState->linearModel->QLQR);
+				m_warmStart = tRet == RetCode::OK;
+			}
+			m_warmStart = false;
+		}
+
+		for (ScanWorker &w : workers)
+			w.system->m_evalState->pinnedQLQR = reference;
+
+#ifdef ECHMET_LEMNG_PARALLEL_NUM_OPS
+		std::vector<std::future<void>> results{};
+		results.reserve(NWorkers);
+
+		try {
+			for (size_t idx = 0; idx < NWorkers; idx++) {
+				const size_t first = std::min(idx * blockSize, numPoints);
+				const size_t last = std::min(first + blockSize, numPoints);
+
+				results.emplace_back(std::async(std::launch::async, scanBlock, std::ref(workers[idx]), first, last));
+			}
+
+			for (auto &f : results)
+				f.get();
+		} catch (...) {
+			for (auto &f : results) {
+				if (f.valid())
+					f.wait();
+			}
+			throw;
+		}
+#else // ECHMET_LEMNG_PARALLEL_NUM_OPS
+		scanBlock(workers.front(), 0, blockSize);
+#endif // ECHMET_LEMNG_PARALLEL_NUM_OPS
+	} catch (std::bad_alloc &) {
+		m_warmStart = false;
+		m_evalState->pinnedQLQR = nullptr;
+		m_lastErrorString = "Insufficient memory to perform grid scan";
+
+		return RetCode::E_NO_MEMORY;
+	}
+
+	m_evalState->pinnedQLQR = nullptr;
+
+	return RetCode::OK;
+}
+
+void ECHMET_CC releaseGridScanBuffer(RGridScanBuffer *buffer) noexcept
+{
+	if (buffer == nullptr)
+		return;
+
+	delete [] buffer->status;
+	delete [] buffer->mobilities;
+	delete [] buffer->uEMDs;
+	delete [] buffer->a2ts;
+	delete [] buffer->ztypes;
+	delete buffer;
+}
+
+} // namespace LEMNG
+} // namespace ECHMET
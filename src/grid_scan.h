@@ -0,0 +1,23 @@
+#ifndef ECHMET_LEMNG_GRID_SCAN_H
+#define ECHMET_LEMNG_GRID_SCAN_H
+
+#include "lemng_p.h"
+
+namespace ECHMET {
+namespace LEMNG {
+
+/*!
+ * Checks the shape of the grid and calculates the number of its points.
+ *
+ * @param[in] axes Axes of the grid.
+ * @param[in] numAxes Number of axes of the grid.
+ * @param[out] numPoints Number of points of the grid.
+ *
+ * @return Empty string if the axes are valid, description of the problem otherwise.
+ */
+std::string checkGridAxes(const GridScanAxis *axes, const int32_t numAxes, size_t &numPoints);
+
+} // namespace LEMNG
+} // namespace ECHMET
+
+#endif // ECHMET_LEMNG_GRID_SCAN_H
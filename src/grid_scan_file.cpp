@@ -0,0 +1,298 @@
+#include "grid_scan.h"
+#include "mapped_file.h"
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <new>
+
+namespace ECHMET {
+namespace LEMNG {
+
+/*!
+ * Grid scan file together with its mapping.
+ */
+class GridScanFileImpl : public RGridScanFile {
+public:
+	GridScanFileImpl() noexcept;
+
+	MappedFile mapping;
+};
+
+GridScanFileImpl::GridScanFileImpl() noexcept :
+	RGridScanFile{}
+{
+}
+
+static
+uint64_t alignOffset(const uint64_t offset)
+{
+	return (offset + GRID_SCAN_FILE_ALIGNMENT - 1) / GRID_SCAN_FILE_ALIGNMENT * GRID_SCAN_FILE_ALIGNMENT;
+}
+
+/*!
+ * Checks that an array lies within the file and is properly aligned.
+ */
+static
+bool arrayFits(const uint64_t offset, const uint64_t count, const uint64_t elementSize, const uint64_t fileSize)
+{
+	if (offset % GRID_SCAN_FILE_ALIGNMENT != 0 || offset > fileSize)
+		return false;
+
+	return count <= (fileSize - offset) / elementSize;
+}
+
+template <typename T>
+static
+T * at(char *base, const uint64_t offset)
+{
+	return reinterpret_cast<T *>(base + offset);
+}
+
+RetCode ECHMET_CC CZESystemImpl::gridScanToFile(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acFull,
+						const GridScanAxis *axes, const int32_t numAxes, const NonidealityCorrections corrections,
+						const bool calcDispersion, const char *path) noexcept
+{
+	if (acBGE == nullptr || acFull == nullptr || path == nullptr) {
+		m_lastErrorString = "Invalid grid scan parameters";
+		return RetCode::E_INVALID_ARGUMENT;
+	}
+
+	size_t numPoints;
+	const std::string axesError = checkGridAxes(axes, numAxes, numPoints);
+	if (!axesError.empty()) {
+		m_lastErrorString = axesError;
+		return RetCode::E_INVALID_ARGUMENT;
+	}
+
+	const SysComp::ConstituentVec *constituents = m_chemicalSystemFull->constituents;
+	const uint64_t zonesPerPoint = constituents->size();
+	const uint64_t numValues = numPoints * zonesPerPoint;
+
+	if (zonesPerPoint > 0 && (numPoints > std::numeric_limits<uint64_t>::max() / zonesPerPoint ||
+				  numValues > std::numeric_limits<uint64_t>::max() / (2 * sizeof(double)))) {
+		m_lastErrorString = "Grid is too large to be stored in a file";
+		return RetCode::E_DATA_TOO_LARGE;
+	}
+
+	/* Lay out the file */
+	GridScanFileHeader header;
+	std::memset(&header, 0, sizeof(GridScanFileHeader));
+
+	std::memcpy(header.magic, GRID_SCAN_FILE_MAGIC, sizeof(GRID_SCAN_FILE_MAGIC));
+	header.version = GRID_SCAN_FILE_VERSION;
+	header.byteOrder = GRID_SCAN_FILE_BYTE_ORDER;
+	header.numPoints = numPoints;
+	header.zonesPerPoint = zonesPerPoint;
+	header.numAxes = numAxes;
+	header.numConstituents = constituents->size();
+	header.corrections = corrections;
+	header.hasDispersion = calcDispersion ? 1 : 0;
+
+	header.namesSize = 0;
+	for (int32_t idx = 0; idx < numAxes; idx++)
+		header.namesSize += std::strlen(axes[idx].constituent) + 1;
+	for (size_t idx = 0; idx < constituents->size(); idx++)
+		header.namesSize += std::strlen(constituents->at(idx)->name->c_str()) + 1;
+
+	header.axesOffset = alignOffset(sizeof(GridScanFileHeader));
+	header.constituentsOffset = alignOffset(header.axesOffset + numAxes * sizeof(GridScanFileAxis));
+	header.namesOffset = alignOffset(header.constituentsOffset + header.numConstituents * sizeof(GridScanFileConstituent));
+
+	uint64_t offset = alignOffset(header.namesOffset + header.namesSize);
+	std::vector<uint64_t> valuesOffsets{};
+	try {
+		for (int32_t idx = 0; idx < numAxes; idx++) {
+			valuesOffsets.emplace_back(offset);
+			offset = alignOffset(offset + axes[idx].values->size() * sizeof(double));
+		}
+	} catch (std::bad_alloc &) {
+		m_lastErrorString = "Insufficient memory to prepare grid scan file";
+		return RetCode::E_NO_MEMORY;
+	}
+
+	header.statusOffset = offset;
+	header.mobilitiesOffset = alignOffset(header.statusOffset + numPoints * sizeof(int32_t));
+	header.uEMDsOffset = alignOffset(header.mobilitiesOffset + numValues * sizeof(double));
+	header.a2tsOffset = alignOffset(header.uEMDsOffset + numValues * sizeof(double));
+	header.ztypesOffset = alignOffset(header.a2tsOffset + numValues * sizeof(double));
+	header.fileSize = alignOffset(header.ztypesOffset + numValues * sizeof(int32_t));
+
+	if (header.fileSize > std::numeric_limits<size_t>::max()) {
+		m_lastErrorString = "Grid is too large to be mapped into memory";
+		return RetCode::E_DATA_TOO_LARGE;
+	}
+
+	MappedFile file{};
+	if (!file.create(path, header.fileSize)) {
+		m_lastErrorString = "Cannot create grid scan file " + std::string{path};
+		return RetCode::E_IO_ERROR;
+	}
+
+	/* Fill out the metadata */
+	char *base = file.data();
+	char *names = at<char>(base, header.namesOffset);
+	uint64_t nameOffset = 0;
+
+	auto storeName = [names, &nameOffset](const char *name) {
+		const size_t len = std::strlen(name) + 1;
+		const uint64_t stored = nameOffset;
+
+		std::memcpy(names + nameOffset, name, len);
+		nameOffset += len;
+
+		return stored;
+	};
+
+	std::memcpy(base, &header, sizeof(GridScanFileHeader));
+
+	GridScanFileAxis *fileAxes = at<GridScanFileAxis>(base, header.axesOffset);
+	for (int32_t idx = 0; idx < numAxes; idx++) {
+		const GridScanAxis &axis = axes[idx];
+		double *values = at<double>(base, valuesOffsets[idx]);
+
+		fileAxes[idx].nameOffset = storeName(axis.constituent);
+		fileAxes[idx].valuesOffset = valuesOffsets[idx];
+		fileAxes[idx].numValues = axis.values->size();
+		fileAxes[idx].target = axis.target;
+
+		for (size_t jdx = 0; jdx < axis.values->size(); jdx++)
+			values[jdx] = ECHMETRealToDouble(axis.values->at(jdx));
+	}
+
+	GridScanFileConstituent *fileConstituents = at<GridScanFileConstituent>(base, header.constituentsOffset);
+	for (size_t idx = 0; idx < constituents->size(); idx++) {
+		const char *name = constituents->at(idx)->name->c_str();
+		double cBGE;
+		double cSample;
+
+		if (acBGE->at(cBGE, name) != ::ECHMET::RetCode::OK)
+			cBGE = std::numeric_limits<double>::quiet_NaN();
+		if (acFull->at(cSample, name) != ::ECHMET::RetCode::OK)
+			cSample = std::numeric_limits<double>::quiet_NaN();
+
+		fileConstituents[idx].nameOffset = storeName(name);
+		fileConstituents[idx].cBGE = cBGE;
+		fileConstituents[idx].cSample = cSample;
+	}
+
+	/* Let the scan write the results in place */
+	RGridScanBuffer buffer{
+		numPoints,
+		zonesPerPoint,
+		at<int32_t>(base, header.statusOffset),
+		at<double>(base, header.mobilitiesOffset),
+		at<double>(base, header.uEMDsOffset),
+		at<double>(base, header.a2tsOffset),
+		at<int32_t>(base, header.ztypesOffset)
+	};
+
+	const RetCode tRet = gridScan(acBGE, acFull, axes, numAxes, corrections, calcDispersion, &buffer);
+	if (tRet != RetCode::OK) {
+		file.close();
+		std::remove(path);
+
+		return tRet;
+	}
+
+	if (!file.flush()) {
+		file.close();
+		std::remove(path);
+
+		m_lastErrorString = "Cannot write grid scan file " + std::string{path};
+		return RetCode::E_IO_ERROR;
+	}
+
+	return RetCode::OK;
+}
+
+RetCode ECHMET_CC openGridScanFile(const char *path, const RGridScanFile *&file) noexcept
+{
+	if (path == nullptr)
+		return RetCode::E_INVALID_ARGUMENT;
+
+	std::unique_ptr<GridScanFileImpl> f{new (std::nothrow) GridScanFileImpl{}};
+	if (f == nullptr)
+		return RetCode::E_NO_MEMORY;
+
+	if (!f->mapping.open(path))
+		return RetCode::E_IO_ERROR;
+
+	char *base = f->mapping.data();
+	const uint64_t size = f->mapping.size();
+
+	if (size < sizeof(GridScanFileHeader))
+		return RetCode::E_INVALID_FILE;
+
+	const GridScanFileHeader *header = at<const GridScanFileHeader>(base, 0);
+	if (std::memcmp(header->magic, GRID_SCAN_FILE_MAGIC, sizeof(GRID_SCAN_FILE_MAGIC)) != 0 ||
+	    header->version != GRID_SCAN_FILE_VERSION ||
+	    header->byteOrder != GRID_SCAN_FILE_BYTE_ORDER ||
+	    header->fileSize != size)
+		return RetCode::E_INVALID_FILE;
+
+	const uint64_t numPoints = header->numPoints;
+	const uint64_t zonesPerPoint = header->zonesPerPoint;
+	if (zonesPerPoint > 0 && numPoints > std::numeric_limits<uint64_t>::max() / zonesPerPoint)
+		return RetCode::E_INVALID_FILE;
+	const uint64_t numValues = numPoints * zonesPerPoint;
+
+	if (!arrayFits(header->axesOffset, header->numAxes, sizeof(GridScanFileAxis), size) ||
+	    !arrayFits(header->constituentsOffset, header->numConstituents, sizeof(GridScanFileConstituent), size) ||
+	    !arrayFits(header->namesOffset, header->namesSize, sizeof(char), size) ||
+	    !arrayFits(header->statusOffset, numPoints, sizeof(int32_t), size) ||
+	    !arrayFits(header->mobilitiesOffset, numValues, sizeof(double), size) ||
+	    !arrayFits(header->uEMDsOffset, numValues, sizeof(double), size) ||
+	    !arrayFits(header->a2tsOffset, numValues, sizeof(double), size) ||
+	    !arrayFits(header->ztypesOffset, numValues, sizeof(int32_t), size))
+		return RetCode::E_INVALID_FILE;
+
+	const char *names = at<const char>(base, header->namesOffset);
+	if (header->namesSize < 1 || names[header->namesSize - 1] != '\0')
+		return RetCode::E_INVALID_FILE;
+
+	const GridScanFileAxis *axes = at<const GridScanFileAxis>(base, header->axesOffset);
+	uint64_t gridPoints = 1;
+	for (uint32_t idx = 0; idx < header->numAxes; idx++) {
+		const GridScanFileAxis &axis = axes[idx];
+
+		if (axis.nameOffset >= header->namesSize || !arrayFits(axis.valuesOffset, axis.numValues, sizeof(double), size))
+			return RetCode::E_INVALID_FILE;
+		if (axis.numValues > 0 && gridPoints > std::numeric_limits<uint64_t>::max() / axis.numValues)
+			return RetCode::E_INVALID_FILE;
+		gridPoints *= axis.numValues;
+	}
+	if (header->numAxes < 1 || gridPoints != numPoints)
+		return RetCode::E_INVALID_FILE;
+
+	const GridScanFileConstituent *constituents = at<const GridScanFileConstituent>(base, header->constituentsOffset);
+	for (uint32_t idx = 0; idx < header->numConstituents; idx++) {
+		if (constituents[idx].nameOffset >= header->namesSize)
+			return RetCode::E_INVALID_FILE;
+	}
+
+	f->header = header;
+	f->axes = axes;
+	f->constituents = constituents;
+	f->names = names;
+	f->results = RGridScanBuffer{
+		static_cast<size_t>(numPoints),
+		static_cast<size_t>(zonesPerPoint),
+		at<int32_t>(base, header->statusOffset),
+		at<double>(base, header->mobilitiesOffset),
+		at<double>(base, header->uEMDsOffset),
+		at<double>(base, header->a2tsOffset),
+		at<int32_t>(base, header->ztypesOffset)
+	};
+
+	file = f.release();
+
+	return RetCode::OK;
+}
+
+void ECHMET_CC releaseGridScanFile(const RGridScanFile *file) noexcept
+{
+	delete static_cast<const GridScanFileImpl *>(file);
+}
+
+} // namespace LEMNG
+} // namespace ECHMET
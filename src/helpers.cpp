@@ -1,8 +1,18 @@
 #include "helpers.h"
+#include <new>
+
+#define USE_ECHMET_CONTAINERS
+#include <containers/echmetskmap_p.h>
 
 namespace ECHMET {
 namespace LEMNG {
 
+void concentrationsMapDeleter(InAnalyticalConcentrationsMap *p)
+{
+	if (p != nullptr)
+		p->destroy();
+}
+
 RetCode coreLibsErrorToNativeError(const ::ECHMET::RetCode errorCode)
 {
 	switch (errorCode) {
@@ -30,5 +40,28 @@ RetCode coreLibsErrorToNativeError(const ::ECHMET::RetCode errorCode)
 	}
 }
 
+InAnalyticalConcentrationsMapPtr copyConcentrationsMap(const InAnalyticalConcentrationsMap *acMap)
+{
+	MutSKMapImpl<double> *copy = new MutSKMapImpl<double>{};
+	InAnalyticalConcentrationsMapPtr copyPtr{copy, concentrationsMapDeleter};
+
+	InAnalyticalConcentrationsMap::Iterator *it = acMap->begin();
+	if (it == nullptr)
+		throw std::bad_alloc{};
+
+	try {
+		while (it->hasNext()) {
+			copy->STL().emplace(it->key(), it->value());
+			it->next();
+		}
+	} catch (std::bad_alloc &) {
+		it->destroy();
+		throw;
+	}
+	it->destroy();
+
+	return copyPtr;
+}
+
 } // namespace LEMNG
 } // namespace ECHMET
@@ -5,11 +5,17 @@
 #define ECHMET_IMPORT_INTERNAL
 #endif // ECHMET_IMPORT_INTERNAL
 #include <lemng.h>
+#include <memory>
 
 namespace ECHMET {
 namespace LEMNG {
 
+void concentrationsMapDeleter(InAnalyticalConcentrationsMap *p);
+
+typedef std::unique_ptr<InAnalyticalConcentrationsMap, decltype(&concentrationsMapDeleter)> InAnalyticalConcentrationsMapPtr;
+
 RetCode coreLibsErrorToNativeError(const ::ECHMET::RetCode errorCode);
+InAnalyticalConcentrationsMapPtr copyConcentrationsMap(const InAnalyticalConcentrationsMap *acMap);
 
 } // namespace LEMNG
 } // namespace ECHMET
@@ -0,0 +1,108 @@
+#include "lazy_results.h"
+#include "lemng_p.h"
+
+namespace ECHMET {
+namespace LEMNG {
+
+LazyResultsImpl::LazyResultsImpl(CZESystemImpl *system, const uint64_t generation, const Results &results) noexcept :
+	m_system{system},
+	m_generation{generation},
+	m_results(results),
+	m_filled{0}
+{
+}
+
+LazyResultsImpl::~LazyResultsImpl() noexcept
+{
+	releaseResults(m_results);
+}
+
+RetCode ECHMET_CC LazyResultsImpl::BGEProperties(const RSolutionProperties *&props) noexcept
+{
+	const RetCode tRet = fill(evalPart(EvaluationParts::EVAL_BGE));
+	if (tRet != RetCode::OK)
+		return tRet;
+
+	props = &m_results.BGEProperties;
+
+	return RetCode::OK;
+}
+
+void ECHMET_CC LazyResultsImpl::destroy() const noexcept
+{
+	delete this;
+}
+
+RetCode ECHMET_CC LazyResultsImpl::dispersion(const REigenzoneVec *&eigenzones) noexcept
+{
+	const RetCode tRet = fill(evalPart(EvaluationParts::EVAL_DISPERSION));
+	if (tRet != RetCode::OK)
+		return tRet;
+
+	eigenzones = m_results.eigenzones;
+
+	return RetCode::OK;
+}
+
+RetCode ECHMET_CC LazyResultsImpl::eigenmobilities(const REigenzoneVec *&eigenzones) noexcept
+{
+	const RetCode tRet = fill(evalPart(EvaluationParts::EVAL_EIGENMOBILITIES));
+	if (tRet != RetCode::OK)
+		return tRet;
+
+	eigenzones = m_results.eigenzones;
+
+	return RetCode::OK;
+}
+
+RetCode LazyResultsImpl::fill(const int32_t parts) noexcept
+{
+	return m_system->fillResultsParts(m_generation, parts, m_results, m_filled);
+}
+
+RetCode ECHMET_CC LazyResultsImpl::results(const Results *&results) noexcept
+{
+	const RetCode tRet = fill(evalPart(EvaluationParts::EVAL_ALL));
+	if (tRet != RetCode::OK && tRet != RetCode::E_PARTIAL_EIGENZONES)
+		return tRet;
+
+	results = &m_results;
+
+	return tRet;
+}
+
+RetCode ECHMET_CC LazyResultsImpl::sensitivities(const REigenzoneVec *&eigenzones) noexcept
+{
+	const RetCode tRet = fill(evalPart(EvaluationParts::EVAL_SENSITIVITIES));
+	if (tRet != RetCode::OK)
+		return tRet;
+
+	eigenzones = m_results.eigenzones;
+
+	return RetCode::OK;
+}
+
+RetCode ECHMET_CC LazyResultsImpl::zoneCompositions(const REigenzoneVec *&eigenzones) noexcept
+{
+	const RetCode tRet = fill(evalPart(EvaluationParts::EVAL_ZONE_COMPOSITIONS));
+	if (tRet != RetCode::OK)
+		return tRet;
+
+	eigenzones = m_results.eigenzones;
+
+	return RetCode::OK;
+}
+
+RetCode ECHMET_CC LazyResultsImpl::zoneProperties(const REigenzoneVec *&eigenzones) noexcept
+{
+	const RetCode tRet = fill(evalPart(EvaluationParts::EVAL_ZONE_PROPERTIES));
+	if (tRet != RetCode::OK && tRet != RetCode::E_PARTIAL_EIGENZONES)
+		return tRet;
+
+	eigenzones = m_results.eigenzones;
+
+	return tRet;
+}
+
+} // namespace LEMNG
+} // namespace ECHMET
@@ -0,0 +1,36 @@
+#ifndef ECHMET_LEMNG_LAZY_RESULTS_H
+#define ECHMET_LEMNG_LAZY_RESULTS_H
+
+#include <lemng.h>
+
+namespace ECHMET {
+namespace LEMNG {
+
+class CZESystemImpl;
+
+class LazyResultsImpl : public LazyResults {
+public:
+	explicit LazyResultsImpl(CZESystemImpl *system, const uint64_t generation, const Results &results) noexcept;
+	virtual ~LazyResultsImpl() noexcept override;
+	virtual RetCode ECHMET_CC BGEProperties(const RSolutionProperties *&props) noexcept override;
+	virtual void ECHMET_CC destroy() const noexcept override;
+	virtual RetCode ECHMET_CC dispersion(const REigenzoneVec *&eigenzones) noexcept override;
+	virtual RetCode ECHMET_CC eigenmobilities(const REigenzoneVec *&eigenzones) noexcept override;
+	virtual RetCode ECHMET_CC results(const Results *&results) noexcept override;
+	virtual RetCode ECHMET_CC sensitivities(const REigenzoneVec *&eigenzones) noexcept override;
+	virtual RetCode ECHMET_CC zoneCompositions(const REigenzoneVec *&eigenzones) noexcept override;
+	virtual RetCode ECHMET_CC zoneProperties(const REigenzoneVec *&eigenzones) noexcept override;
+
+	RetCode fill(const int32_t parts) noexcept;
+
+private:
+	CZESystemImpl *m_system;	/*!< System that created the results */
+	const uint64_t m_generation;	/*!< Generation of the input that the results belong to */
+	Results m_results;
+	int32_t m_filled;		/*!< Parts of the results that have already been filled */
+};
+
+} // namespace LEMNG
+} // namespace ECHMET
+
+#endif // ECHMET_LEMNG_LAZY_RESULTS_H
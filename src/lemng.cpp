@@ -2,6 +2,8 @@
 #include "calculator_common.h"
 #include "calculator_linear.h"
 #include "calculator_nonlinear.h"
+#include "evaluation_state.h"
+#include "lazy_results.h"
 #include "helpers.h"
 #include "results_maker.h"
 #include "lemng_config.h"
@@ -168,51 +170,402 @@ void validateCompositions(const SysComp::InConstituentVec *BGEVec, const SysComp
 	}
 }
 
-CZESystemImpl::CZESystemImpl() :
-	m_chemicalSystemBGE{std::unique_ptr<SysComp::ChemicalSystem, decltype(&chemicalSystemDeleter)>{new SysComp::ChemicalSystem, &chemicalSystemDeleter}},
-	m_chemicalSystemFull{std::unique_ptr<SysComp::ChemicalSystem, decltype(&chemicalSystemDeleter)>{new SysComp::ChemicalSystem, &chemicalSystemDeleter}},
-	m_calcPropsBGE{std::unique_ptr<SysComp::CalculatedProperties, decltype(&calculatedPropertiesDeleter)>{new SysComp::CalculatedProperties, &calculatedPropertiesDeleter}},
-	m_calcPropsFull{std::unique_ptr<SysComp::CalculatedProperties, decltype(&calculatedPropertiesDeleter)>{new SysComp::CalculatedProperties, &calculatedPropertiesDeleter}}
+CZESystemImpl::CZESystemImpl(PreparedSystemPtr prepared) :
+	m_prepared{std::move(prepared)},
+	m_chemicalSystemBGE{m_prepared->chemicalSystemBGE},
+	m_chemicalSystemFull{m_prepared->chemicalSystemFull},
+	m_calcPropsBGE{makeCalculatedProperties(m_chemicalSystemBGE.get())},
+	m_calcPropsFull{makeCalculatedProperties(m_chemicalSystemFull.get())},
+	m_systemPack{Calculator::cloneSystemPack(m_prepared->systemPack, m_calcPropsFull.get())},
+	m_analConcsBGE{nullptr, echmetRealVecDeleter},
+	m_analConcsBGELike{nullptr, echmetRealVecDeleter},
+	m_analConcsFull{nullptr, echmetRealVecDeleter},
+	m_corrections{},
+	m_evalState{new EvaluationState{}},
+	m_generation{0},
+	m_warmStart{false}
 {
 }
 
-CZESystemImpl::CZESystemImpl(CZESystemImpl &&other) noexcept :
-	m_chemicalSystemBGE{std::move(other.m_chemicalSystemBGE)},
-	m_chemicalSystemFull{std::move(other.m_chemicalSystemFull)},
-	m_calcPropsBGE{std::move(other.m_calcPropsBGE)},
-	m_calcPropsFull{std::move(other.m_calcPropsFull)},
-	m_systemPack{std::move(other.m_systemPack)},
-	m_systemPackUncharged{std::move(other.m_systemPackUncharged)},
-	m_isAnalyteMap{std::move(other.m_isAnalyteMap)}
+CZESystemImpl::~CZESystemImpl() noexcept
 {
 }
 
-CZESystemImpl::CZESystemImpl(const SysComp::ChemicalSystem &chemicalSystemBGE, const SysComp::CalculatedProperties &calcPropsBGE, const SysComp::ChemicalSystem &chemicalSystemFull, const SysComp::CalculatedProperties &calcPropsFull, const IsAnalyteMap &iaMap) :
-	m_chemicalSystemBGE{std::unique_ptr<SysComp::ChemicalSystem, decltype(&chemicalSystemDeleter)>{new SysComp::ChemicalSystem, &chemicalSystemDeleter}},
-	m_chemicalSystemFull{std::unique_ptr<SysComp::ChemicalSystem, decltype(&chemicalSystemDeleter)>{new SysComp::ChemicalSystem, &chemicalSystemDeleter}},
-	m_calcPropsBGE{std::unique_ptr<SysComp::CalculatedProperties, decltype(&calculatedPropertiesDeleter)>{new SysComp::CalculatedProperties, &calculatedPropertiesDeleter}},
-	m_calcPropsFull{std::unique_ptr<SysComp::CalculatedProperties, decltype(&calculatedPropertiesDeleter)>{new SysComp::CalculatedProperties, &calculatedPropertiesDeleter}},
-	m_isAnalyteMap{iaMap}
+const Calculator::SolutionProperties & CZESystemImpl::BGELikeProperties()
 {
-	setupInternal(chemicalSystemBGE, calcPropsBGE, chemicalSystemFull, calcPropsFull);
+	if (m_evalState->BGELikeProps != nullptr)
+		return *m_evalState->BGELikeProps;
+
+	m_systemPack.conductivity = BGEProperties().conductivity;
+
+	/* Precalculate what is used in many places of the linear model */
+	try {
+		Calculator::SolutionProperties BGELikeProps;
+		Calculator::DeltaPackVec deltaPacks{};
+
+		Calculator::prepareModelData(m_systemPack, deltaPacks, m_analConcsBGELike, m_analConcsFull, BGELikeProps, m_corrections, m_warmStart);
+
+		m_evalState->deltaPacks = std::move(deltaPacks);
+		m_evalState->BGELikeProps = std::unique_ptr<Calculator::SolutionProperties>{new Calculator::SolutionProperties{std::move(BGELikeProps)}};
+	} catch (std::bad_alloc &) {
+		throw Calculator::CalculationException{"Insufficient memory to prepare model data", RetCode::E_NO_MEMORY};
+	} catch (Calculator::CalculationException &ex) {
+		ECHMET_TRACE(LEMNGTracing, EVAL_PROGRESS_ERR, "Cannot prepare model data", ex.what());
+		throw;
+	}
+
+	return *m_evalState->BGELikeProps;
 }
 
-CZESystemImpl::CZESystemImpl(const SysComp::ChemicalSystem &chemicalSystemBGE, const SysComp::CalculatedProperties &calcPropsBGE, const SysComp::ChemicalSystem &chemicalSystemFull, const SysComp::CalculatedProperties &calcPropsFull, IsAnalyteMap &&iaMap) :
-	m_chemicalSystemBGE{std::unique_ptr<SysComp::ChemicalSystem, decltype(&chemicalSystemDeleter)>{new SysComp::ChemicalSystem, &chemicalSystemDeleter}},
-	m_chemicalSystemFull{std::unique_ptr<SysComp::ChemicalSystem, decltype(&chemicalSystemDeleter)>{new SysComp::ChemicalSystem, &chemicalSystemDeleter}},
-	m_calcPropsBGE{std::unique_ptr<SysComp::CalculatedProperties, decltype(&calculatedPropertiesDeleter)>{new SysComp::CalculatedProperties, &calculatedPropertiesDeleter}},
-	m_calcPropsFull{std::unique_ptr<SysComp::CalculatedProperties, decltype(&calculatedPropertiesDeleter)>{new SysComp::CalculatedProperties, &calculatedPropertiesDeleter}},
-	m_isAnalyteMap{iaMap}
+const Calculator::SolutionProperties & CZESystemImpl::BGEProperties()
 {
-	setupInternal(chemicalSystemBGE, calcPropsBGE, chemicalSystemFull, calcPropsFull);
+	if (m_evalState->BGEProps != nullptr)
+		return *m_evalState->BGEProps;
+
+	try {
+		m_evalState->BGEProps = std::unique_ptr<Calculator::SolutionProperties>{new Calculator::SolutionProperties{
+			Calculator::calculateSolutionProperties(m_chemicalSystemBGE, m_analConcsBGE, m_calcPropsBGE, m_corrections, true, false, m_warmStart)}};
+	} catch (std::bad_alloc &) {
+		throw Calculator::CalculationException{"Insufficient memory to calculate BGE properties", RetCode::E_NO_MEMORY};
+	} catch (const Calculator::CalculationException &ex) {
+		ECHMET_TRACE(LEMNGTracing, EVAL_PROGRESS_ERR, "Unable to calculate BGE properties", ex.what());
+
+		throw Calculator::CalculationException{std::string{"Unable to calculate BGE properties: "} + ex.what(), RetCode::E_CANNOT_SOLVE_BGE};
+	}
+
+	return *m_evalState->BGEProps;
 }
 
-CZESystemImpl::~CZESystemImpl() noexcept
+const Calculator::DispersionModel & CZESystemImpl::dispersionModel()
 {
+	if (m_evalState->dispersionModel != nullptr)
+		return *m_evalState->dispersionModel;
+
+	const Calculator::LinearModel &linModel = linearModel();
+
+	try {
+		m_evalState->dispersionModel = std::unique_ptr<Calculator::DispersionModel>{new Calculator::DispersionModel{
+			Calculator::makeDispersionModel(m_systemPack, m_analConcsBGELike, m_evalState->deltaPacks, linModel, m_corrections)}};
+	} catch (std::bad_alloc &) {
+		ECHMET_TRACE(LEMNGTracing, EVAL_PROGRESS_ERR, "Cannot make nonlinear model", "Insufficient memory");
+
+		throw Calculator::CalculationException{"Insufficient memory to make nonlinear model", RetCode::E_NO_MEMORY};
+	} catch (Calculator::CalculationException &ex) {
+		ECHMET_TRACE(LEMNGTracing, EVAL_PROGRESS_ERR, "Cannot make nonlinear model", ex.what());
+		throw;
+	}
+
+	return *m_evalState->dispersionModel;
+}
+
+const Calculator::EigenzoneDispersionVec & CZESystemImpl::dispersions()
+{
+	if (m_evalState->dispersions != nullptr)
+		return *m_evalState->dispersions;
+
+	const Calculator::DispersionModel &dispModel = dispersionModel();
+	const Calculator::LinearModel &linModel = linearModel();
+
+	try {
+		m_evalState->dispersions = std::unique_ptr<Calculator::EigenzoneDispersionVec>{new Calculator::EigenzoneDispersionVec{
+			Calculator::calculateNonlinear(dispModel, linModel, m_systemPack)}};
+	} catch (std::bad_alloc &) {
+		ECHMET_TRACE(LEMNGTracing, EVAL_PROGRESS_ERR, "Cannot evaluate nonlinear model", "Insufficient memory");
+
+		throw Calculator::CalculationException{"Insufficient memory to evaluate nonlinear model", RetCode::E_NO_MEMORY};
+	} catch (Calculator::CalculationException &ex) {
+		ECHMET_TRACE(LEMNGTracing, EVAL_PROGRESS_ERR, "Cannot evaluate nonlinear model", ex.what());
+		throw;
+	}
+
+	return *m_evalState->dispersions;
 }
 
 RetCode ECHMET_CC CZESystemImpl::evaluate(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acSample,
 					  const NonidealityCorrections corrections, Results &results) noexcept
+{
+	return evaluateInternal(acBGE, acSample, corrections, evalPart(EvaluationParts::EVAL_ALL), results);
+}
+
+RetCode CZESystemImpl::evaluateInternal(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acSample,
+					const NonidealityCorrections corrections, const int32_t parts, Results &results) noexcept
+{
+	/* Results without the BGE are never handed over to the caller */
+	if (!(parts & evalPart(EvaluationParts::EVAL_BGE))) {
+		m_lastErrorString = "Evaluation parts must include the BGE";
+		return RetCode::E_INVALID_ARGUMENT;
+	}
+
+	RetCode tRet = setInput(acBGE, acSample, corrections);
+	if (tRet != RetCode::OK)
+		return tRet;
+
+	auto isAnalyteFunc = [this](const std::string &s){ return this->isAnalyte(s); };
+
+	/* Prepare output results */
+	try {
+		results = prepareResults(m_chemicalSystemBGE, m_chemicalSystemFull, isAnalyteFunc);
+	} catch (std::bad_alloc &) {
+		m_lastErrorString = "Insufficient memory to prepare results";
+		ECHMET_TRACE(LEMNGTracing, EVAL_INIT_ERR, "Cannot prepare Results data structures", "Insufficient memory");
+
+		return RetCode::E_NO_MEMORY;
+	}
+
+	int32_t filled = 0;
+	tRet = fillResultsParts(m_generation, parts, results, filled);
+
+	/* Results are handed over to the caller only if at least the BGE could have been solved */
+	if (!(filled & evalPart(EvaluationParts::EVAL_BGE))) {
+		releaseResults(results);
+		results = Results{};
+
+		if (tRet == RetCode::OK) {
+			m_lastErrorString = "BGE has not been solved";
+			return RetCode::E_CANNOT_SOLVE_BGE;
+		}
+	}
+
+	return tRet;
+}
+
+RetCode ECHMET_CC CZESystemImpl::evaluateLazy(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acSample,
+					      const NonidealityCorrections corrections, const int32_t parts, LazyResults *&results) noexcept
+{
+	if (parts & ~ALL_EVALUATION_PARTS) {
+		m_lastErrorString = "Invalid evaluation parts";
+		return RetCode::E_INVALID_ARGUMENT;
+	}
+
+	RetCode tRet = setInput(acBGE, acSample, corrections);
+	if (tRet != RetCode::OK)
+		return tRet;
+
+	auto isAnalyteFunc = [this](const std::string &s){ return this->isAnalyte(s); };
+
+	std::unique_ptr<LazyResultsImpl> lazy{};
+	try {
+		Results r = prepareResults(m_chemicalSystemBGE, m_chemicalSystemFull, isAnalyteFunc);
+		try {
+			lazy = std::unique_ptr<LazyResultsImpl>{new LazyResultsImpl{this, m_generation, r}};
+		} catch (std::bad_alloc &) {
+			releaseResults(r);
+			throw;
+		}
+	} catch (std::bad_alloc &) {
+		m_lastErrorString = "Insufficient memory to prepare results";
+		ECHMET_TRACE(LEMNGTracing, EVAL_INIT_ERR, "Cannot prepare Results data structures", "Insufficient memory");
+
+		return RetCode::E_NO_MEMORY;
+	}
+
+	tRet = lazy->fill(parts);
+	if (tRet != RetCode::OK && tRet != RetCode::E_PARTIAL_EIGENZONES)
+		return tRet;
+
+	results = lazy.release();
+
+	return tRet;
+}
+
+RetCode ECHMET_CC CZESystemImpl::evaluateLinear(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acSample,
+						const NonidealityCorrections corrections, Results &results) noexcept
+{
+	static const int32_t LINEAR_ONLY = evalPart(EvaluationParts::EVAL_ALL) & ~evalPart(EvaluationParts::EVAL_DISPERSION);
+
+	return evaluateInternal(acBGE, acSample, corrections, LINEAR_ONLY, results);
+}
+
+RetCode CZESystemImpl::fillResultsParts(const uint64_t generation, const int32_t parts, Results &results, int32_t &filled) noexcept
+{
+	static const int32_t LINEAR_PARTS = evalPart(EvaluationParts::EVAL_EIGENMOBILITIES) |
+					    evalPart(EvaluationParts::EVAL_ZONE_COMPOSITIONS) |
+					    evalPart(EvaluationParts::EVAL_ZONE_PROPERTIES) |
+					    evalPart(EvaluationParts::EVAL_DISPERSION) |
+					    evalPart(EvaluationParts::EVAL_SENSITIVITIES);
+
+	auto needs = [parts, &filled](const EvaluationParts part) {
+		return (parts & evalPart(part)) && !(filled & evalPart(part));
+	};
+
+	if ((parts & ~filled) != 0 && generation != m_generation) {
+		m_lastErrorString = "The system has been evaluated again since the results were created";
+
+		return RetCode::E_RESULTS_EXPIRED;
+	}
+
+	try {
+		if (needs(EvaluationParts::EVAL_BGE)) {
+			fillResultsBGE(m_chemicalSystemBGE, BGEProperties(), m_corrections, results);
+			filled |= evalPart(EvaluationParts::EVAL_BGE);
+		}
+
+		if ((parts & LINEAR_PARTS) && !(filled & FILLED_ANALYTES_DISSOCIATION)) {
+			fillResultsAnalytesDissociation(m_chemicalSystemFull, BGELikeProperties(), results);
+			filled |= FILLED_ANALYTES_DISSOCIATION;
+		}
+
+		if (needs(EvaluationParts::EVAL_EIGENMOBILITIES)) {
+			fillResultsEigenmobilities(linearModel(), results);
+			filled |= evalPart(EvaluationParts::EVAL_EIGENMOBILITIES);
+		}
+
+		if (needs(EvaluationParts::EVAL_ZONE_COMPOSITIONS)) {
+			fillResultsZoneCompositions(m_systemPack, zoneCompositions(), results);
+			filled |= evalPart(EvaluationParts::EVAL_ZONE_COMPOSITIONS);
+		}
+
+		if (needs(EvaluationParts::EVAL_ZONE_PROPERTIES)) {
+			const Calculator::LinearResults &linResults = zoneProperties();
+
+			fillResultsEigenzones(m_chemicalSystemFull, linResults, m_corrections, results);
+			filled |= evalPart(EvaluationParts::EVAL_ZONE_PROPERTIES);
+			if (!linResults.allZonesValid)
+				filled |= FILLED_PARTIAL_EIGENZONES;
+		}
+
+		if (needs(EvaluationParts::EVAL_DISPERSION)) {
+			fillResultsDispersion(dispersions(), results);
+			filled |= evalPart(EvaluationParts::EVAL_DISPERSION);
+		}
+
+		if (needs(EvaluationParts::EVAL_SENSITIVITIES)) {
+			fillResultsSensitivities(m_systemPack, linearModel(), dispersionModel(), results);
+			filled |= evalPart(EvaluationParts::EVAL_SENSITIVITIES);
+		}
+	} catch (std::bad_alloc &) {
+		m_lastErrorString = "Insufficient memory to fill results";
+
+		return RetCode::E_NO_MEMORY;
+	} catch (Calculator::CalculationException &ex) {
+		m_lastErrorString = ex.what();
+
+		return ex.errorCode();
+	}
+
+	if ((parts & evalPart(EvaluationParts::EVAL_ZONE_PROPERTIES)) && (filled & FILLED_PARTIAL_EIGENZONES))
+		return RetCode::E_PARTIAL_EIGENZONES;
+	return RetCode::OK;
+}
+
+bool CZESystemImpl::isAnalyte(const std::string &name)
+{
+	return m_prepared->isAnalyte(name);
+}
+
+const char * ECHMET_CC CZESystemImpl::lastErrorString() const noexcept
+{
+	return m_lastErrorString.c_str();
+}
+
+const Calculator::LinearModel & CZESystemImpl::linearModel()
+{
+	if (m_evalState->linearModel != nullptr)
+		return *m_evalState->linearModel;
+
+	BGELikeProperties();
+
+	try {
+		m_evalState->linearModel = std::unique_ptr<Calculator::LinearModel>{new Calculator::LinearModel{Calculator::makeLinearModel(m_systemPack, m_evalState->deltaPacks, m_evalState->reference())}};
+	} catch (std::bad_alloc &) {
+		ECHMET_TRACE(LEMNGTracing, EVAL_PROGRESS_ERR, "Cannot evaluate linear model", "Insufficient memory");
+
+		throw Calculator::CalculationException{"Insufficient memory to evaluate linear model", RetCode::E_NO_MEMORY};
+	} catch (Calculator::CalculationException &ex) {
+		ECHMET_TRACE(LEMNGTracing, EVAL_PROGRESS_ERR, "Cannot evaluate linear model", ex.what());
+		throw;
+	}
+
+	return *m_evalState->linearModel;
+}
+
+CZESystemImpl * CZESystemImpl::make(const SysComp::InConstituentVec *inCtuentVecBGE, const SysComp::InConstituentVec *inCtuentVecSample)
+{
+	PreparedSystemCache &cache = PreparedSystemCache::instance();
+	const std::string key = makeCompositionKey(inCtuentVecBGE, inCtuentVecSample);
+
+	PreparedSystemPtr prepared = cache.find(key);
+	if (prepared == nullptr) {
+		prepared = prepare(inCtuentVecBGE, inCtuentVecSample);
+		cache.insert(key, prepared);
+	}
+
+	return new CZESystemImpl{std::move(prepared)};
+}
+
+/*!
+ * Processes the compositions the same way as \p make() but neither
+ * looks them up in the cache of prepared systems nor adds them to it.
+ * Throws the same exceptions as \p make() if the compositions are invalid.
+ */
+void CZESystemImpl::validate(const SysComp::InConstituentVec *inCtuentVecBGE, const SysComp::InConstituentVec *inCtuentVecSample)
+{
+	prepare(inCtuentVecBGE, inCtuentVecSample);
+}
+
+RetCode ECHMET_CC CZESystemImpl::makeAnalyticalConcentrationsMaps(InAnalyticalConcentrationsMap *&acMapBGE, InAnalyticalConcentrationsMap *&acMapFull) const noexcept
+{
+	typedef std::unique_ptr<MutSKMapImpl<double>> InAnalyticalConcentrationsMapPtr;
+
+	auto fillMap = [](InAnalyticalConcentrationsMapPtr &acMap, const SysComp::ConstituentVec *cVec) {
+		SKMapImpl<double>::STLMap &stlMap = acMap->STL();
+
+		for (size_t idx = 0; idx < cVec->size(); idx++) {
+			const SysComp::Constituent *c = cVec->at(idx);
+			const std::string name{c->name->c_str()};
+
+			stlMap.emplace(name, 0.0);
+		}
+	};
+
+	try {
+		InAnalyticalConcentrationsMapPtr acMapBGEPtr{new MutSKMapImpl<double>{}};
+		InAnalyticalConcentrationsMapPtr acMapFullPtr{new MutSKMapImpl<double>{}};
+
+		fillMap(acMapBGEPtr, m_chemicalSystemBGE->constituents);
+		fillMap(acMapFullPtr, m_chemicalSystemFull->constituents);
+
+		acMapBGE = acMapBGEPtr.release();
+		acMapFull = acMapFullPtr.release();
+
+		return RetCode::OK;
+	} catch (std::bad_alloc &) {
+		acMapBGE = nullptr;
+		acMapFull = nullptr;
+
+		return RetCode::E_NO_MEMORY;
+	}
+}
+
+PreparedSystemPtr CZESystemImpl::prepare(const SysComp::InConstituentVec *inCtuentVecBGE, const SysComp::InConstituentVec *inCtuentVecSample)
+{
+	/* CalculatedProperties are specific to each CZESystem,
+	 * we need only the compositions here. */
+	auto makeChemicalSystem = [](const SysComp::InConstituentVec *inCtuentVec, const char *errorMessage) {
+		SysComp::ChemicalSystem *chemSystem = new SysComp::ChemicalSystem{};
+		SysComp::CalculatedProperties calcProps{};
+
+		::ECHMET::RetCode tRet = SysComp::makeComposition(*chemSystem, calcProps, inCtuentVec);
+		if (tRet != ::ECHMET::RetCode::OK) {
+			delete chemSystem;
+			throw SysCompException{errorMessage, tRet};
+		}
+		SysComp::releaseCalculatedProperties(calcProps);
+
+		return ChemicalSystemPtr{chemSystem, chemicalSystemDeleter};
+	};
+
+	ChemicalSystemPtr chemSystemBGE = makeChemicalSystem(inCtuentVecBGE, "Cannot make BGE system composition");
+	ChemicalSystemPtr chemSystemFull = makeChemicalSystem(inCtuentVecSample, "Cannot make full system composition");
+
+	IsAnalyteMap iaMap = makeIsAnalyteMap(inCtuentVecBGE, inCtuentVecSample);
+
+	validateCompositions(inCtuentVecBGE, inCtuentVecSample, iaMap);
+
+	return std::make_shared<const PreparedSystem>(std::move(chemSystemBGE), std::move(chemSystemFull), std::move(iaMap));
+}
+
+RetCode CZESystemImpl::setInput(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acSample, const NonidealityCorrections corrections) noexcept
 {
 	auto applyConcentrationMapping = [](RealVecPtr &acVec, const InAnalyticalConcentrationsMap *acMap, const ChemicalSystemPtr &chemSystem) {
 		InAnalyticalConcentrationsMap::Iterator *it = acMap->begin();
@@ -287,8 +640,9 @@ RetCode ECHMET_CC CZESystemImpl::evaluate(const InAnalyticalConcentrationsMap *a
 		it->destroy();
 	};
 
-	Calculator::DeltaPackVec deltaPacks{};
-	Calculator::DeltaPackVec deltaPacksUncharged{};
+	/* Any new input invalidates all results that have not been calculated yet */
+	m_generation++;
+
 	/* Initialize vectors of concentrations */
 	RealVecPtr analConcsBGE{nullptr, echmetRealVecDeleter};
 	RealVecPtr analConcsBGELike{nullptr, echmetRealVecDeleter};
@@ -320,179 +674,70 @@ RetCode ECHMET_CC CZESystemImpl::evaluate(const InAnalyticalConcentrationsMap *a
 		return RetCode::E_CONCENTRATION_TOO_LOW;
 	}
 
-	auto isAnalyteFunc = [this](const std::string &s){ return this->isAnalyte(s); };
-
-	/* Prepare output results */
+	/* Everything derived from the BGE-like system can be reused
+	 * as long as the BGE and the corrections remain unchanged */
 	try {
-		results = prepareResults(m_chemicalSystemBGE, m_chemicalSystemFull, isAnalyteFunc);
-	} catch (std::bad_alloc &) {
-		m_lastErrorString = "Insufficient memory to prepare results";
-		ECHMET_TRACE(LEMNGTracing, EVAL_INIT_ERR, "Cannot prepare Results data structures", "Insufficient memory");
-
-		return RetCode::E_NO_MEMORY;
-	}
-
-	Calculator::SolutionProperties BGEProps;
-	try {
-		BGEProps = Calculator::calculateSolutionProperties(m_chemicalSystemBGE, analConcsBGE, m_calcPropsBGE, corrections, true);
-	} catch (const Calculator::CalculationException &ex) {
-		releaseResults(results);
-		m_lastErrorString = std::string{"Unable to calculate BGE properties: "} + ex.what();
-		ECHMET_TRACE(LEMNGTracing, EVAL_PROGRESS_ERR, "Unable to calculate BGE properties", ex.what());
-
-		return RetCode::E_CANNOT_SOLVE_BGE;
-	}
-
-	m_systemPack.conductivity = BGEProps.conductivity;
-
-	Calculator::SolutionProperties BGELikeProps;
-	/* Precalculate what is used in many places of the linear model */
-	try {
-		Calculator::prepareModelData(m_systemPack, m_systemPackUncharged, deltaPacks, deltaPacksUncharged, analConcsBGELike, analConcsFull, BGELikeProps, corrections);
-	} catch (std::bad_alloc &) {
-		fillResultsBGE(m_chemicalSystemBGE, BGEProps, corrections, results);
-		return RetCode::E_NO_MEMORY;
-	} catch (Calculator::CalculationException &ex) {
-		fillResultsBGE(m_chemicalSystemBGE, BGEProps, corrections, results);
-		m_lastErrorString = ex.what();
-		ECHMET_TRACE(LEMNGTracing, EVAL_PROGRESS_ERR, "Cannot prepare model data", ex.what());
-
-		return ex.errorCode();
-	}
-
-	/* Solve the linear model and first nonlinearity term */
-	bool allZonesValid;
-	try {
-		Calculator::LinearResults linResults = Calculator::calculateLinear(m_systemPack, deltaPacks, corrections);
-		Calculator::EigenzoneDispersionVec ezDisps = Calculator::calculateNonlinear(m_systemPack, m_systemPackUncharged, analConcsBGELike, deltaPacks, deltaPacksUncharged,
-											    linResults.M1, linResults.M2, linResults.QLQR, corrections);
+		if (!m_evalState->matches(analConcsBGE, analConcsBGELike, corrections))
+			m_evalState->reset(analConcsBGE, analConcsBGELike, corrections);
+		else {
+			m_evalState->resetSample();
 
-		fillResults(m_chemicalSystemBGE, m_chemicalSystemFull, BGEProps, BGELikeProps, linResults, ezDisps, corrections, results);
-		allZonesValid = linResults.allZonesValid;
+			if (m_evalState->BGELikeProps != nullptr) {
+				Calculator::bindSampleConcentrations(m_systemPack, analConcsFull);
+			}
+		}
 	} catch (std::bad_alloc &) {
-		fillResultsBGE(m_chemicalSystemBGE, BGEProps, corrections, results);
-		fillResultsAnalytesDissociation(m_chemicalSystemFull, BGELikeProps, results);
-		ECHMET_TRACE(LEMNGTracing, EVAL_PROGRESS_ERR, "Cannot evaluate linear model", "Insufficient memory");
+		m_lastErrorString = "Insufficient memory to store evaluation state";
+		ECHMET_TRACE(LEMNGTracing, EVAL_INIT_ERR, "Cannot store evaluation state", "Insufficient memory");
 
 		return RetCode::E_NO_MEMORY;
-	} catch (Calculator::CalculationException &ex) {
-		fillResultsBGE(m_chemicalSystemBGE, BGEProps, corrections, results);
-		fillResultsAnalytesDissociation(m_chemicalSystemFull, BGELikeProps, results);
-		m_lastErrorString = ex.what();
-		ECHMET_TRACE(LEMNGTracing, EVAL_PROGRESS_ERR, "Cannot evaluate linear model", ex.what());
-
-		return ex.errorCode();
 	}
 
-	if (allZonesValid)
-		return RetCode::OK;
-	return RetCode::E_PARTIAL_EIGENZONES;
-}
-
-bool CZESystemImpl::isAnalyte(const std::string &name)
-{
-	return m_isAnalyteMap.at(name);
-}
+	m_analConcsBGE = std::move(analConcsBGE);
+	m_analConcsBGELike = std::move(analConcsBGELike);
+	m_analConcsFull = std::move(analConcsFull);
+	m_corrections = corrections;
 
-const char * ECHMET_CC CZESystemImpl::lastErrorString() const noexcept
-{
-	return m_lastErrorString.c_str();
+	return RetCode::OK;
 }
 
-CZESystemImpl * CZESystemImpl::make(const SysComp::InConstituentVec *inCtuentVecBGE, const SysComp::InConstituentVec *inCtuentVecSample)
+const Calculator::ZoneCompositionVec & CZESystemImpl::zoneCompositions()
 {
-	SysComp::ChemicalSystem chemSystemBGE{};
-	SysComp::ChemicalSystem chemSystemFull{};
-	SysComp::CalculatedProperties calcPropsBGE{};
-	SysComp::CalculatedProperties calcPropsFull{};
-
-	::ECHMET::RetCode tRet = SysComp::makeComposition(chemSystemBGE, calcPropsBGE, inCtuentVecBGE);
-	if (tRet != ::ECHMET::RetCode::OK)
-		throw SysCompException{"Cannot make BGE system composition", tRet};
+	if (m_evalState->zoneCompositions != nullptr)
+		return *m_evalState->zoneCompositions;
 
-	tRet = SysComp::makeComposition(chemSystemFull, calcPropsFull, inCtuentVecSample);
-	if (tRet != ::ECHMET::RetCode::OK) {
-		SysComp::releaseChemicalSystem(chemSystemBGE);
-		throw SysCompException{"Cannot make full system composition", tRet};
-	}
+	const Calculator::LinearModel &linModel = linearModel();
 
 	try {
-		IsAnalyteMap iaMap = makeIsAnalyteMap(inCtuentVecBGE, inCtuentVecSample);
-
-		validateCompositions(inCtuentVecBGE, inCtuentVecSample, iaMap);
-
-		return new CZESystemImpl(chemSystemBGE, calcPropsBGE, chemSystemFull, calcPropsFull, std::move(iaMap));
-	} catch (std::bad_alloc &up) {
-		SysComp::releaseChemicalSystem(chemSystemBGE);
-		SysComp::releaseChemicalSystem(chemSystemFull);
-		throw up;
+		m_evalState->zoneCompositions = std::unique_ptr<Calculator::ZoneCompositionVec>{new Calculator::ZoneCompositionVec{
+			Calculator::calculateZoneCompositions(linModel, m_systemPack)}};
+	} catch (std::bad_alloc &) {
+		throw Calculator::CalculationException{"Insufficient memory to calculate eigenzone compositions", RetCode::E_NO_MEMORY};
 	}
+
+	return *m_evalState->zoneCompositions;
 }
 
-RetCode ECHMET_CC CZESystemImpl::makeAnalyticalConcentrationsMaps(InAnalyticalConcentrationsMap *&acMapBGE, InAnalyticalConcentrationsMap *&acMapFull) const noexcept
+const Calculator::LinearResults & CZESystemImpl::zoneProperties()
 {
-	typedef std::unique_ptr<MutSKMapImpl<double>> InAnalyticalConcentrationsMapPtr;
-
-	auto fillMap = [](InAnalyticalConcentrationsMapPtr &acMap, const SysComp::ConstituentVec *cVec) {
-		SKMapImpl<double>::STLMap &stlMap = acMap->STL();
+	if (m_evalState->linearResults != nullptr)
+		return *m_evalState->linearResults;
 
-		for (size_t idx = 0; idx < cVec->size(); idx++) {
-			const SysComp::Constituent *c = cVec->at(idx);
-			const std::string name{c->name->c_str()};
-
-			stlMap.emplace(name, 0.0);
-		}
-	};
+	const Calculator::ZoneCompositionVec &compositions = zoneCompositions();
 
 	try {
-		InAnalyticalConcentrationsMapPtr acMapBGEPtr{new MutSKMapImpl<double>{}};
-		InAnalyticalConcentrationsMapPtr acMapFullPtr{new MutSKMapImpl<double>{}};
-
-		fillMap(acMapBGEPtr, m_chemicalSystemBGE->constituents);
-		fillMap(acMapFullPtr, m_chemicalSystemFull->constituents);
-
-		acMapBGE = acMapBGEPtr.release();
-		acMapFull = acMapFullPtr.release();
-
-		return RetCode::OK;
+		m_evalState->linearResults = std::unique_ptr<Calculator::LinearResults>{new Calculator::LinearResults{
+			Calculator::solveEigenzones(compositions, m_systemPack, m_corrections)}};
 	} catch (std::bad_alloc &) {
-		acMapBGE = nullptr;
-		acMapFull = nullptr;
+		ECHMET_TRACE(LEMNGTracing, EVAL_PROGRESS_ERR, "Cannot solve eigenzones", "Insufficient memory");
 
-		return RetCode::E_NO_MEMORY;
+		throw Calculator::CalculationException{"Insufficient memory to solve eigenzones", RetCode::E_NO_MEMORY};
+	} catch (Calculator::CalculationException &ex) {
+		ECHMET_TRACE(LEMNGTracing, EVAL_PROGRESS_ERR, "Cannot solve eigenzones", ex.what());
+		throw;
 	}
-}
 
-void CZESystemImpl::setupInternal(const SysComp::ChemicalSystem &chemicalSystemBGE, const SysComp::CalculatedProperties &calcPropsBGE, const SysComp::ChemicalSystem &chemicalSystemFull, const SysComp::CalculatedProperties &calcPropsFull)
-{
-	m_chemicalSystemBGE->constituents = chemicalSystemBGE.constituents;
-	m_chemicalSystemBGE->ionicForms = chemicalSystemBGE.ionicForms;
-	m_chemicalSystemBGE->analyticalConcentrationsByName = chemicalSystemBGE.analyticalConcentrationsByName;
-	m_chemicalSystemBGE->ionicConcentrationsByName = chemicalSystemBGE.ionicConcentrationsByName;
-	m_chemicalSystemBGE->effectiveMobilitiesByName = chemicalSystemBGE.effectiveMobilitiesByName;
-	m_chemicalSystemBGE->ionicMobilitiesByName = chemicalSystemBGE.ionicMobilitiesByName;
-
-	m_calcPropsBGE->ionicConcentrations = calcPropsBGE.ionicConcentrations;
-	m_calcPropsBGE->ionicMobilities = calcPropsBGE.ionicMobilities;
-	m_calcPropsBGE->effectiveMobilities = calcPropsBGE.effectiveMobilities;
-	m_calcPropsBGE->ionicStrength = 0;
-	m_calcPropsBGE->conductivity = 0;
-
-	m_chemicalSystemFull->constituents = chemicalSystemFull.constituents;
-	m_chemicalSystemFull->ionicForms = chemicalSystemFull.ionicForms;
-	m_chemicalSystemFull->analyticalConcentrationsByName = chemicalSystemFull.analyticalConcentrationsByName;
-	m_chemicalSystemFull->ionicConcentrationsByName = chemicalSystemFull.ionicConcentrationsByName;
-	m_chemicalSystemFull->effectiveMobilitiesByName = chemicalSystemFull.effectiveMobilitiesByName;
-	m_chemicalSystemFull->ionicMobilitiesByName = chemicalSystemFull.ionicMobilitiesByName;
-
-	m_calcPropsFull->ionicConcentrations = calcPropsFull.ionicConcentrations;
-	m_calcPropsFull->ionicMobilities = calcPropsFull.ionicMobilities;
-	m_calcPropsFull->effectiveMobilities = calcPropsFull.effectiveMobilities;
-	m_calcPropsFull->ionicStrength = 0;
-	m_calcPropsFull->conductivity = 0;
-
-	m_systemPack = Calculator::makeSystemPack(m_chemicalSystemFull, m_calcPropsFull, [this](const std::string &s) { return this->isAnalyte(s); }, false);
-	m_systemPackUncharged = Calculator::makeSystemPack(m_chemicalSystemFull, m_calcPropsFull, [this](const std::string &s) { return this->isAnalyte(s); }, true);
+	return *m_evalState->linearResults;
 }
 
 const char * ECHMET_CC LEMNGerrorToString(const RetCode tRet) noexcept
@@ -517,15 +762,23 @@ const char * ECHMET_CC LEMNGerrorToString(const RetCode tRet) noexcept
 		ERROR_CODE_CASE(E_PARTIAL_EIGENZONES);
 		ERROR_CODE_CASE(E_INVALID_COMPOSITION_PARAMS);
 		ERROR_CODE_CASE(E_INVALID_COMPOSITION_MISSING);
+		ERROR_CODE_CASE(E_RESULTS_EXPIRED);
+		ERROR_CODE_CASE(E_IO_ERROR);
+		ERROR_CODE_CASE(E_INVALID_FILE);
 	default:
 		return "Unknown error code";
 	}
 }
 
-RetCode ECHMET_CC makeCZESystem(SysComp::InConstituentVec *BGE, SysComp::InConstituentVec *sample, CZESystem *&czeSystem) noexcept
+/*!
+ * Maps exceptions raised by processing of input compositions to return codes
+ */
+template <typename Operation>
+static
+RetCode processCompositions(Operation &&op) noexcept
 {
 	try {
-		czeSystem = CZESystemImpl::make(BGE, sample);
+		op();
 	} catch (std::bad_alloc &) {
 		return RetCode::E_NO_MEMORY;
 	} catch (InvalidComposition &ex) {
@@ -544,6 +797,65 @@ RetCode ECHMET_CC makeCZESystem(SysComp::InConstituentVec *BGE, SysComp::InConst
 	return RetCode::OK;
 }
 
+RetCode ECHMET_CC makeCZESystem(SysComp::InConstituentVec *BGE, SysComp::InConstituentVec *sample, CZESystem *&czeSystem) noexcept
+{
+	return processCompositions([&]() {
+		czeSystem = CZESystemImpl::make(BGE, sample);
+	});
+}
+
+RetCode validateCompositions(const SysComp::InConstituentVec *BGE, const SysComp::InConstituentVec *sample) noexcept
+{
+	return processCompositions([&]() {
+		CZESystemImpl::validate(BGE, sample);
+	});
+}
+
+void ECHMET_CC setCZESystemCacheCapacity(const size_t capacity) noexcept
+{
+	PreparedSystemCache::instance().setCapacity(capacity);
+}
+
+void ECHMET_CC clearCZESystemCache() noexcept
+{
+	PreparedSystemCache::instance().clear();
+}
+
+void ECHMET_CC czeSystemCacheStatistics(RCZESystemCacheStatistics &stats) noexcept
+{
+	PreparedSystemCache::instance().statistics(stats.entries, stats.hits, stats.misses);
+}
+
+RetCode ECHMET_CC compositionKey(const SysComp::InConstituentVec *BGE, const SysComp::InConstituentVec *sample, FixedString *&key) noexcept
+{
+	static const char HEX_DIGITS[] = "0123456789abcdef";
+
+	if (BGE == nullptr || sample == nullptr)
+		return RetCode::E_INVALID_ARGUMENT;
+
+	try {
+		/* The key is binary, make it printable */
+		const std::string raw = makeCompositionKey(BGE, sample);
+		std::string printable{};
+		printable.reserve(2 * raw.size());
+
+		for (const char c : raw) {
+			const unsigned char u = static_cast<unsigned char>(c);
+
+			printable.push_back(HEX_DIGITS[u >> 4]);
+			printable.push_back(HEX_DIGITS[u & 0xF]);
+		}
+
+		key = createFixedString(printable.c_str());
+		if (key == nullptr)
+			return RetCode::E_NO_MEMORY;
+	} catch (std::bad_alloc &) {
+		return RetCode::E_NO_MEMORY;
+	}
+
+	return RetCode::OK;
+}
+
 double ECHMET_CC minimumSafeConcentration() noexcept
 {
 	return Calculator::ANALYTE_CONCENTRATION * 10.0;
@@ -563,6 +875,8 @@ void ECHMET_CC releaseCZESystem(const CZESystem *czeSystem) noexcept
 
 CZESystem::~CZESystem() noexcept {}
 
+LazyResults::~LazyResults() noexcept {}
+
 void ECHMET_CC toggleAllTracepoints(const bool state) noexcept
 {
 	if (state)
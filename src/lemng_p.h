@@ -4,40 +4,109 @@
 #include <lemng.h>
 #include "base_types.h"
 #include "calculator_types.h"
+#include "system_cache.h"
 
 namespace ECHMET {
 namespace LEMNG {
 
+namespace Calculator {
+	class DispersionModel;
+	class EigenzoneDispersion;
+	class LinearModel;
+	class LinearResults;
+	class ZoneComposition;
+
+	typedef std::vector<EigenzoneDispersion> EigenzoneDispersionVec;
+	typedef std::vector<ZoneComposition> ZoneCompositionVec;
+} // namespace Calculator
+
+class EvaluationState;
+
+/*!
+ * Helper to combine \p EvaluationParts flags
+ */
+inline constexpr
+int32_t evalPart(const EvaluationParts part)
+{
+	return static_cast<int32_t>(part);
+}
+
+static const int32_t ALL_EVALUATION_PARTS = evalPart(EvaluationParts::EVAL_ALL) | evalPart(EvaluationParts::EVAL_SENSITIVITIES);	/*!< All valid \p EvaluationParts flags */
+static const int32_t FILLED_ANALYTES_DISSOCIATION = 0x100;	/*!< Internal flag, dissociation of analytes has been filled into the results */
+static const int32_t FILLED_PARTIAL_EIGENZONES = 0x200;	/*!< Internal flag, some eigenzones could not have been resolved */
+
 class CZESystemImpl : public CZESystem {
 public:
-	explicit CZESystemImpl();
-	explicit CZESystemImpl(CZESystemImpl &&other) noexcept;
-	explicit CZESystemImpl(const SysComp::ChemicalSystem &chemicalSystemBGE, const SysComp::CalculatedProperties &calcPropsBGE, const SysComp::ChemicalSystem &chemicalSystemFull, const SysComp::CalculatedProperties &calcPropsFull, const IsAnalyteMap &iaMap);
-	explicit CZESystemImpl(const SysComp::ChemicalSystem &chemicalSystemBGE, const SysComp::CalculatedProperties &calcPropsBGE, const SysComp::ChemicalSystem &chemicalSystemFull, const SysComp::CalculatedProperties& calcPropsFull, IsAnalyteMap &&iaMap);
+	explicit CZESystemImpl(PreparedSystemPtr prepared);
 	virtual ~CZESystemImpl() noexcept override;
 	virtual RetCode ECHMET_CC evaluate(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acFull,
 					   const NonidealityCorrections corrections, Results &results) noexcept override;
 	virtual const char * ECHMET_CC lastErrorString() const noexcept override;
 	virtual RetCode ECHMET_CC makeAnalyticalConcentrationsMaps(InAnalyticalConcentrationsMap *&acMapBGE, InAnalyticalConcentrationsMap *&acMapFull) const noexcept override;
+	virtual RetCode ECHMET_CC evaluateLazy(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acFull,
+					       const NonidealityCorrections corrections, const int32_t parts, LazyResults *&results) noexcept override;
+	virtual RetCode ECHMET_CC evaluateLinear(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acFull,
+						 const NonidealityCorrections corrections, Results &results) noexcept override;
+	virtual RetCode ECHMET_CC sweep(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acFull,
+					const char *constituent, const int32_t target, const RealVec *path,
+					const NonidealityCorrections corrections, const int32_t parts, RSweepPointVec *&points) noexcept override;
+	virtual RetCode ECHMET_CC optimizeBGE(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acFull,
+					      const InAnalyticalConcentrationsMap *lowerBounds, const InAnalyticalConcentrationsMap *upperBounds,
+					      const int32_t objective, const NonidealityCorrections corrections, const int32_t maxIterations,
+					      InAnalyticalConcentrationsMap *acBGEOptimum, double &objectiveValue) noexcept override;
+	virtual RetCode ECHMET_CC makeGridScanBuffer(const GridScanAxis *axes, const int32_t numAxes, RGridScanBuffer *&buffer) const noexcept override;
+	virtual RetCode ECHMET_CC gridScan(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acFull,
+					   const GridScanAxis *axes, const int32_t numAxes, const NonidealityCorrections corrections,
+					   const bool calcDispersion, RGridScanBuffer *buffer) noexcept override;
+	virtual RetCode ECHMET_CC gridScanToFile(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acFull,
+						 const GridScanAxis *axes, const int32_t numAxes, const NonidealityCorrections corrections,
+						 const bool calcDispersion, const char *path) noexcept override;
+
+	RetCode fillResultsParts(const uint64_t generation, const int32_t parts, Results &results, int32_t &filled) noexcept;
 
 	static CZESystemImpl * make(const SysComp::InConstituentVec *inCtuentVecBGE, const SysComp::InConstituentVec *inCtuentVecSample);
+	static void validate(const SysComp::InConstituentVec *inCtuentVecBGE, const SysComp::InConstituentVec *inCtuentVecSample);
 
 private:
+	static PreparedSystemPtr prepare(const SysComp::InConstituentVec *inCtuentVecBGE, const SysComp::InConstituentVec *inCtuentVecSample);
+	const Calculator::SolutionProperties & BGELikeProperties();
+	const Calculator::SolutionProperties & BGEProperties();
+	const Calculator::DispersionModel & dispersionModel();
+	const Calculator::EigenzoneDispersionVec & dispersions();
+	RetCode evaluateInternal(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acSample,
+				 const NonidealityCorrections corrections, const int32_t parts, Results &results) noexcept;
+	RetCode evaluateObjective(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acSample,
+				  const NonidealityCorrections corrections, const int32_t objective,
+				  double &value, size_t &first, size_t &second) noexcept;
+	RetCode objectiveGradient(const std::vector<size_t> &columns, const size_t first, const size_t second, std::vector<double> &gradient) noexcept;
 	bool isAnalyte(const std::string &name);
-	void setupInternal(const SysComp::ChemicalSystem &chemicalSystemBGE, const SysComp::CalculatedProperties &calcPropsBGE, const SysComp::ChemicalSystem &chemicalSystemFull, const SysComp::CalculatedProperties &calcPropsFull);
+	const Calculator::LinearModel & linearModel();
+	RetCode scanPoint(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acSample, const NonidealityCorrections corrections,
+			  const bool calcDispersion, RGridScanBuffer *buffer, const size_t pointIdx) noexcept;
+	RetCode setInput(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acSample, const NonidealityCorrections corrections) noexcept;
+	RetCode solveEquilibria(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acSample, const NonidealityCorrections corrections) noexcept;
+	const Calculator::ZoneCompositionVec & zoneCompositions();
+	const Calculator::LinearResults & zoneProperties();
 
-	ChemicalSystemPtr m_chemicalSystemBGE;
-	ChemicalSystemPtr m_chemicalSystemFull;
+	const PreparedSystemPtr m_prepared;		/*!< Composition-dependent data shared with other systems of the same composition */
+	const ChemicalSystemPtr &m_chemicalSystemBGE;
+	const ChemicalSystemPtr &m_chemicalSystemFull;
 	CalculatedPropertiesPtr m_calcPropsBGE;
 	CalculatedPropertiesPtr m_calcPropsFull;
 	Calculator::CalculatorSystemPack m_systemPack;
-	Calculator::CalculatorSystemPack m_systemPackUncharged;
-
-	IsAnalyteMap m_isAnalyteMap;
+	RealVecPtr m_analConcsBGE;			/*!< Analytical concentrations of the plain BGE given to the last evaluation */
+	RealVecPtr m_analConcsBGELike;
+	RealVecPtr m_analConcsFull;
+	NonidealityCorrections m_corrections;
+	std::unique_ptr<EvaluationState> m_evalState;	/*!< Intermediate results of the last evaluation */
+	uint64_t m_generation;				/*!< Incremented with every new input, used to expire lazily evaluated results */
+	bool m_warmStart;				/*!< Equilibrium solver starts from the distribution found by the previous evaluation */
 
 	std::string m_lastErrorString;
 };
 
+RetCode validateCompositions(const SysComp::InConstituentVec *BGE, const SysComp::InConstituentVec *sample) noexcept;
+
 } // namespace LEMNG
 } // namesoace ECHMET
 
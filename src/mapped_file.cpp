@@ -0,0 +1,187 @@
+#include "mapped_file.h"
+#include <cstdint>
+#include <limits>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif // NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif // _WIN32
+
+namespace ECHMET {
+namespace LEMNG {
+
+MappedFile::MappedFile() noexcept :
+	m_data{nullptr},
+	m_size{0}
+{
+}
+
+MappedFile::~MappedFile() noexcept
+{
+	close();
+}
+
+char * MappedFile::data() const noexcept
+{
+	return m_data;
+}
+
+size_t MappedFile::size() const noexcept
+{
+	return m_size;
+}
+
+#ifdef _WIN32
+void MappedFile::close() noexcept
+{
+	if (m_data != nullptr)
+		UnmapViewOfFile(m_data);
+
+	m_data = nullptr;
+	m_size = 0;
+}
+
+bool MappedFile::create(const char *path, const size_t size) noexcept
+{
+	const uint64_t size64 = size;
+
+	HANDLE hFile = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	/* Mapping extends the file to the requested size */
+	HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64 & 0xFFFFFFFF), nullptr);
+	CloseHandle(hFile);
+	if (hMapping == nullptr)
+		return false;
+
+	void *view = MapViewOfFile(hMapping, FILE_MAP_WRITE, 0, 0, size);
+	CloseHandle(hMapping);
+	if (view == nullptr)
+		return false;
+
+	m_data = static_cast<char *>(view);
+	m_size = size;
+
+	return true;
+}
+
+bool MappedFile::flush() noexcept
+{
+	return FlushViewOfFile(m_data, m_size) != 0;
+}
+
+bool MappedFile::open(const char *path) noexcept
+{
+	HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart < 0 ||
+	    static_cast<uint64_t>(fileSize.QuadPart) > std::numeric_limits<size_t>::max()) {
+		CloseHandle(hFile);
+		return false;
+	}
+
+	/* Empty file cannot be mapped, leave it to the caller to reject it as too short */
+	if (fileSize.QuadPart == 0) {
+		CloseHandle(hFile);
+		return true;
+	}
+
+	HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	CloseHandle(hFile);
+	if (hMapping == nullptr)
+		return false;
+
+	void *view = MapViewOfFile(hMapping, FILE_MAP_COPY, 0, 0, 0);
+	CloseHandle(hMapping);
+	if (view == nullptr)
+		return false;
+
+	m_data = static_cast<char *>(view);
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+
+	return true;
+}
+#else
+void MappedFile::close() noexcept
+{
+	if (m_data != nullptr)
+		munmap(m_data, m_size);
+
+	m_data = nullptr;
+	m_size = 0;
+}
+
+bool MappedFile::create(const char *path, const size_t size) noexcept
+{
+	const int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return false;
+
+	if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+		::close(fd);
+		return false;
+	}
+
+	void *view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (view == MAP_FAILED)
+		return false;
+
+	m_data = static_cast<char *>(view);
+	m_size = size;
+
+	return true;
+}
+
+bool MappedFile::flush() noexcept
+{
+	return msync(m_data, m_size, MS_SYNC) == 0;
+}
+
+bool MappedFile::open(const char *path) noexcept
+{
+	const int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < 0 ||
+	    static_cast<uint64_t>(st.st_size) > std::numeric_limits<size_t>::max()) {
+		::close(fd);
+		return false;
+	}
+
+	/* Empty file cannot be mapped, leave it to the caller to reject it as too short */
+	if (st.st_size == 0) {
+		::close(fd);
+		return true;
+	}
+
+	const size_t size = static_cast<size_t>(st.st_size);
+
+	/* Private mapping lets the caller modify the columns without touching the file */
+	void *view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (view == MAP_FAILED)
+		return false;
+
+	m_data = static_cast<char *>(view);
+	m_size = size;
+
+	return true;
+}
+#endif // _WIN32
+
+} // namespace LEMNG
+} // namespace ECHMET
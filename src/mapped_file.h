@@ -0,0 +1,37 @@
+#ifndef ECHMET_LEMNG_MAPPED_FILE_H
+#define ECHMET_LEMNG_MAPPED_FILE_H
+
+#include <cstddef>
+
+namespace ECHMET {
+namespace LEMNG {
+
+/*!
+ * File mapped into memory.
+ * Handles of the file are closed right after the file is mapped, the mapping stays valid until \p close() is called.
+ * An empty file is opened successfully with no mapping, \p data() is <tt>nullptr</tt> and \p size() is zero.
+ */
+class MappedFile {
+public:
+	MappedFile() noexcept;
+	MappedFile(const MappedFile &other) = delete;
+	~MappedFile() noexcept;
+
+	MappedFile & operator=(const MappedFile &other) = delete;
+
+	void close() noexcept;
+	bool create(const char *path, const size_t size) noexcept;
+	char * data() const noexcept;
+	bool flush() noexcept;
+	bool open(const char *path) noexcept;
+	size_t size() const noexcept;
+
+private:
+	char *m_data;
+	size_t m_size;
+};
+
+} // namespace LEMNG
+} // namespace ECHMET
+
+#endif // ECHMET_LEMNG_MAPPED_FILE_H
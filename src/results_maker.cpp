@@ -9,6 +9,8 @@
 #include <containers/echmetvec_p.h>
 #include <containers/echmetskmap_p.h>
 
+#include <limits>
+
 namespace ECHMET {
 namespace LEMNG {
 
@@ -94,8 +96,11 @@ void teardownRIonVec(VecImpl<RIon, false> *vec)
 static
 void teardownREigenzoneVec(VecImpl<REigenzone, false> *vec)
 {
-	for (auto &&ez: vec->STL())
+	for (auto &&ez: vec->STL()) {
 		releaseRSolutionProperties(ez.solutionProperties);
+		if (ez.mobilitySensitivities != nullptr)
+			ez.mobilitySensitivities->destroy();
+	}
 
 	vec->destroy();
 }
@@ -287,6 +292,9 @@ REigenzoneVecWrapper prepareEigenzones(const ChemicalSystemPtr &chemSystem)
 		REigenzone ez;
 
 		zeroize<REigenzone>(&ez);
+		/* Dispersion parameters are unavailable unless the nonlinear stage is evaluated */
+		ez.a2t = std::numeric_limits<double>::quiet_NaN();
+		ez.uEMD = std::numeric_limits<double>::quiet_NaN();
 
 		auto composition = prepareComposition(chemSystem);
 		SKMapImpl<RConstituent> *compositionRaw = composition.release();
@@ -367,34 +375,13 @@ void fillSolutionProperties(const ChemicalSystemPtr &chemSystem, const Calculato
 
 void fillResults(const ChemicalSystemPtr &chemSystemBGE, const ChemicalSystemPtr &chemSystemFull, const Calculator::SolutionProperties &BGEProperties, const Calculator::SolutionProperties &BGELikeProperties, const Calculator::LinearResults &linResults, const Calculator::EigenzoneDispersionVec &ezDisps, const NonidealityCorrections corrections, Results &r)
 {
-	auto fillEigenzone = [corrections](const ChemicalSystemPtr &chemSystem, const Calculator::Eigenzone &ez, const Calculator::EigenzoneDispersion &disp, REigenzone &rEz) {
-		if (ez.valid)
-			fillSolutionProperties(chemSystem, ez.solutionProperties, corrections, rEz.solutionProperties);
-
-		rEz.mobility = ez.zoneMobility;
-		rEz.a2t = disp.a2t;
-		rEz.uEMD = disp.uEMD;
-		rEz.tainted = ez.tainted;
-		rEz.ztype = [ez]() {
-			if (ez.isAnalyteZone)
-				return EigenzoneType::ANALYTE;
-			return EigenzoneType::SYSTEM;
-		}();
-		rEz.valid = ez.valid;
-	};
-
 	/* Fill out BGE properties */
 	fillResultsBGE(chemSystemBGE, BGEProperties, corrections, r);
 	fillResultsAnalytesDissociation(chemSystemFull, BGELikeProperties, r);
 
 	/* Fill out all eigenzones */
-	for (size_t idx = 0; idx < linResults.eigenzones.size(); idx++) {
-		const Calculator::Eigenzone &ez = linResults.eigenzones.at(idx);
-		const Calculator::EigenzoneDispersion &disp = ezDisps.at(idx);
-		REigenzone &rEz = (*r.eigenzones)[idx];
-
-		fillEigenzone(chemSystemFull, ez, disp, rEz);
-	}
+	fillResultsEigenzones(chemSystemFull, linResults, corrections, r);
+	fillResultsDispersion(ezDisps, r);
 }
 
 void fillResultsBGE(const ChemicalSystemPtr &chemSystemBGE, const Calculator::SolutionProperties &BGEProperties, const NonidealityCorrections corrections, Results &r)
@@ -408,6 +395,79 @@ void fillResultsAnalytesDissociation(const ChemicalSystemPtr &chemSystemFull, co
 	fillAnalytesDissociation(chemSystemFull, BGELikeProperties, r.analytesDissociation);
 }
 
+void fillResultsDispersion(const Calculator::EigenzoneDispersionVec &ezDisps, Results &r)
+{
+	for (size_t idx = 0; idx < ezDisps.size(); idx++) {
+		const Calculator::EigenzoneDispersion &disp = ezDisps.at(idx);
+		REigenzone &rEz = (*r.eigenzones)[idx];
+
+		rEz.a2t = disp.a2t;
+		rEz.uEMD = disp.uEMD;
+	}
+}
+
+void fillResultsEigenmobilities(const Calculator::LinearModel &linModel, Results &r)
+{
+	for (int idx = 0; idx < linModel.eigenmobilities.size(); idx++)
+		(*r.eigenzones)[idx].mobility = linModel.eigenmobilities(idx).real();
+}
+
+void fillResultsEigenzones(const ChemicalSystemPtr &chemSystemFull, const Calculator::LinearResults &linResults, const NonidealityCorrections corrections, Results &r)
+{
+	for (size_t idx = 0; idx < linResults.eigenzones.size(); idx++) {
+		const Calculator::Eigenzone &ez = linResults.eigenzones.at(idx);
+		REigenzone &rEz = (*r.eigenzones)[idx];
+
+		if (ez.valid)
+			fillSolutionProperties(chemSystemFull, ez.solutionProperties, corrections, rEz.solutionProperties);
+
+		rEz.mobility = ez.zoneMobility;
+		rEz.tainted = ez.tainted;
+		rEz.ztype = ez.isAnalyteZone ? EigenzoneType::ANALYTE : EigenzoneType::SYSTEM;
+		rEz.valid = ez.valid;
+	}
+}
+
+void fillResultsSensitivities(const Calculator::CalculatorSystemPack &systemPack, const Calculator::LinearModel &linModel, const Calculator::DispersionModel &dispModel, Results &r)
+{
+	for (int idx = 0; idx < dispModel.dLdC.rows(); idx++) {
+		REigenzone &rEz = (*r.eigenzones)[idx];
+		SKMapImpl<double> *sensitivities = new SKMapImpl<double>{};
+
+		rEz.mobility = linModel.eigenmobilities(idx).real();
+		rEz.mobilitySensitivities = sensitivities;
+
+		/* Analytes are present only in traces in the BGE-like system */
+		for (size_t jdx = 0; jdx < systemPack.constituents.size(); jdx++) {
+			const Calculator::CalculatorConstituent &cc = systemPack.constituents.at(jdx);
+
+			if (!cc.isAnalyte)
+				sensitivities->STL().emplace(cc.name, dispModel.dLdC(idx, jdx));
+		}
+	}
+}
+
+void fillResultsZoneCompositions(const Calculator::CalculatorSystemPack &systemPack, const Calculator::ZoneCompositionVec &compositions, Results &r)
+{
+	for (size_t idx = 0; idx < compositions.size(); idx++) {
+		const Calculator::ZoneComposition &zc = compositions.at(idx);
+		REigenzone &rEz = (*r.eigenzones)[idx];
+		auto &compositionSTL = static_cast<SKMapImpl<RConstituent> *>(rEz.solutionProperties.composition)->STL();
+
+		/* Only the analytical concentrations are known at this point,
+		 * the rest of the solution properties requires an equilibrium solve. */
+		for (size_t jdx = 0; jdx < systemPack.constituents.size(); jdx++) {
+			const Calculator::CalculatorConstituent &cc = systemPack.constituents.at(jdx);
+
+			compositionSTL.at(cc.name).concentration = zc.constituentConcentrations.at(jdx);
+		}
+
+		rEz.mobility = zc.zoneMobility;
+		rEz.tainted = zc.tainted;
+		rEz.ztype = zc.isAnalyteZone ? EigenzoneType::ANALYTE : EigenzoneType::SYSTEM;
+	}
+}
+
 Results prepareResults(const ChemicalSystemPtr &chemSystemBGE, const ChemicalSystemPtr &chemSystemFull, IsAnalyteFunc &isAnalyte)
 {
 	Results r;
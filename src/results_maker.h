@@ -11,6 +11,11 @@ namespace LEMNG {
 	void fillResults(const ChemicalSystemPtr &chemSystemBGE, const ChemicalSystemPtr &chemSystemFull, const Calculator::SolutionProperties &BGEProperties, const Calculator::SolutionProperties &BGELikeProperties, const Calculator::LinearResults &linResults, const Calculator::EigenzoneDispersionVec &ezDisps, const NonidealityCorrections corrections, Results &r);
 	void fillResultsBGE(const ChemicalSystemPtr &chemSystemBGE, const Calculator::SolutionProperties &BGEProperties, const NonidealityCorrections corrections, Results &r);
 	void fillResultsAnalytesDissociation(const ChemicalSystemPtr &chemSystemFull, const Calculator::SolutionProperties &BGELikeProperties, Results &r);
+	void fillResultsDispersion(const Calculator::EigenzoneDispersionVec &ezDisps, Results &r);
+	void fillResultsEigenmobilities(const Calculator::LinearModel &linModel, Results &r);
+	void fillResultsSensitivities(const Calculator::CalculatorSystemPack &systemPack, const Calculator::LinearModel &linModel, const Calculator::DispersionModel &dispModel, Results &r);
+	void fillResultsEigenzones(const ChemicalSystemPtr &chemSystemFull, const Calculator::LinearResults &linResults, const NonidealityCorrections corrections, Results &r);
+	void fillResultsZoneCompositions(const Calculator::CalculatorSystemPack &systemPack, const Calculator::ZoneCompositionVec &compositions, Results &r);
 	Results prepareResults(const ChemicalSystemPtr &chemSystemBGE, const ChemicalSystemPtr &chemSystemFull, IsAnalyteFunc &isAnalyte);
 
 } // namespace LEMNG
@@ -0,0 +1,285 @@
+#include "lemng_p.h"
+#include "calculator_common.h"
+#include "evaluation_state.h"
+#include "helpers.h"
+#include <algorithm>
+#include <cmath>
+#include <new>
+
+#define USE_ECHMET_CONTAINERS
+#include <containers/echmetvec_p.h>
+
+namespace ECHMET {
+namespace LEMNG {
+
+static const size_t MAX_SWEEP_SUBDIVISIONS = 3;	/*!< Maximum number of times a step to a point that cannot be solved
+							     or that crosses eigenmobilities is halved */
+static const double SWEEP_MIN_OVERLAP = 0.9;		/*!< Eigenvectors that turn further than this between two points
+							     might have been matched to the wrong eigenzones */
+static const double SWEEP_MIN_EIGENMOBILITY_GAP = 0.5;	/*!< Eigenmobilities closer than this are about to cross */
+
+/*!
+ * Checks whether the eigenmobilities of some eigenzones crossed or came close to each other
+ * on the step from the previous point. The step might have been too long to match the
+ * eigenzones to those of the previous point reliably.
+ *
+ * @param[in] previous Eigenmobilities of the previous point.
+ * @param[in] model Linear model of this point.
+ */
+static
+bool crossingSuspected(const Calculator::EMVectorC &previous, const Calculator::LinearModel &model)
+{
+	const Calculator::EMVectorC &current = model.eigenmobilities;
+
+	if (model.referenceOverlap < SWEEP_MIN_OVERLAP)
+		return true;
+	if (previous.size() != current.size())
+		return false;
+
+	for (int idx = 0; idx < current.size(); idx++) {
+		for (int jdx = idx + 1; jdx < current.size(); jdx++) {
+			const double gapBefore = previous(idx).real() - previous(jdx).real();
+			const double gap = current(idx).real() - current(jdx).real();
+
+			if (gapBefore * gap < 0.0)
+				return true;
+			if (std::abs(gap) < SWEEP_MIN_EIGENMOBILITY_GAP && std::abs(gapBefore) >= SWEEP_MIN_EIGENMOBILITY_GAP)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+/*!
+ * Failures that might be overcome by approaching the point in smaller steps.
+ */
+static
+bool isSolverFailure(const RetCode tRet)
+{
+	return tRet == RetCode::E_CANNOT_SOLVE_BGE || tRet == RetCode::E_CHEM_SYSTEM_UNSOLVABLE;
+}
+
+static
+void releaseSweepPointsImpl(VecImpl<RSweepPoint, false> *points) noexcept
+{
+	for (auto &pt : points->STL()) {
+		if (pt.results.isBGEValid)
+			releaseResults(pt.results);
+	}
+
+	points->destroy();
+}
+
+RetCode CZESystemImpl::solveEquilibria(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acSample, const NonidealityCorrections corrections) noexcept
+{
+	RetCode tRet = setInput(acBGE, acSample, corrections);
+	if (tRet != RetCode::OK)
+		return tRet;
+
+	try {
+		BGEProperties();
+		BGELikeProperties();
+	} catch (std::bad_alloc &) {
+		m_lastErrorString = "Insufficient memory to solve equilibria";
+
+		return RetCode::E_NO_MEMORY;
+	} catch (Calculator::CalculationException &ex) {
+		m_lastErrorString = ex.what();
+
+		return ex.errorCode();
+	}
+
+	return RetCode::OK;
+}
+
+RetCode ECHMET_CC CZESystemImpl::sweep(const InAnalyticalConcentrationsMap *acBGE, const InAnalyticalConcentrationsMap *acFull,
+				       const char *constituent, const int32_t target, const RealVec *path,
+				       const NonidealityCorrections corrections, const int32_t parts, RSweepPointVec *&points) noexcept
+{
+	static const int32_t SWEEP_BGE = static_cast<int32_t>(SweepTarget::SWEEP_BGE);
+	static const int32_t SWEEP_SAMPLE = static_cast<int32_t>(SweepTarget::SWEEP_SAMPLE);
+	static const int32_t SWEEP_BOTH = static_cast<int32_t>(SweepTarget::SWEEP_BOTH);
+
+	if (acBGE == nullptr || acFull == nullptr || constituent == nullptr || path == nullptr) {
+		m_lastErrorString = "Invalid sweep parameters";
+		return RetCode::E_INVALID_ARGUMENT;
+	}
+
+	if (target == 0 || (target & ~SWEEP_BOTH)) {
+		m_lastErrorString = "Invalid sweep target";
+		return RetCode::E_INVALID_ARGUMENT;
+	}
+
+	if ((parts & ~ALL_EVALUATION_PARTS) || !(parts & evalPart(EvaluationParts::EVAL_BGE))) {
+		m_lastErrorString = "Invalid evaluation parts, the BGE must always be evaluated";
+		return RetCode::E_INVALID_ARGUMENT;
+	}
+
+	if (((target & SWEEP_BGE) && !acBGE->contains(constituent)) ||
+	    ((target & SWEEP_SAMPLE) && !acFull->contains(constituent))) {
+		m_lastErrorString = "Swept constituent " + std::string{constituent} + " is not present in the targeted composition";
+		return RetCode::E_INVALID_ARGUMENT;
+	}
+
+	VecImpl<RSweepPoint, false> *pointsImpl = createECHMETVec<RSweepPoint, false>(path->size());
+	if (pointsImpl == nullptr)
+		return RetCode::E_NO_MEMORY;
+
+	try {
+		InAnalyticalConcentrationsMapPtr acBGEPoint = copyConcentrationsMap(acBGE);
+		InAnalyticalConcentrationsMapPtr acFullPoint = copyConcentrationsMap(acFull);
+
+		auto setConcentration = [&](const double c) {
+			if (target & SWEEP_BGE)
+				acBGEPoint->item(constituent) = c;
+			if (target & SWEEP_SAMPLE)
+				acFullPoint->item(constituent) = c;
+		};
+
+		/* Walks from the last solved concentration towards the requested one in equal steps
+		 * and solves only the equilibria on the way. The first step solves the last solved
+		 * concentration again to restore the distribution that the solver starts from. */
+		auto approach = [&](const double from, const double to, const size_t steps) {
+			for (size_t step = 0; step < steps; step++) {
+				setConcentration(from + (to - from) * step / steps);
+
+				if (solveEquilibria(acBGEPoint.get(), acFullPoint.get(), corrections) != RetCode::OK)
+					return false;
+			}
+			setConcentration(to);
+
+			return true;
+		};
+
+		/* Walks from the last solved concentration towards the requested one in equal steps
+		 * and evaluates the linear model of each step so that each step follows the previous one.
+		 * Reports the smallest overlap of the eigenvectors of two adjacent steps. */
+		auto retrace = [&](const double from, const double to, const size_t steps, double &minOverlap) {
+			minOverlap = 1.0;
+			for (size_t step = 0; step < steps; step++) {
+				setConcentration(from + (to - from) * step / steps);
+
+				if (solveEquilibria(acBGEPoint.get(), acFullPoint.get(), corrections) != RetCode::OK)
+					return false;
+
+				try {
+					minOverlap = std::min(minOverlap, linearModel().referenceOverlap);
+				} catch (Calculator::CalculationException &) {
+					return false;
+				}
+			}
+			setConcentration(to);
+
+			return true;
+		};
+
+		bool haveSolved = false;
+		double lastSolved = 0.0;
+		std::unique_ptr<Calculator::QLQRPack> lastQLQR{};
+		Calculator::EMVectorC lastEigenmobs{};
+
+		/* Order of the eigenzones must not depend on what this system evaluated before the sweep.
+		 * The first point is ordered as the solver returns it, every other point follows the last
+		 * point that got as far as the linear model. Adjacent points differ only slightly so the
+		 * eigenvectors of a zone stay close to their previous direction even where the eigenmobilities
+		 * of two zones cross, matching against the first point could swap the zones far from it. */
+		m_evalState->clear();
+
+		for (size_t idx = 0; idx < path->size(); idx++) {
+			RSweepPoint pt{ECHMETRealToDouble(path->at(idx)), RetCode::OK, Results{}};
+
+			setConcentration(pt.concentration);
+			pt.status = evaluateInternal(acBGEPoint.get(), acFullPoint.get(), corrections, parts, pt.results);
+
+			for (size_t level = 1; level <= MAX_SWEEP_SUBDIVISIONS && haveSolved && isSolverFailure(pt.status); level++) {
+				if (!approach(lastSolved, pt.concentration, size_t(1) << level))
+					continue;
+
+				if (pt.results.isBGEValid)
+					releaseResults(pt.results);
+				pt.results = Results{};
+				pt.status = evaluateInternal(acBGEPoint.get(), acFullPoint.get(), corrections, parts, pt.results);
+			}
+
+			/* Zones whose eigenmobilities cross may be matched the other way round if the step is too long.
+			 * The point is approached again from the last solved point in shorter steps, each of which
+			 * follows the previous one, until the eigenvectors turn only a little between the steps. */
+			if (lastQLQR != nullptr && (pt.status == RetCode::OK || pt.status == RetCode::E_PARTIAL_EIGENZONES) &&
+			    m_evalState->linearModel != nullptr && crossingSuspected(lastEigenmobs, *m_evalState->linearModel)) {
+				const Calculator::QLQRPack QLQR{m_evalState->linearModel->QLQR};
+				const Calculator::EMVectorC eigenmobs{m_evalState->linearModel->eigenmobilities};
+				bool retraced = false;
+
+				for (size_t level = 1; level <= MAX_SWEEP_SUBDIVISIONS; level++) {
+					double minOverlap;
+
+					m_evalState->restart(*lastQLQR);
+					if (!retrace(lastSolved, pt.concentration, size_t(1) << level, minOverlap))
+						continue;
+
+					Results results{};
+					const RetCode tRet = evaluateInternal(acBGEPoint.get(), acFullPoint.get(), corrections, parts, results);
+					if ((tRet != RetCode::OK && tRet != RetCode::E_PARTIAL_EIGENZONES) || m_evalState->linearModel == nullptr) {
+						if (results.isBGEValid)
+							releaseResults(results);
+						continue;
+					}
+
+					if (pt.results.isBGEValid)
+						releaseResults(pt.results);
+					pt.results = results;
+					pt.status = tRet;
+					retraced = true;
+
+					if (std::min(minOverlap, m_evalState->linearModel->referenceOverlap) >= SWEEP_MIN_OVERLAP)
+						break;
+				}
+
+				/* Keep following the point as it was evaluated in one step */
+				if (!retraced) {
+					m_evalState->restart(QLQR);
+					lastQLQR = std::unique_ptr<Calculator::QLQRPack>{new Calculator::QLQRPack{QLQR}};
+					lastEigenmobs = eigenmobs;
+				}
+			}
+
+			if (pt.status == RetCode::OK || pt.status == RetCode::E_PARTIAL_EIGENZONES) {
+				haveSolved = true;
+				lastSolved = pt.concentration;
+				if (m_evalState->linearModel != nullptr) {
+					lastQLQR = std::unique_ptr<Calculator::QLQRPack>{new Calculator::QLQRPack{m_evalState->linearModel->QLQR}};
+					lastEigenmobs = m_evalState->linearModel->eigenmobilities;
+				}
+			}
+			m_warmStart = haveSolved;
+
+			if (pointsImpl->push_back(pt) != ::ECHMET::RetCode::OK) {
+				if (pt.results.isBGEValid)
+					releaseResults(pt.results);
+				throw std::bad_alloc{};
+			}
+		}
+	} catch (std::bad_alloc &) {
+		m_warmStart = false;
+		releaseSweepPointsImpl(pointsImpl);
+		m_lastErrorString = "Insufficient memory to perform the sweep";
+
+		return RetCode::E_NO_MEMORY;
+	}
+
+	m_warmStart = false;
+	points = pointsImpl;
+
+	return RetCode::OK;
+}
+
+void ECHMET_CC releaseSweepPoints(RSweepPointVec *points) noexcept
+{
+	VecImpl<RSweepPoint, false> *pointsImpl = dynamic_cast<VecImpl<RSweepPoint, false> *>(points);
+	if (pointsImpl != nullptr)
+		releaseSweepPointsImpl(pointsImpl);
+}
+
+} // namespace LEMNG
+} // namespace ECHMET
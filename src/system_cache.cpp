@@ -0,0 +1,630 @@
+#include "system_cache.h"
+#include "calculator_common.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace ECHMET {
+namespace LEMNG {
+
+/*!
+ * Appends values to the canonical composition key.
+ * All values are stored in their binary form, strings and vectors are length-prefixed
+ * so that no two different compositions can serialize to the same sequence.
+ */
+class KeyWriter {
+public:
+	explicit KeyWriter(std::string &key) :
+		m_key(key)
+	{}
+
+	void put(const int32_t v)
+	{
+		putRaw(&v, sizeof(v));
+	}
+
+	void put(const uint64_t v)
+	{
+		putRaw(&v, sizeof(v));
+	}
+
+	void put(const double v)
+	{
+		/* Distinguish only by the exact bit pattern. Values that
+		 * compare equal but differ in representation (-0.0, NaNs)
+		 * merely cause a cache miss. */
+		uint64_t bits;
+		std::memcpy(&bits, &v, sizeof(v));
+		put(bits);
+	}
+
+	void put(const FixedString *s)
+	{
+		const size_t len = std::strlen(s->c_str());
+
+		put(static_cast<uint64_t>(len));
+		putRaw(s->c_str(), len);
+	}
+
+	void put(const RealVec *v)
+	{
+		if (v == nullptr) {
+			put(static_cast<uint64_t>(0));
+			return;
+		}
+
+		put(static_cast<uint64_t>(v->size()));
+		for (size_t idx = 0; idx < v->size(); idx++)
+			put(ECHMETRealToDouble(v->at(idx)));
+	}
+
+private:
+	void putRaw(const void *data, const size_t size)
+	{
+		m_key.append(static_cast<const char *>(data), size);
+	}
+
+	std::string &m_key;
+};
+
+static
+void serializeLigandForm(KeyWriter &writer, const SysComp::InLigandForm &lf)
+{
+	writer.put(lf.ligandName);
+	writer.put(lf.charge);
+	writer.put(lf.maxCount);
+	writer.put(lf.pBs);
+	writer.put(lf.mobilities);
+}
+
+static
+void serializeComplexForms(KeyWriter &writer, const SysComp::InCFVec *cfVec)
+{
+	if (cfVec == nullptr) {
+		writer.put(static_cast<uint64_t>(0));
+		return;
+	}
+
+	/* Each nucleus charge may have only one complex form so ordering
+	 * by the charge is sufficient to make the key independent of
+	 * the order in which the complex forms were specified. */
+	std::vector<const SysComp::InComplexForm *> ordered{};
+	ordered.reserve(cfVec->size());
+	for (size_t idx = 0; idx < cfVec->size(); idx++)
+		ordered.emplace_back(&cfVec->at(idx));
+
+	std::stable_sort(ordered.begin(), ordered.end(), [](const SysComp::InComplexForm *first, const SysComp::InComplexForm *second) {
+		return first->nucleusCharge < second->nucleusCharge;
+	});
+
+	writer.put(static_cast<uint64_t>(ordered.size()));
+	for (const SysComp::InComplexForm *cf : ordered) {
+		writer.put(cf->nucleusCharge);
+		writer.put(static_cast<uint64_t>(cf->ligandGroups->size()));
+
+		for (size_t idx = 0; idx < cf->ligandGroups->size(); idx++) {
+			const SysComp::InLigandGroup &lgg = cf->ligandGroups->at(idx);
+
+			writer.put(static_cast<uint64_t>(lgg.ligands->size()));
+			for (size_t jdx = 0; jdx < lgg.ligands->size(); jdx++)
+				serializeLigandForm(writer, lgg.ligands->at(jdx));
+		}
+	}
+}
+
+static
+void serializeConstituent(KeyWriter &writer, const SysComp::InConstituent &c)
+{
+	writer.put(static_cast<int32_t>(c.ctype));
+	writer.put(c.name);
+	writer.put(c.chargeLow);
+	writer.put(c.chargeHigh);
+	writer.put(c.pKas);
+	writer.put(c.mobilities);
+	writer.put(ECHMETRealToDouble(c.viscosityCoefficient));
+	serializeComplexForms(writer, c.complexForms);
+}
+
+static
+void serializeComposition(KeyWriter &writer, const SysComp::InConstituentVec *ctuentVec)
+{
+	std::vector<const SysComp::InConstituent *> ordered{};
+	ordered.reserve(ctuentVec->size());
+	for (size_t idx = 0; idx < ctuentVec->size(); idx++)
+		ordered.emplace_back(&ctuentVec->at(idx));
+
+	std::sort(ordered.begin(), ordered.end(), [](const SysComp::InConstituent *first, const SysComp::InConstituent *second) {
+		return std::strcmp(first->name->c_str(), second->name->c_str()) < 0;
+	});
+
+	writer.put(static_cast<uint64_t>(ordered.size()));
+	for (const SysComp::InConstituent *c : ordered)
+		serializeConstituent(writer, *c);
+}
+
+/*!
+ * Creates a canonical representation of a pair of input compositions.
+ * Compositions that differ only in the order of constituents or complex forms
+ * produce identical keys.
+ *
+ * @param[in] BGEVec Composition of the background electrolyte.
+ * @param[in] sampleVec Composition of the sample zone.
+ *
+ * @return Binary key usable for exact comparison and hashing.
+ */
+std::string makeCompositionKey(const SysComp::InConstituentVec *BGEVec, const SysComp::InConstituentVec *sampleVec)
+{
+	std::string key{};
+	KeyWriter writer{key};
+
+	serializeComposition(writer, BGEVec);
+	serializeComposition(writer, sampleVec);
+
+	return key;
+}
+
+/*!
+ * Reads values written by \p KeyWriter.
+ * Reads past the end of the data raise \p MalformedCompositionKey.
+ */
+class KeyReader {
+public:
+	explicit KeyReader(const char *data, const size_t size) :
+		m_data(data),
+		m_size(size),
+		m_pos(0)
+	{}
+
+	bool atEnd() const
+	{
+		return m_pos == m_size;
+	}
+
+	/*!
+	 * Reads the number of items that follow. Counts that cannot possibly fit into
+	 * the remaining data are rejected before anything is allocated for them.
+	 */
+	uint64_t getCount(const size_t itemSize)
+	{
+		const uint64_t count = getUInt64();
+		if (count > (m_size - m_pos) / itemSize)
+			throw MalformedCompositionKey{};
+
+		return count;
+	}
+
+	double getDouble()
+	{
+		const uint64_t bits = getUInt64();
+		double v;
+
+		std::memcpy(&v, &bits, sizeof(v));
+		return v;
+	}
+
+	int32_t getInt32()
+	{
+		int32_t v;
+
+		getRaw(&v, sizeof(v));
+		return v;
+	}
+
+	FixedString * getString()
+	{
+		const uint64_t len = getCount(1);
+		const std::string s(m_data + m_pos, len);
+		m_pos += len;
+
+		FixedString *fs = createFixedString(s.c_str());
+		if (fs == nullptr)
+			throw std::bad_alloc{};
+
+		return fs;
+	}
+
+	RealVec * getRealVec()
+	{
+		const uint64_t size = getCount(sizeof(uint64_t));
+
+		RealVec *v = createRealVec(size);
+		if (v == nullptr)
+			throw std::bad_alloc{};
+
+		for (uint64_t idx = 0; idx < size; idx++) {
+			if (v->push_back(getDouble()) != ::ECHMET::RetCode::OK) {
+				v->destroy();
+				throw std::bad_alloc{};
+			}
+		}
+
+		return v;
+	}
+
+	uint64_t getUInt64()
+	{
+		uint64_t v;
+
+		getRaw(&v, sizeof(v));
+		return v;
+	}
+
+private:
+	void getRaw(void *data, const size_t size)
+	{
+		if (size > m_size - m_pos)
+			throw MalformedCompositionKey{};
+
+		std::memcpy(data, m_data + m_pos, size);
+		m_pos += size;
+	}
+
+	const char *m_data;
+	const size_t m_size;
+	size_t m_pos;
+};
+
+template <typename T>
+static
+void pushItem(Vec<T> *vec, const T &item)
+{
+	if (vec->push_back(item) != ::ECHMET::RetCode::OK)
+		throw std::bad_alloc{};
+}
+
+/*
+ * Release functions below tolerate partially read items.
+ */
+static
+void releaseLigandForm(const SysComp::InLigandForm &lf)
+{
+	if (lf.ligandName != nullptr)
+		lf.ligandName->destroy();
+	if (lf.pBs != nullptr)
+		lf.pBs->destroy();
+	if (lf.mobilities != nullptr)
+		lf.mobilities->destroy();
+}
+
+static
+void releaseLigandGroups(const SysComp::InLGVec *lgVec)
+{
+	if (lgVec == nullptr)
+		return;
+
+	for (size_t idx = 0; idx < lgVec->size(); idx++) {
+		const SysComp::InLFVec *lfVec = lgVec->at(idx).ligands;
+
+		for (size_t jdx = 0; jdx < lfVec->size(); jdx++)
+			releaseLigandForm(lfVec->at(jdx));
+		lfVec->destroy();
+	}
+	lgVec->destroy();
+}
+
+static
+void releaseComplexForms(const SysComp::InCFVec *cfVec)
+{
+	if (cfVec == nullptr)
+		return;
+
+	for (size_t idx = 0; idx < cfVec->size(); idx++)
+		releaseLigandGroups(cfVec->at(idx).ligandGroups);
+	cfVec->destroy();
+}
+
+static
+void releaseConstituent(const SysComp::InConstituent &c)
+{
+	if (c.name != nullptr)
+		c.name->destroy();
+	if (c.pKas != nullptr)
+		c.pKas->destroy();
+	if (c.mobilities != nullptr)
+		c.mobilities->destroy();
+	releaseComplexForms(c.complexForms);
+}
+
+static
+void releaseComposition(const SysComp::InConstituentVec *ctuentVec)
+{
+	for (size_t idx = 0; idx < ctuentVec->size(); idx++)
+		releaseConstituent(ctuentVec->at(idx));
+	ctuentVec->destroy();
+}
+
+static
+SysComp::InLFVec * deserializeLigandGroup(KeyReader &reader)
+{
+	const uint64_t size = reader.getCount(1);
+
+	SysComp::InLFVec *lfVec = SysComp::createInLFVec(size);
+	if (lfVec == nullptr)
+		throw std::bad_alloc{};
+
+	try {
+		for (uint64_t idx = 0; idx < size; idx++) {
+			SysComp::InLigandForm lf{nullptr, 0, 0, nullptr, nullptr};
+
+			try {
+				lf.ligandName = reader.getString();
+				lf.charge = reader.getInt32();
+				lf.maxCount = reader.getInt32();
+				lf.pBs = reader.getRealVec();
+				lf.mobilities = reader.getRealVec();
+
+				pushItem(lfVec, lf);
+			} catch (...) {
+				releaseLigandForm(lf);
+				throw;
+			}
+		}
+	} catch (...) {
+		for (size_t idx = 0; idx < lfVec->size(); idx++)
+			releaseLigandForm(lfVec->at(idx));
+		lfVec->destroy();
+		throw;
+	}
+
+	return lfVec;
+}
+
+static
+SysComp::InCFVec * deserializeComplexForms(KeyReader &reader, const SysComp::ConstituentType ctype)
+{
+	const uint64_t size = reader.getCount(1);
+
+	/* Ligands have no complex forms at all */
+	if (size == 0 && ctype == SysComp::ConstituentType::LIGAND)
+		return nullptr;
+
+	SysComp::InCFVec *cfVec = SysComp::createInCFVec(size);
+	if (cfVec == nullptr)
+		throw std::bad_alloc{};
+
+	try {
+		for (uint64_t idx = 0; idx < size; idx++) {
+			SysComp::InComplexForm cf{reader.getInt32(), nullptr};
+			const uint64_t numGroups = reader.getCount(1);
+
+			cf.ligandGroups = SysComp::createInLGVec(numGroups);
+			if (cf.ligandGroups == nullptr)
+				throw std::bad_alloc{};
+
+			try {
+				for (uint64_t jdx = 0; jdx < numGroups; jdx++) {
+					SysComp::InLigandGroup lgg{deserializeLigandGroup(reader)};
+
+					try {
+						pushItem(cf.ligandGroups, lgg);
+					} catch (...) {
+						for (size_t kdx = 0; kdx < lgg.ligands->size(); kdx++)
+							releaseLigandForm(lgg.ligands->at(kdx));
+						lgg.ligands->destroy();
+						throw;
+					}
+				}
+
+				pushItem(cfVec, cf);
+			} catch (...) {
+				releaseLigandGroups(cf.ligandGroups);
+				throw;
+			}
+		}
+	} catch (...) {
+		releaseComplexForms(cfVec);
+		throw;
+	}
+
+	return cfVec;
+}
+
+static
+SysComp::InConstituentVec * deserializeComposition(KeyReader &reader)
+{
+	const uint64_t size = reader.getCount(1);
+
+	SysComp::InConstituentVec *ctuentVec = SysComp::createInConstituentVec(size);
+	if (ctuentVec == nullptr)
+		throw std::bad_alloc{};
+
+	try {
+		for (uint64_t idx = 0; idx < size; idx++) {
+			SysComp::InConstituent c{SysComp::ConstituentType::INVALID, nullptr, 0, 0, nullptr, nullptr, nullptr, 0.0};
+
+			try {
+				c.ctype = static_cast<SysComp::ConstituentType>(reader.getInt32());
+				if (c.ctype != SysComp::ConstituentType::NUCLEUS && c.ctype != SysComp::ConstituentType::LIGAND)
+					throw MalformedCompositionKey{};
+
+				c.name = reader.getString();
+				c.chargeLow = reader.getInt32();
+				c.chargeHigh = reader.getInt32();
+				c.pKas = reader.getRealVec();
+				c.mobilities = reader.getRealVec();
+				c.viscosityCoefficient = reader.getDouble();
+				c.complexForms = deserializeComplexForms(reader, c.ctype);
+
+				pushItem(ctuentVec, c);
+			} catch (...) {
+				releaseConstituent(c);
+				throw;
+			}
+		}
+	} catch (...) {
+		releaseComposition(ctuentVec);
+		throw;
+	}
+
+	return ctuentVec;
+}
+
+/*!
+ * Rebuilds the input compositions from a key created by \p makeCompositionKey().
+ * Constituents and complex forms are created in the canonical order of the key.
+ *
+ * @param[in] key Composition key.
+ * @param[in] size Length of the key.
+ * @param[out] BGEVec Composition of the background electrolyte.
+ * @param[out] sampleVec Composition of the sample zone.
+ *
+ * @throws MalformedCompositionKey The key is truncated or contains invalid data.
+ * @throws std::bad_alloc Insufficient memory.
+ */
+void parseCompositionKey(const char *key, const size_t size, SysComp::InConstituentVec *&BGEVec, SysComp::InConstituentVec *&sampleVec)
+{
+	KeyReader reader{key, size};
+
+	SysComp::InConstituentVec *BGE = deserializeComposition(reader);
+	SysComp::InConstituentVec *sample = nullptr;
+
+	try {
+		sample = deserializeComposition(reader);
+		if (!reader.atEnd())
+			throw MalformedCompositionKey{};
+	} catch (...) {
+		releaseComposition(BGE);
+		if (sample != nullptr)
+			releaseComposition(sample);
+		throw;
+	}
+
+	BGEVec = BGE;
+	sampleVec = sample;
+}
+
+const char * MalformedCompositionKey::what() const noexcept
+{
+	return "Malformed composition key";
+}
+
+PreparedSystem::PreparedSystem(ChemicalSystemPtr &&chemicalSystemBGE, ChemicalSystemPtr &&chemicalSystemFull, IsAnalyteMap &&iaMap) :
+	chemicalSystemBGE{std::move(chemicalSystemBGE)},
+	chemicalSystemFull{std::move(chemicalSystemFull)},
+	isAnalyteMap{std::move(iaMap)},
+	systemPack{Calculator::makeSystemPack(this->chemicalSystemFull, CalculatedPropertiesPtr{nullptr, calculatedPropertiesDeleter},
+					      [this](const std::string &s) { return this->isAnalyte(s); })}
+{
+}
+
+bool PreparedSystem::isAnalyte(const std::string &name) const
+{
+	return isAnalyteMap.at(name);
+}
+
+PreparedSystemCache::PreparedSystemCache() :
+	m_capacity{DEFAULT_SYSTEM_CACHE_CAPACITY},
+	m_hits{0},
+	m_misses{0}
+{
+}
+
+PreparedSystemCache & PreparedSystemCache::instance()
+{
+	static PreparedSystemCache cache{};
+
+	return cache;
+}
+
+size_t PreparedSystemCache::capacity() const
+{
+	std::lock_guard<std::mutex> lk{m_lock};
+
+	return m_capacity;
+}
+
+void PreparedSystemCache::clear()
+{
+	std::lock_guard<std::mutex> lk{m_lock};
+
+	m_index.clear();
+	m_lru.clear();
+	m_hits = 0;
+	m_misses = 0;
+}
+
+PreparedSystemPtr PreparedSystemCache::find(const std::string &key)
+{
+	std::lock_guard<std::mutex> lk{m_lock};
+
+	auto it = m_index.find(key);
+	if (it == m_index.end()) {
+		m_misses++;
+		return nullptr;
+	}
+
+	m_hits++;
+	m_lru.splice(m_lru.begin(), m_lru, it->second);
+
+	return it->second->second;
+}
+
+void PreparedSystemCache::insert(const std::string &key, const PreparedSystemPtr &system)
+{
+	std::lock_guard<std::mutex> lk{m_lock};
+
+	if (m_capacity == 0)
+		return;
+
+	auto it = m_index.find(key);
+	if (it != m_index.end()) {
+		/* Another thread may have prepared the same system concurrently */
+		m_lru.splice(m_lru.begin(), m_lru, it->second);
+		return;
+	}
+
+	m_lru.emplace_front(key, system);
+	try {
+		m_index.emplace(key, m_lru.begin());
+	} catch (std::bad_alloc &) {
+		m_lru.pop_front();
+		throw;
+	}
+
+	trim();
+}
+
+/*!
+ * Returns keys of all cached systems, the most recently used one first.
+ */
+std::vector<std::string> PreparedSystemCache::keys() const
+{
+	std::lock_guard<std::mutex> lk{m_lock};
+	std::vector<std::string> keys{};
+
+	keys.reserve(m_lru.size());
+	for (const auto &item : m_lru)
+		keys.emplace_back(item.first);
+
+	return keys;
+}
+
+void PreparedSystemCache::setCapacity(const size_t capacity)
+{
+	std::lock_guard<std::mutex> lk{m_lock};
+
+	m_capacity = capacity;
+	trim();
+}
+
+void PreparedSystemCache::statistics(size_t &entries, size_t &hits, size_t &misses) const
+{
+	std::lock_guard<std::mutex> lk{m_lock};
+
+	entries = m_lru.size();
+	hits = m_hits;
+	misses = m_misses;
+}
+
+void PreparedSystemCache::trim()
+{
+	/* Systems that are still in use by some CZESystem stay alive
+	 * through their shared pointers */
+	while (m_lru.size() > m_capacity) {
+		m_index.erase(m_lru.back().first);
+		m_lru.pop_back();
+	}
+}
+
+} // namespace LEMNG
+} // namespace ECHMET
@@ -0,0 +1,89 @@
+#ifndef ECHMET_LEMNG_SYSTEM_CACHE_H
+#define ECHMET_LEMNG_SYSTEM_CACHE_H
+
+#include "base_types.h"
+#include "calculator_types.h"
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ECHMET {
+namespace LEMNG {
+
+/*!
+ * Immutable part of a CZE system that depends only on the input compositions.
+ *
+ * Instances are shared among all \p CZESystemImpl objects created from the same
+ * compositions. Nothing in here may be modified once the object is constructed.
+ * Per-system mutable state (calculated properties, concentrations bound
+ * to the system packs) is kept by the \p CZESystemImpl itself.
+ */
+class PreparedSystem {
+public:
+	PreparedSystem(ChemicalSystemPtr &&chemicalSystemBGE, ChemicalSystemPtr &&chemicalSystemFull, IsAnalyteMap &&iaMap);
+	PreparedSystem(const PreparedSystem &other) = delete;
+
+	PreparedSystem & operator=(const PreparedSystem &other) = delete;
+
+	bool isAnalyte(const std::string &name) const;
+
+	const ChemicalSystemPtr chemicalSystemBGE;			/*!< Composition of the background electrolyte */
+	const ChemicalSystemPtr chemicalSystemFull;			/*!< Composition of the sample zone */
+	const IsAnalyteMap isAnalyteMap;				/*!< Map of analytes in the sample zone */
+	const Calculator::CalculatorSystemPack systemPack;		/*!< Template of the system pack with all ionic forms.
+									     Not bound to any \p CalculatedProperties. */
+};
+typedef std::shared_ptr<const PreparedSystem> PreparedSystemPtr;
+
+/*!
+ * Process-wide, size-bounded LRU cache of prepared systems.
+ *
+ * Prepared systems are looked up by a canonical serialization of the BGE
+ * and sample compositions as returned by \p makeCompositionKey(). The full
+ * key is compared on lookup so a hash collision can never return a wrong system.
+ */
+class PreparedSystemCache {
+public:
+	static PreparedSystemCache & instance();
+
+	size_t capacity() const;
+	void clear();
+	PreparedSystemPtr find(const std::string &key);
+	void insert(const std::string &key, const PreparedSystemPtr &system);
+	std::vector<std::string> keys() const;
+	void setCapacity(const size_t capacity);
+	void statistics(size_t &entries, size_t &hits, size_t &misses) const;
+
+private:
+	typedef std::list<std::pair<std::string, PreparedSystemPtr>> LRUList;
+
+	PreparedSystemCache();
+
+	void trim();
+
+	size_t m_capacity;
+	size_t m_hits;							/*!< Number of successful lookups since the last clear */
+	size_t m_misses;						/*!< Number of failed lookups since the last clear */
+	LRUList m_lru;							/*!< Most recently used entry is at the front */
+	std::unordered_map<std::string, LRUList::iterator> m_index;
+	mutable std::mutex m_lock;
+};
+
+/*!
+ * Composition key cannot be parsed.
+ */
+class MalformedCompositionKey : public std::exception {
+public:
+	const char * what() const noexcept override;
+};
+
+std::string makeCompositionKey(const SysComp::InConstituentVec *BGEVec, const SysComp::InConstituentVec *sampleVec);
+void parseCompositionKey(const char *key, const size_t size, SysComp::InConstituentVec *&BGEVec, SysComp::InConstituentVec *&sampleVec);
+
+static const size_t DEFAULT_SYSTEM_CACHE_CAPACITY = 32;
+
+} // namespace LEMNG
+} // namespace ECHMET
+
+#endif // ECHMET_LEMNG_SYSTEM_CACHE_H
@@ -0,0 +1,170 @@
+#include "lemng_p.h"
+#include "system_cache.h"
+#include "system_definition.h"
+#include <cstring>
+#include <fstream>
+#include <new>
+
+namespace ECHMET {
+namespace LEMNG {
+
+static const char SYSTEM_DEFINITION_MAGIC[8] = "LEMNGSD";	/*!< Identifies a system definition file */
+static const uint32_t SYSTEM_DEFINITION_VERSION = 2;		/*!< Version of the layout of the file */
+static const uint32_t SYSTEM_DEFINITION_BYTE_ORDER = 0x01020304;	/*!< Written in the native byte order of the machine that created the file */
+
+/*!
+ * Header of a system definition file.
+ * The header is followed by \p numEntries length-prefixed composition keys
+ * as returned by \p makeCompositionKey(). A file written by \p saveSystemDefinition()
+ * holds one key, a snapshot of the cache of prepared systems holds one key per cached system.
+ */
+class SystemDefinitionHeader {
+public:
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint64_t numEntries;
+	uint64_t payloadSize;
+};
+
+/*!
+ * Locates the composition keys stored in a mapped system definition file.
+ * The keys point into the mapping and remain valid for as long as the file stays mapped.
+ *
+ * @param[in] file Mapped system definition file.
+ * @param[out] entries Composition keys in the order they are stored in the file.
+ */
+RetCode readSystemDefinitions(const MappedFile &file, std::vector<SystemDefinitionEntry> &entries) noexcept
+{
+	if (file.size() < sizeof(SystemDefinitionHeader))
+		return RetCode::E_INVALID_FILE;
+
+	SystemDefinitionHeader header;
+	std::memcpy(&header, file.data(), sizeof(SystemDefinitionHeader));
+
+	const size_t payloadSize = file.size() - sizeof(SystemDefinitionHeader);
+	if (std::memcmp(header.magic, SYSTEM_DEFINITION_MAGIC, sizeof(SYSTEM_DEFINITION_MAGIC)) != 0 ||
+	    header.version != SYSTEM_DEFINITION_VERSION ||
+	    header.byteOrder != SYSTEM_DEFINITION_BYTE_ORDER ||
+	    header.payloadSize != payloadSize ||
+	    header.numEntries > payloadSize / sizeof(uint64_t))
+		return RetCode::E_INVALID_FILE;
+
+	try {
+		const char *payload = file.data() + sizeof(SystemDefinitionHeader);
+		size_t pos = 0;
+
+		entries.clear();
+		entries.reserve(header.numEntries);
+		for (uint64_t idx = 0; idx < header.numEntries; idx++) {
+			uint64_t size;
+
+			if (payloadSize - pos < sizeof(uint64_t))
+				return RetCode::E_INVALID_FILE;
+			std::memcpy(&size, payload + pos, sizeof(uint64_t));
+			pos += sizeof(uint64_t);
+
+			if (size > payloadSize - pos)
+				return RetCode::E_INVALID_FILE;
+			entries.emplace_back(payload + pos, size);
+			pos += size;
+		}
+
+		if (pos != payloadSize)
+			return RetCode::E_INVALID_FILE;
+	} catch (std::bad_alloc &) {
+		return RetCode::E_NO_MEMORY;
+	}
+
+	return RetCode::OK;
+}
+
+/*!
+ * Writes composition keys into a system definition file in the given order.
+ *
+ * @param[in] path Path to the file. Existing file is overwritten.
+ * @param[in] keys Composition keys as returned by \p makeCompositionKey().
+ */
+RetCode writeSystemDefinitions(const char *path, const std::vector<std::string> &keys) noexcept
+{
+	try {
+		SystemDefinitionHeader header;
+		std::memset(&header, 0, sizeof(SystemDefinitionHeader));
+		std::memcpy(header.magic, SYSTEM_DEFINITION_MAGIC, sizeof(SYSTEM_DEFINITION_MAGIC));
+		header.version = SYSTEM_DEFINITION_VERSION;
+		header.byteOrder = SYSTEM_DEFINITION_BYTE_ORDER;
+		header.numEntries = keys.size();
+		header.payloadSize = 0;
+		for (const std::string &key : keys)
+			header.payloadSize += sizeof(uint64_t) + key.size();
+
+		std::ofstream ofs{path, std::ios::binary | std::ios::trunc};
+		if (!ofs.is_open())
+			return RetCode::E_IO_ERROR;
+
+		ofs.write(reinterpret_cast<const char *>(&header), sizeof(SystemDefinitionHeader));
+		for (const std::string &key : keys) {
+			const uint64_t size = key.size();
+
+			ofs.write(reinterpret_cast<const char *>(&size), sizeof(uint64_t));
+			ofs.write(key.data(), key.size());
+		}
+		ofs.close();
+
+		if (ofs.fail())
+			return RetCode::E_IO_ERROR;
+	} catch (std::bad_alloc &) {
+		return RetCode::E_NO_MEMORY;
+	}
+
+	return RetCode::OK;
+}
+
+RetCode ECHMET_CC saveSystemDefinition(const char *path, SysComp::InConstituentVec *BGE, SysComp::InConstituentVec *sample) noexcept
+{
+	if (path == nullptr || BGE == nullptr || sample == nullptr)
+		return RetCode::E_INVALID_ARGUMENT;
+
+	/* Only compositions that can actually be solved are stored. Definitions are
+	 * often saved in bulk so the cache of prepared systems is left alone. */
+	const RetCode tRet = validateCompositions(BGE, sample);
+	if (tRet != RetCode::OK)
+		return tRet;
+
+	try {
+		return writeSystemDefinitions(path, { makeCompositionKey(BGE, sample) });
+	} catch (std::bad_alloc &) {
+		return RetCode::E_NO_MEMORY;
+	}
+}
+
+RetCode ECHMET_CC loadSystemDefinition(const char *path, SysComp::InConstituentVec *&BGE, SysComp::InConstituentVec *&sample) noexcept
+{
+	if (path == nullptr)
+		return RetCode::E_INVALID_ARGUMENT;
+
+	MappedFile file{};
+	if (!file.open(path))
+		return RetCode::E_IO_ERROR;
+
+	std::vector<SystemDefinitionEntry> entries{};
+	const RetCode tRet = readSystemDefinitions(file, entries);
+	if (tRet != RetCode::OK)
+		return tRet;
+
+	if (entries.size() != 1)
+		return RetCode::E_INVALID_FILE;
+
+	try {
+		parseCompositionKey(entries.front().first, entries.front().second, BGE, sample);
+	} catch (std::bad_alloc &) {
+		return RetCode::E_NO_MEMORY;
+	} catch (MalformedCompositionKey &) {
+		return RetCode::E_INVALID_FILE;
+	}
+
+	return RetCode::OK;
+}
+
+} // namespace LEMNG
+} // namespace ECHMET
@@ -0,0 +1,21 @@
+#ifndef ECHMET_LEMNG_SYSTEM_DEFINITION_H
+#define ECHMET_LEMNG_SYSTEM_DEFINITION_H
+
+#include <lemng.h>
+#include "mapped_file.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ECHMET {
+namespace LEMNG {
+
+typedef std::pair<const char *, size_t> SystemDefinitionEntry;	/*!< Composition key within a mapped system definition file and its length */
+
+RetCode readSystemDefinitions(const MappedFile &file, std::vector<SystemDefinitionEntry> &entries) noexcept;
+RetCode writeSystemDefinitions(const char *path, const std::vector<std::string> &keys) noexcept;
+
+} // namespace LEMNG
+} // namespace ECHMET
+
+#endif // ECHMET_LEMNG_SYSTEM_DEFINITION_H
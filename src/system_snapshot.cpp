@@ -0,0 +1,133 @@
+#include "lemng_p.h"
+#include "system_cache.h"
+#include "system_definition.h"
+#include <algorithm>
+#include <future>
+#include <new>
+#include <thread>
+
+namespace ECHMET {
+namespace LEMNG {
+
+/*!
+ * Prepares the system described by a composition key and stores it in the cache.
+ */
+static
+RetCode prepareFromKey(const char *key, const size_t size) noexcept
+{
+	SysComp::InConstituentVec *BGE;
+	SysComp::InConstituentVec *sample;
+
+	try {
+		parseCompositionKey(key, size, BGE, sample);
+	} catch (std::bad_alloc &) {
+		return RetCode::E_NO_MEMORY;
+	} catch (MalformedCompositionKey &) {
+		return RetCode::E_INVALID_FILE;
+	}
+
+	CZESystem *czeSystem;
+	const RetCode tRet = makeCZESystem(BGE, sample, czeSystem);
+	if (tRet == RetCode::OK)
+		releaseCZESystem(czeSystem);
+
+	SysComp::releaseInputData(BGE);
+	SysComp::releaseInputData(sample);
+
+	return tRet;
+}
+
+/*
+ * Snapshots are system definition files that hold one composition key per cached system,
+ * the least recently used one first. Only the keys are stored, not the prepared systems.
+ * Loading a snapshot parses the keys and prepares every composition again, it saves
+ * the caller from reading and parsing the input files but not the preparation itself.
+ * Entries may be prepared in parallel so the order of the restored cache is not guaranteed.
+ */
+
+RetCode ECHMET_CC saveCZESystemCacheSnapshot(const char *path) noexcept
+{
+	if (path == nullptr)
+		return RetCode::E_INVALID_ARGUMENT;
+
+	try {
+		/* Store the least recently used entry first so that
+		 * loading the snapshot restores the order of the cache */
+		std::vector<std::string> keys = PreparedSystemCache::instance().keys();
+		std::reverse(keys.begin(), keys.end());
+
+		return writeSystemDefinitions(path, keys);
+	} catch (std::bad_alloc &) {
+		return RetCode::E_NO_MEMORY;
+	}
+}
+
+RetCode ECHMET_CC loadCZESystemCacheSnapshot(const char *path) noexcept
+{
+	if (path == nullptr)
+		return RetCode::E_INVALID_ARGUMENT;
+
+	MappedFile file{};
+	if (!file.open(path))
+		return RetCode::E_IO_ERROR;
+
+	/* Locate all entries before anything gets prepared */
+	std::vector<SystemDefinitionEntry> entries{};
+	const RetCode readRet = readSystemDefinitions(file, entries);
+	if (readRet != RetCode::OK)
+		return readRet;
+
+	if (entries.empty())
+		return RetCode::OK;
+
+	const auto prepareBlock = [&entries](const size_t first, const size_t last) {
+		for (size_t idx = first; idx < last; idx++) {
+			const RetCode tRet = prepareFromKey(entries[idx].first, entries[idx].second);
+			if (tRet != RetCode::OK)
+				return tRet;
+		}
+
+		return RetCode::OK;
+	};
+
+#ifdef ECHMET_LEMNG_PARALLEL_NUM_OPS
+	/* Preparation of each system is independent of the others.
+	 * Order of the restored cache is preserved only approximately. */
+	const size_t NWorkers = [&entries]() -> size_t {
+		const size_t n = std::thread::hardware_concurrency();
+		if (n < 1)
+			return 1;
+		return std::min(n, entries.size());
+	}();
+	const size_t blockSize = (entries.size() + NWorkers - 1) / NWorkers;
+
+	std::vector<std::future<RetCode>> results{};
+	RetCode tRet = RetCode::OK;
+
+	try {
+		results.reserve(NWorkers);
+
+		for (size_t idx = 0; idx < NWorkers; idx++) {
+			const size_t first = std::min(idx * blockSize, entries.size());
+			const size_t last = std::min(first + blockSize, entries.size());
+
+			results.emplace_back(std::async(std::launch::async, prepareBlock, first, last));
+		}
+	} catch (std::bad_alloc &) {
+		tRet = RetCode::E_NO_MEMORY;
+	}
+
+	for (auto &f : results) {
+		const RetCode blockRet = f.get();
+		if (tRet == RetCode::OK)
+			tRet = blockRet;
+	}
+
+	return tRet;
+#else // ECHMET_LEMNG_PARALLEL_NUM_OPS
+	return prepareBlock(0, entries.size());
+#endif // ECHMET_LEMNG_PARALLEL_NUM_OPS
+}
+
+} // namespace LEMNG
+} // namespace ECHMET
@@ -0,0 +1,245 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "barsarkagang_tests.h"
+
+
+using namespace ECHMET;
+using namespace ECHMET::Barsarkagang;
+
+
+SysComp::InCFVec * gen_complexforms_formic_acid()
+{
+	const ComplexDef cDef = {
+		{ /* InComplexForm c-tor begin */
+			-1,
+			/* InLGVec */
+			{
+			}
+		}, /* InComplexForm c-tor end */
+		{ /* InComplexForm c-tor begin */
+			0,
+			/* InLGVec */
+			{
+			}
+		} /* InComplexForm c-tor end */
+	};
+
+	return buildComplexes(cDef);
+}
+
+SysComp::InCFVec * gen_complexforms_li()
+{
+	const ComplexDef cDef = {
+		{ /* InComplexForm c-tor begin */
+			0,
+			/* InLGVec */
+			{
+			}
+		}, /* InComplexForm c-tor end */
+		{ /* InComplexForm c-tor begin */
+			1,
+			/* InLGVec */
+			{
+			}
+		} /* InComplexForm c-tor end */
+	};
+
+	return buildComplexes(cDef);
+}
+
+SysComp::InCFVec * gen_complexforms_x()
+{
+	const ComplexDef cDef = {
+		{ /* InComplexForm c-tor begin */
+			-1,
+			/* InLGVec */
+			{
+				{ /* InLigandGroup c-tor begin */
+					/* InLFVec */
+					{
+						{ /* InLigandForm c-tor begin */
+							"S",
+							0,
+							2,
+							{ -3.778151250383644, -3.477121254719662 },
+							{ 10.0, 5.0 }
+						} /* InLigandForm c-tor end */
+					}
+				} /* InLigandGroup c-tor end */
+			}
+		} /* InComplexForm c-tor end */
+	};
+
+	return buildComplexes(cDef);
+}
+
+int main(int , char ** )
+{
+	SysComp::InConstituent formic_acid{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Formic acid"),
+		-1,
+		0,
+		mkRealVec( { 3.752 } ),
+		mkRealVec( { 56.6, 0.0 } ),
+		gen_complexforms_formic_acid(),
+		0.0
+	};
+
+	SysComp::InConstituent li{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Li"),
+		0,
+		1,
+		mkRealVec( { 13.8 } ),
+		mkRealVec( { 0.0, 40.1 } ),
+		gen_complexforms_li(),
+		0.0
+	};
+
+	SysComp::InConstituent x{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("X"),
+		-1,
+		-1,
+		mkRealVec( {  } ),
+		mkRealVec( { 20.0 } ),
+		gen_complexforms_x(),
+		0.0
+	};
+
+	SysComp::InConstituent s{
+		SysComp::ConstituentType::LIGAND,
+		createFixedString("S"),
+		0,
+		0,
+		mkRealVec( {  } ),
+		mkRealVec( { 0.0 } ),
+		nullptr,
+		0.0
+	};
+
+	const char *path = "formlixs_definition_is.lsd";
+
+	auto icVecBGE = mkInConstVec({ s, li, formic_acid });
+	auto icVecSample = mkInConstVec({ x, formic_acid, li, s });
+
+	/* Saving a definition must not touch the cache of prepared compositions */
+	LEMNG::clearCZESystemCache();
+	failIfError(LEMNG::saveSystemDefinition(path, icVecBGE, icVecSample));
+	{
+		LEMNG::RCZESystemCacheStatistics stats;
+		LEMNG::czeSystemCacheStatistics(stats);
+		failIfFalse(stats.entries == 0 && stats.hits == 0 && stats.misses == 0);
+	}
+
+	SysComp::InConstituentVec *loadedBGE = nullptr;
+	SysComp::InConstituentVec *loadedSample = nullptr;
+	failIfError(LEMNG::loadSystemDefinition(path, loadedBGE, loadedSample));
+
+	/* Loaded constituents come in the canonical order */
+	auto checkLoaded = [](const SysComp::InConstituentVec *original, const SysComp::InConstituentVec *loaded) {
+		failIfFalse(loaded->size() == original->size());
+
+		for (size_t idx = 0; idx < original->size(); idx++) {
+			const SysComp::InConstituent &orig = original->at(idx);
+			bool found = false;
+
+			for (size_t jdx = 0; jdx < loaded->size(); jdx++) {
+				const SysComp::InConstituent &ldd = loaded->at(jdx);
+
+				if (std::strcmp(orig.name->c_str(), ldd.name->c_str()) != 0)
+					continue;
+
+				failIfFalse(SysComp::compareInConstituents(orig, ldd));
+				found = true;
+			}
+
+			failIfFalse(found);
+		}
+	};
+
+	checkLoaded(icVecBGE, loadedBGE);
+	checkLoaded(icVecSample, loadedSample);
+
+	/* Order of constituents does not affect the composition key */
+	{
+		FixedString *originalKey;
+		FixedString *loadedKey;
+		FixedString *otherKey;
+		failIfError(LEMNG::compositionKey(icVecBGE, icVecSample, originalKey));
+		failIfError(LEMNG::compositionKey(loadedBGE, loadedSample, loadedKey));
+		failIfError(LEMNG::compositionKey(icVecSample, icVecSample, otherKey));
+
+		failIfFalse(std::strcmp(originalKey->c_str(), loadedKey->c_str()) == 0);
+		failIfFalse(std::strcmp(originalKey->c_str(), otherKey->c_str()) != 0);
+
+		originalKey->destroy();
+		loadedKey->destroy();
+		otherKey->destroy();
+	}
+
+	/* Loaded compositions must be usable right away */
+	LEMNG::CZESystem *czeSys;
+	failIfError(LEMNG::makeCZESystem(loadedBGE, loadedSample, czeSys));
+	LEMNG::releaseCZESystem(czeSys);
+
+	SysComp::releaseInputData(loadedBGE);
+	SysComp::releaseInputData(loadedSample);
+
+	/* Truncated file */
+	{
+		FILE *fh = std::fopen(path, "rb");
+		failIfFalse(fh != nullptr);
+		std::vector<char> data(4096);
+		const size_t len = std::fread(data.data(), 1, data.size(), fh);
+		std::fclose(fh);
+
+		fh = std::fopen(path, "wb");
+		failIfFalse(fh != nullptr);
+		std::fwrite(data.data(), 1, len - 5, fh);
+		std::fclose(fh);
+
+		if (LEMNG::loadSystemDefinition(path, loadedBGE, loadedSample) != LEMNG::RetCode::E_INVALID_FILE) {
+			std::cerr << "Truncated system definition file was accepted" << std::endl;
+			std::exit(EXIT_FAILURE);
+		}
+	}
+
+	/* Not a system definition file */
+	{
+		FILE *fh = std::fopen(path, "wb");
+		failIfFalse(fh != nullptr);
+		std::fputs("{ \"constituents\": [] }\n", fh);
+		std::fclose(fh);
+
+		if (LEMNG::loadSystemDefinition(path, loadedBGE, loadedSample) != LEMNG::RetCode::E_INVALID_FILE) {
+			std::cerr << "Invalid system definition file was accepted" << std::endl;
+			std::exit(EXIT_FAILURE);
+		}
+	}
+
+	/* Empty file */
+	{
+		FILE *fh = std::fopen(path, "wb");
+		failIfFalse(fh != nullptr);
+		std::fclose(fh);
+
+		if (LEMNG::loadSystemDefinition(path, loadedBGE, loadedSample) != LEMNG::RetCode::E_INVALID_FILE) {
+			std::cerr << "Empty system definition file was not reported as invalid" << std::endl;
+			std::exit(EXIT_FAILURE);
+		}
+	}
+	std::remove(path);
+
+	icVecSample->destroy();
+	icVecBGE->destroy();
+
+	SysComp::releaseInConstituent(formic_acid);
+	SysComp::releaseInConstituent(li);
+	SysComp::releaseInConstituent(x);
+	SysComp::releaseInConstituent(s);
+
+	return EXIT_SUCCESS;
+}
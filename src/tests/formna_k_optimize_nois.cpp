@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "barsarkagang_tests.h"
+
+
+using namespace ECHMET;
+using namespace ECHMET::Barsarkagang;
+
+
+static
+double closestSystemZone(LEMNG::CZESystem *czeSys, LEMNG::InAnalyticalConcentrationsMap *acBGEMap, LEMNG::InAnalyticalConcentrationsMap *acSampleMap,
+			 const NonidealityCorrections corrections)
+{
+	LEMNG::Results r;
+	failIfError(czeSys->evaluateLinear(acBGEMap, acSampleMap, corrections, r));
+
+	double uAnalyte = 0.0;
+	for (size_t idx = 0; idx < r.eigenzones->size(); idx++) {
+		const auto &ez = r.eigenzones->at(idx);
+		if (ez.ztype == LEMNG::EigenzoneType::ANALYTE)
+			uAnalyte = ez.mobility;
+	}
+
+	double closest = HUGE_VAL;
+	for (size_t idx = 0; idx < r.eigenzones->size(); idx++) {
+		const auto &ez = r.eigenzones->at(idx);
+		if (ez.ztype == LEMNG::EigenzoneType::SYSTEM)
+			closest = std::min(closest, std::abs(ez.mobility - uAnalyte));
+	}
+
+	LEMNG::releaseResults(r);
+
+	return closest;
+}
+
+int main(int , char ** )
+{
+	SysComp::InConstituent formic_acid{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Formic acid"),
+		-1,
+		0,
+		mkRealVec( { 3.752 } ),
+		mkRealVec( { 56.6, 0.0 } ),
+		noComplexes(),
+		0.0
+	};
+
+	SysComp::InConstituent na{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Na"),
+		0,
+		1,
+		mkRealVec( { 13.7 } ),
+		mkRealVec( { 0.0, 51.9 } ),
+		noComplexes(),
+		0.0
+	};
+
+	SysComp::InConstituent k{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("K"),
+		0,
+		1,
+		mkRealVec( { 13.0 } ),
+		mkRealVec( { 0.0, 76.2 } ),
+		noComplexes(),
+		0.0
+	};
+
+	const double lowerNa = 2.0;
+	const double upperNa = 16.0;
+
+	LEMNG::CZESystem *czeSys;
+	auto icVecBGE = mkInConstVec({ formic_acid, na });
+	auto icVecSample = mkInConstVec({ formic_acid, na, k });
+
+	failIfError(LEMNG::makeCZESystem(icVecBGE, icVecSample, czeSys));
+
+	LEMNG::InAnalyticalConcentrationsMap *acBGEMap = nullptr;
+	LEMNG::InAnalyticalConcentrationsMap *acSampleMap = nullptr;
+	LEMNG::InAnalyticalConcentrationsMap *lowerMap = nullptr;
+	LEMNG::InAnalyticalConcentrationsMap *upperMap = nullptr;
+	LEMNG::InAnalyticalConcentrationsMap *optimumMap = nullptr;
+	LEMNG::InAnalyticalConcentrationsMap *dummyMap = nullptr;
+
+	failIfError(czeSys->makeAnalyticalConcentrationsMaps(acBGEMap, acSampleMap));
+	failIfError(czeSys->makeAnalyticalConcentrationsMaps(lowerMap, dummyMap));
+	dummyMap->destroy();
+	failIfError(czeSys->makeAnalyticalConcentrationsMaps(upperMap, dummyMap));
+	dummyMap->destroy();
+	failIfError(czeSys->makeAnalyticalConcentrationsMaps(optimumMap, dummyMap));
+	dummyMap->destroy();
+
+	acBGEMap->item("Formic acid") = 17.0;
+	acBGEMap->item("Na") = 8.0;
+	acSampleMap->item("Formic acid") = 5.0;
+	acSampleMap->item("Na") = 5.0;
+	acSampleMap->item("K") = 2.0;
+
+	/* Only Na has valid bounds, formic acid stays fixed */
+	lowerMap->erase("Formic acid");
+	upperMap->erase("Formic acid");
+	lowerMap->item("Na") = lowerNa;
+	upperMap->item("Na") = upperNa;
+
+	auto corrections = defaultNonidealityCorrections();
+
+	const int32_t analyteSeparation = static_cast<int32_t>(LEMNG::OptimizationObjective::OPT_ANALYTE_SEPARATION);
+	const int32_t systemZoneSeparation = static_cast<int32_t>(LEMNG::OptimizationObjective::OPT_SYSTEM_ZONE_SEPARATION);
+	double objectiveValue = 0.0;
+
+	/* A single analyte cannot be separated from other analytes */
+	if (czeSys->optimizeBGE(acBGEMap, acSampleMap, lowerMap, upperMap, analyteSeparation, corrections, 10, optimumMap, objectiveValue) != LEMNG::RetCode::E_INVALID_ARGUMENT) {
+		std::cerr << "Optimization without a pair of analytes was accepted" << std::endl;
+		std::exit(EXIT_FAILURE);
+	}
+
+	const double initial = closestSystemZone(czeSys, acBGEMap, acSampleMap, corrections);
+
+	failIfError(czeSys->optimizeBGE(acBGEMap, acSampleMap, lowerMap, upperMap, systemZoneSeparation, corrections, 20, optimumMap, objectiveValue));
+
+	const double cFormic = (*optimumMap)["Formic acid"];
+	const double cNa = (*optimumMap)["Na"];
+
+	failIfMismatch(cFormic, 17.0);
+	failIfFalse(cNa >= lowerNa && cNa <= upperNa);
+
+	/* Optimum must not be worse than the best point of a dense grid over the bounds */
+	{
+		static const size_t GRID_POINTS = 141;
+
+		double gridBest = -HUGE_VAL;
+		double gridBestNa = lowerNa;
+		for (size_t idx = 0; idx < GRID_POINTS; idx++) {
+			const double c = lowerNa + (upperNa - lowerNa) * idx / (GRID_POINTS - 1);
+
+			acBGEMap->item("Na") = c;
+			const double v = closestSystemZone(czeSys, acBGEMap, acSampleMap, corrections);
+			if (v > gridBest) {
+				gridBest = v;
+				gridBestNa = c;
+			}
+		}
+		acBGEMap->item("Na") = 8.0;
+
+		if (objectiveValue < gridBest * (1.0 - 1.0e-3)) {
+			std::cerr << "Optimization did not converge: objective " << objectiveValue << " at Na " << cNa
+				  << ", grid maximum " << gridBest << " at Na " << gridBestNa << std::endl;
+			std::exit(EXIT_FAILURE);
+		}
+
+		/* Starting point is not the optimum, the search must have moved */
+		if (gridBest > initial * (1.0 + 1.0e-3))
+			failIfFalse(objectiveValue > initial * (1.0 + 1.0e-3));
+	}
+
+	/* Reported objective must match an independent evaluation of the optimum */
+	failIfMismatch(closestSystemZone(czeSys, optimumMap, acSampleMap, corrections), objectiveValue);
+
+	optimumMap->destroy();
+	upperMap->destroy();
+	lowerMap->destroy();
+	acBGEMap->destroy();
+	acSampleMap->destroy();
+	LEMNG::releaseCZESystem(czeSys);
+	icVecSample->destroy();
+	icVecBGE->destroy();
+
+	SysComp::releaseInConstituent(formic_acid);
+	SysComp::releaseInConstituent(na);
+	SysComp::releaseInConstituent(k);
+
+	return EXIT_SUCCESS;
+}
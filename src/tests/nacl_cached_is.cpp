@@ -0,0 +1,219 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include "barsarkagang_tests.h"
+
+
+using namespace ECHMET;
+using namespace ECHMET::Barsarkagang;
+
+
+static
+void checkResults(LEMNG::Results &r)
+{
+	checkBGE(r, 10.949715048, 0.1300633734, 0.0099839393407, 2.302525756);
+
+	checkEigenzone(1, r.eigenzones, 2.0483830654e-07, 1.2590151325e-07, 1.3705486116, 10.85379174, 0.10403577448);
+
+	checkEigenzone(2, r.eigenzones, -172.04923579, 7.8420114551, 1.4182534502, 11.031664059, 0.13302316692);
+
+	LEMNG::releaseResults(r);
+}
+
+static
+void checkCacheStatistics(const size_t entries, const size_t hits, const size_t misses)
+{
+	LEMNG::RCZESystemCacheStatistics stats;
+	LEMNG::czeSystemCacheStatistics(stats);
+
+	if (stats.entries != entries || stats.hits != hits || stats.misses != misses) {
+		std::cerr << "Unexpected cache statistics: entries " << stats.entries << ", hits " << stats.hits << ", misses " << stats.misses
+			  << "; expected " << entries << ", " << hits << ", " << misses << std::endl;
+		std::exit(EXIT_FAILURE);
+	}
+}
+
+static
+std::string readFile(const char *path)
+{
+	std::ifstream ifs{path, std::ios::binary};
+	failIfFalse(ifs.is_open());
+
+	return std::string{std::istreambuf_iterator<char>{ifs}, std::istreambuf_iterator<char>{}};
+}
+
+/*
+ * Returns the composition keys stored in a snapshot. Order of the keys
+ * follows the order of the cache which is not deterministic after a parallel load.
+ */
+static
+std::set<std::string> readSnapshotKeys(const char *path)
+{
+	static const size_t HEADER_SIZE = 8 + 2 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+
+	const std::string data = readFile(path);
+	failIfFalse(data.size() >= HEADER_SIZE);
+
+	uint64_t numEntries;
+	std::memcpy(&numEntries, data.data() + 8 + 2 * sizeof(uint32_t), sizeof(uint64_t));
+
+	std::set<std::string> keys;
+	size_t pos = HEADER_SIZE;
+	for (uint64_t idx = 0; idx < numEntries; idx++) {
+		uint64_t size;
+
+		failIfFalse(data.size() - pos >= sizeof(uint64_t));
+		std::memcpy(&size, data.data() + pos, sizeof(uint64_t));
+		pos += sizeof(uint64_t);
+
+		failIfFalse(data.size() - pos >= size);
+		keys.emplace(data.substr(pos, size));
+		pos += size;
+	}
+	failIfFalse(pos == data.size());
+
+	return keys;
+}
+
+int main(int , char ** )
+{
+	SysComp::InConstituent chloride{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Chloride"),
+		-1,
+		0,
+		mkRealVec( { -2.0 } ),
+		mkRealVec( { 79.1, 0.0 } ),
+		noComplexes(),
+		0.0
+	};
+
+	SysComp::InConstituent sodium{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Sodium"),
+		0,
+		1,
+		mkRealVec( { 13.7 } ),
+		mkRealVec( { 0.0, 51.9 } ),
+		noComplexes(),
+		0.0
+	};
+
+	CMapping cBGE = {
+		{ "Chloride", 9.0 },
+		{ "Sodium", 10.0 }
+	};
+
+	CMapping cSample = {
+		{ "Chloride", 7.0 },
+		{ "Sodium", 8.0 }
+	};
+
+	LEMNG::clearCZESystemCache();
+
+	/* Prepare the system from scratch */
+	auto r = calculate({ chloride, sodium }, { chloride, sodium }, cBGE, cSample, true, true, false, false);
+	checkResults(r);
+	checkCacheStatistics(1, 0, 1);
+
+	/* Same composition must be picked up from the cache */
+	r = calculate({ chloride, sodium }, { chloride, sodium }, cBGE, cSample, true, true, false, false);
+	checkResults(r);
+	checkCacheStatistics(1, 1, 1);
+
+	/* Order of constituents must not matter */
+	r = calculate({ sodium, chloride }, { sodium, chloride }, cBGE, cSample, true, true, false, false);
+	checkResults(r);
+	checkCacheStatistics(1, 2, 1);
+
+	/* Snapshot of the cache must restore the same entries */
+	{
+		const char *path = "nacl_cached_is.lss";
+		const char *pathRestored = "nacl_cached_is_restored.lss";
+
+		/* Add another composition so that the snapshot holds more than one entry */
+		{
+			SysComp::InConstituent potassium{
+				SysComp::ConstituentType::NUCLEUS,
+				createFixedString("Potassium"),
+				0,
+				1,
+				mkRealVec( { 13.7 } ),
+				mkRealVec( { 0.0, 76.2 } ),
+				noComplexes(),
+				0.0
+			};
+
+			auto icVecBGE = mkInConstVec({ chloride, sodium });
+			auto icVecSample = mkInConstVec({ chloride, sodium, potassium });
+			LEMNG::CZESystem *czeSys;
+
+			failIfError(LEMNG::makeCZESystem(icVecBGE, icVecSample, czeSys));
+			LEMNG::releaseCZESystem(czeSys);
+			icVecBGE->destroy();
+			icVecSample->destroy();
+			SysComp::releaseInConstituent(potassium);
+		}
+		checkCacheStatistics(2, 2, 2);
+
+		failIfError(LEMNG::saveCZESystemCacheSnapshot(path));
+		LEMNG::clearCZESystemCache();
+		failIfError(LEMNG::loadCZESystemCacheSnapshot(path));
+		checkCacheStatistics(2, 0, 2);
+		failIfError(LEMNG::saveCZESystemCacheSnapshot(pathRestored));
+
+		const std::set<std::string> keys = readSnapshotKeys(path);
+		failIfFalse(keys.size() == 2);
+		failIfFalse(keys == readSnapshotKeys(pathRestored));
+
+		/* Snapshot holds more than one pair of compositions */
+		{
+			SysComp::InConstituentVec *loadedBGE;
+			SysComp::InConstituentVec *loadedSample;
+
+			if (LEMNG::loadSystemDefinition(path, loadedBGE, loadedSample) != LEMNG::RetCode::E_INVALID_FILE) {
+				std::cerr << "Snapshot was accepted as a definition of a single system" << std::endl;
+				std::exit(EXIT_FAILURE);
+			}
+		}
+		std::remove(path);
+		std::remove(pathRestored);
+
+		r = calculate({ chloride, sodium }, { chloride, sodium }, cBGE, cSample, true, true, false, false);
+		checkResults(r);
+		checkCacheStatistics(2, 1, 2);
+
+		/* Definition of a single system is a snapshot with one entry */
+		{
+			const char *pathDefinition = "nacl_cached_is.lsd";
+			auto icVecBGE = mkInConstVec({ chloride, sodium });
+			auto icVecSample = mkInConstVec({ chloride, sodium });
+
+			failIfError(LEMNG::saveSystemDefinition(pathDefinition, icVecBGE, icVecSample));
+			LEMNG::clearCZESystemCache();
+			failIfError(LEMNG::loadCZESystemCacheSnapshot(pathDefinition));
+			checkCacheStatistics(1, 0, 1);
+			failIfError(LEMNG::saveCZESystemCacheSnapshot(path));
+			failIfFalse(readSnapshotKeys(path) == readSnapshotKeys(pathDefinition));
+
+			std::remove(path);
+			std::remove(pathDefinition);
+			icVecBGE->destroy();
+			icVecSample->destroy();
+		}
+	}
+
+	/* Disabled cache */
+	LEMNG::setCZESystemCacheCapacity(0);
+	r = calculate({ chloride, sodium }, { chloride, sodium }, cBGE, cSample, true, true, false, false);
+	checkResults(r);
+
+	SysComp::releaseInConstituent(chloride);
+	SysComp::releaseInConstituent(sodium);
+
+	return EXIT_SUCCESS;
+}
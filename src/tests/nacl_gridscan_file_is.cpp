@@ -0,0 +1,151 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "barsarkagang_tests.h"
+
+
+using namespace ECHMET;
+using namespace ECHMET::Barsarkagang;
+
+
+int main(int , char ** )
+{
+	SysComp::InConstituent chloride{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Chloride"),
+		-1,
+		0,
+		mkRealVec( { -2.0 } ),
+		mkRealVec( { 79.1, 0.0 } ),
+		noComplexes(),
+		0.0
+	};
+
+	SysComp::InConstituent sodium{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Sodium"),
+		0,
+		1,
+		mkRealVec( { 13.7 } ),
+		mkRealVec( { 0.0, 51.9 } ),
+		noComplexes(),
+		0.0
+	};
+
+	const char *path = "nacl_gridscan_file_is.lgs";
+	const std::vector<double> chloridePath = { 8.0, 9.0, 10.0 };
+	const std::vector<double> sodiumPath = { 10.0, 12.0 };
+
+	LEMNG::CZESystem *czeSys;
+	auto icVecBGE = mkInConstVec({ chloride, sodium });
+	auto icVecSample = mkInConstVec({ chloride, sodium });
+
+	failIfError(LEMNG::makeCZESystem(icVecBGE, icVecSample, czeSys));
+
+	LEMNG::InAnalyticalConcentrationsMap *acBGEMap = nullptr;
+	LEMNG::InAnalyticalConcentrationsMap *acSampleMap = nullptr;
+
+	failIfError(czeSys->makeAnalyticalConcentrationsMaps(acBGEMap, acSampleMap));
+
+	acBGEMap->item("Chloride") = 9.0;
+	acBGEMap->item("Sodium") = 10.0;
+	acSampleMap->item("Chloride") = 7.0;
+	acSampleMap->item("Sodium") = 10.0;
+
+	auto corrections = defaultNonidealityCorrections();
+	nonidealityCorrectionSet(corrections, NonidealityCorrectionsItems::CORR_DEBYE_HUCKEL);
+	nonidealityCorrectionSet(corrections, NonidealityCorrectionsItems::CORR_ONSAGER_FUOSS);
+
+	RealVec *chlorideValues = mkRealVec(chloridePath);
+	RealVec *sodiumValues = mkRealVec(sodiumPath);
+	const LEMNG::GridScanAxis axes[] = {
+		{ "Chloride", static_cast<int32_t>(LEMNG::SweepTarget::SWEEP_BGE), chlorideValues },
+		{ "Sodium", static_cast<int32_t>(LEMNG::SweepTarget::SWEEP_BOTH), sodiumValues }
+	};
+
+	LEMNG::RGridScanBuffer *buffer = nullptr;
+	failIfError(czeSys->makeGridScanBuffer(axes, 2, buffer));
+	failIfError(czeSys->gridScan(acBGEMap, acSampleMap, axes, 2, corrections, true, buffer));
+
+	failIfError(czeSys->gridScanToFile(acBGEMap, acSampleMap, axes, 2, corrections, true, path));
+
+	const LEMNG::RGridScanFile *file = nullptr;
+	failIfError(LEMNG::openGridScanFile(path, file));
+
+	/* Metadata */
+	failIfFalse(file->header->numAxes == 2);
+	failIfFalse(file->header->numConstituents == 2);
+	failIfFalse(file->header->hasDispersion != 0);
+	failIfFalse(file->header->corrections == corrections);
+
+	failIfFalse(std::strcmp(file->names + file->axes[0].nameOffset, "Chloride") == 0);
+	failIfFalse(std::strcmp(file->names + file->axes[1].nameOffset, "Sodium") == 0);
+	failIfFalse(file->axes[0].numValues == chloridePath.size());
+	failIfFalse(file->axes[1].target == static_cast<int32_t>(LEMNG::SweepTarget::SWEEP_BOTH));
+
+	const double *sodiumStored = reinterpret_cast<const double *>(reinterpret_cast<const char *>(file->header) + file->axes[1].valuesOffset);
+	for (size_t idx = 0; idx < sodiumPath.size(); idx++)
+		failIfMismatch(sodiumStored[idx], sodiumPath[idx]);
+
+	for (uint32_t idx = 0; idx < file->header->numConstituents; idx++) {
+		const auto &ctuent = file->constituents[idx];
+		const char *name = file->names + ctuent.nameOffset;
+
+		if (std::strcmp(name, "Chloride") == 0) {
+			failIfMismatch(ctuent.cBGE, 9.0);
+			failIfMismatch(ctuent.cSample, 7.0);
+		} else if (std::strcmp(name, "Sodium") == 0) {
+			failIfMismatch(ctuent.cBGE, 10.0);
+			failIfMismatch(ctuent.cSample, 10.0);
+		} else
+			failIfFalse(false);
+	}
+
+	/* Columns must match the scan into memory */
+	failIfFalse(file->results.numPoints == buffer->numPoints);
+	failIfFalse(file->results.zonesPerPoint == buffer->zonesPerPoint);
+	for (size_t pdx = 0; pdx < buffer->numPoints; pdx++) {
+		failIfFalse(file->results.status[pdx] == buffer->status[pdx]);
+		failIfError(static_cast<LEMNG::RetCode>(file->results.status[pdx]));
+
+		for (size_t zdx = 0; zdx < buffer->zonesPerPoint; zdx++) {
+			const size_t idx = pdx * buffer->zonesPerPoint + zdx;
+
+			failIfMismatch(file->results.mobilities[idx], buffer->mobilities[idx]);
+			failIfMismatch(file->results.uEMDs[idx], buffer->uEMDs[idx]);
+			failIfMismatch(file->results.a2ts[idx], buffer->a2ts[idx]);
+			failIfFalse(file->results.ztypes[idx] == buffer->ztypes[idx]);
+		}
+	}
+
+	LEMNG::releaseGridScanFile(file);
+	std::remove(path);
+
+	/* Not a grid scan file */
+	FILE *bogus = std::fopen(path, "wb");
+	failIfFalse(bogus != nullptr);
+	std::fputs("chloride,sodium\n", bogus);
+	std::fclose(bogus);
+
+	if (LEMNG::openGridScanFile(path, file) != LEMNG::RetCode::E_INVALID_FILE) {
+		std::cerr << "Invalid grid scan file was accepted" << std::endl;
+		std::exit(EXIT_FAILURE);
+	}
+	std::remove(path);
+
+	LEMNG::releaseGridScanBuffer(buffer);
+	sodiumValues->destroy();
+	chlorideValues->destroy();
+
+	acBGEMap->destroy();
+	acSampleMap->destroy();
+	LEMNG::releaseCZESystem(czeSys);
+	icVecSample->destroy();
+	icVecBGE->destroy();
+
+	SysComp::releaseInConstituent(chloride);
+	SysComp::releaseInConstituent(sodium);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+#include <cstdlib>
+#include "barsarkagang_tests.h"
+
+
+using namespace ECHMET;
+using namespace ECHMET::Barsarkagang;
+
+
+int main(int , char ** )
+{
+	SysComp::InConstituent chloride{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Chloride"),
+		-1,
+		0,
+		mkRealVec( { -2.0 } ),
+		mkRealVec( { 79.1, 0.0 } ),
+		noComplexes(),
+		0.0
+	};
+
+	SysComp::InConstituent sodium{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Sodium"),
+		0,
+		1,
+		mkRealVec( { 13.7 } ),
+		mkRealVec( { 0.0, 51.9 } ),
+		noComplexes(),
+		0.0
+	};
+
+	const std::vector<double> chloridePath = { 8.0, 9.0, 10.0 };
+	const std::vector<double> sodiumPath = { 10.0, 12.0 };
+
+	LEMNG::CZESystem *czeSys;
+	auto icVecBGE = mkInConstVec({ chloride, sodium });
+	auto icVecSample = mkInConstVec({ chloride, sodium });
+
+	failIfError(LEMNG::makeCZESystem(icVecBGE, icVecSample, czeSys));
+
+	LEMNG::InAnalyticalConcentrationsMap *acBGEMap = nullptr;
+	LEMNG::InAnalyticalConcentrationsMap *acSampleMap = nullptr;
+
+	failIfError(czeSys->makeAnalyticalConcentrationsMaps(acBGEMap, acSampleMap));
+
+	acBGEMap->item("Chloride") = 9.0;
+	acBGEMap->item("Sodium") = 10.0;
+	acSampleMap->item("Chloride") = 7.0;
+	acSampleMap->item("Sodium") = 10.0;
+
+	auto corrections = defaultNonidealityCorrections();
+	nonidealityCorrectionSet(corrections, NonidealityCorrectionsItems::CORR_DEBYE_HUCKEL);
+	nonidealityCorrectionSet(corrections, NonidealityCorrectionsItems::CORR_ONSAGER_FUOSS);
+
+	RealVec *chlorideValues = mkRealVec(chloridePath);
+	RealVec *sodiumValues = mkRealVec(sodiumPath);
+	const LEMNG::GridScanAxis axes[] = {
+		{ "Chloride", static_cast<int32_t>(LEMNG::SweepTarget::SWEEP_BGE), chlorideValues },
+		{ "Sodium", static_cast<int32_t>(LEMNG::SweepTarget::SWEEP_BOTH), sodiumValues }
+	};
+	LEMNG::RGridScanBuffer *buffer = nullptr;
+
+	failIfError(czeSys->makeGridScanBuffer(axes, 2, buffer));
+	failIfFalse(buffer->numPoints == chloridePath.size() * sodiumPath.size());
+	failIfFalse(buffer->zonesPerPoint == 2);
+
+	/* Leave the system with a different BGE, the scan must not follow it */
+	{
+		LEMNG::Results r;
+
+		acBGEMap->item("Sodium") = 30.0;
+		acSampleMap->item("Sodium") = 30.0;
+		failIfError(czeSys->evaluate(acBGEMap, acSampleMap, corrections, r));
+		LEMNG::releaseResults(r);
+		acBGEMap->item("Sodium") = 10.0;
+		acSampleMap->item("Sodium") = 10.0;
+	}
+
+	failIfError(czeSys->gridScan(acBGEMap, acSampleMap, axes, 2, corrections, true, buffer));
+
+	/* Scan by a system with no history must give exactly the same order */
+	{
+		LEMNG::CZESystem *czeSysFresh;
+		LEMNG::RGridScanBuffer *bufferFresh = nullptr;
+
+		failIfError(LEMNG::makeCZESystem(icVecBGE, icVecSample, czeSysFresh));
+		failIfError(czeSysFresh->makeGridScanBuffer(axes, 2, bufferFresh));
+		failIfError(czeSysFresh->gridScan(acBGEMap, acSampleMap, axes, 2, corrections, false, bufferFresh));
+
+		for (size_t idx = 0; idx < buffer->numPoints * buffer->zonesPerPoint; idx++) {
+			failIfFalse(buffer->ztypes[idx] == bufferFresh->ztypes[idx]);
+			failIfMismatch(buffer->mobilities[idx], bufferFresh->mobilities[idx]);
+		}
+
+		LEMNG::releaseGridScanBuffer(bufferFresh);
+		LEMNG::releaseCZESystem(czeSysFresh);
+	}
+
+	/* Zone types must stay at the same index in all points */
+	for (size_t pointIdx = 1; pointIdx < buffer->numPoints; pointIdx++) {
+		for (size_t idx = 0; idx < buffer->zonesPerPoint; idx++)
+			failIfFalse(buffer->ztypes[pointIdx * buffer->zonesPerPoint + idx] == buffer->ztypes[idx]);
+	}
+
+	/* Each point must match an independent evaluation of the same composition */
+	for (size_t cdx = 0; cdx < chloridePath.size(); cdx++) {
+		for (size_t sdx = 0; sdx < sodiumPath.size(); sdx++) {
+			const size_t pointIdx = cdx * sodiumPath.size() + sdx;
+
+			failIfError(static_cast<LEMNG::RetCode>(buffer->status[pointIdx]));
+
+			auto fresh = calculate({ chloride, sodium }, { chloride, sodium },
+					       { { "Chloride", chloridePath[cdx] }, { "Sodium", sodiumPath[sdx] } },
+					       { { "Chloride", 7.0 }, { "Sodium", sodiumPath[sdx] } },
+					       true, true, false, false);
+
+			/* All points follow the first one which is ordered as the solver returns it.
+			 * Zones of NaCl do not swap on the grid so all points match the order of a fresh evaluation. */
+			failIfFalse(fresh.eigenzones->size() == buffer->zonesPerPoint);
+			for (size_t idx = 0; idx < buffer->zonesPerPoint; idx++) {
+				const auto &ez = fresh.eigenzones->at(idx);
+				const size_t zoneIdx = pointIdx * buffer->zonesPerPoint + idx;
+
+				failIfMismatch(buffer->mobilities[zoneIdx], ez.mobility);
+				failIfMismatch(buffer->uEMDs[zoneIdx], ez.uEMD);
+				failIfMismatch(buffer->a2ts[zoneIdx], ez.a2t);
+				failIfFalse(buffer->ztypes[zoneIdx] == static_cast<int32_t>(ez.ztype));
+			}
+
+			LEMNG::releaseResults(fresh);
+		}
+	}
+
+	LEMNG::releaseGridScanBuffer(buffer);
+	sodiumValues->destroy();
+	chlorideValues->destroy();
+
+	acBGEMap->destroy();
+	acSampleMap->destroy();
+	LEMNG::releaseCZESystem(czeSys);
+	icVecSample->destroy();
+	icVecBGE->destroy();
+
+	SysComp::releaseInConstituent(chloride);
+	SysComp::releaseInConstituent(sodium);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+#include <cstdlib>
+#include "barsarkagang_tests.h"
+
+
+using namespace ECHMET;
+using namespace ECHMET::Barsarkagang;
+
+
+static
+void compareResults(const LEMNG::Results &reused, const LEMNG::Results &fresh)
+{
+	checkBGE(reused, fresh.BGEProperties.pH, fresh.BGEProperties.conductivity, fresh.BGEProperties.ionicStrength, fresh.BGEProperties.bufferCapacity);
+
+	failIfFalse(reused.eigenzones->size() == fresh.eigenzones->size());
+	for (size_t idx = 0; idx < fresh.eigenzones->size(); idx++) {
+		const auto &ez = fresh.eigenzones->at(idx);
+
+		checkEigenzone(idx + 1, reused.eigenzones, ez.mobility, ez.uEMD, ez.a2t, ez.solutionProperties.pH, ez.solutionProperties.conductivity);
+	}
+}
+
+static
+LEMNG::Results evaluate(LEMNG::CZESystem *czeSys, const CMapping &cBGE, const CMapping &cSample)
+{
+	LEMNG::InAnalyticalConcentrationsMap *acBGEMap = nullptr;
+	LEMNG::InAnalyticalConcentrationsMap *acSampleMap = nullptr;
+
+	failIfError(czeSys->makeAnalyticalConcentrationsMaps(acBGEMap, acSampleMap));
+
+	for (auto &&item : cBGE)
+		acBGEMap->item(item.first.c_str()) = item.second;
+
+	for (auto &&item : cSample)
+		acSampleMap->item(item.first.c_str()) = item.second;
+
+	auto corrections = defaultNonidealityCorrections();
+	nonidealityCorrectionSet(corrections, NonidealityCorrectionsItems::CORR_DEBYE_HUCKEL);
+	nonidealityCorrectionSet(corrections, NonidealityCorrectionsItems::CORR_ONSAGER_FUOSS);
+
+	LEMNG::Results results;
+	failIfError(czeSys->evaluate(acBGEMap, acSampleMap, corrections, results));
+
+	acBGEMap->destroy();
+	acSampleMap->destroy();
+
+	return results;
+}
+
+int main(int , char ** )
+{
+	SysComp::InConstituent chloride{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Chloride"),
+		-1,
+		0,
+		mkRealVec( { -2.0 } ),
+		mkRealVec( { 79.1, 0.0 } ),
+		noComplexes(),
+		0.0
+	};
+
+	SysComp::InConstituent sodium{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Sodium"),
+		0,
+		1,
+		mkRealVec( { 13.7 } ),
+		mkRealVec( { 0.0, 51.9 } ),
+		noComplexes(),
+		0.0
+	};
+
+	const std::vector<std::pair<CMapping, CMapping>> concentrations = {
+		{ { { "Chloride", 9.0 }, { "Sodium", 10.0 } }, { { "Chloride", 7.0 }, { "Sodium", 8.0 } } },
+		/* Only the sample changes, BGE-dependent part of the model is reused */
+		{ { { "Chloride", 9.0 }, { "Sodium", 10.0 } }, { { "Chloride", 3.0 }, { "Sodium", 5.0 } } },
+		/* BGE changes, everything must be recalculated */
+		{ { { "Chloride", 12.0 }, { "Sodium", 15.0 } }, { { "Chloride", 3.0 }, { "Sodium", 5.0 } } },
+		/* Back to the original system */
+		{ { { "Chloride", 9.0 }, { "Sodium", 10.0 } }, { { "Chloride", 7.0 }, { "Sodium", 8.0 } } }
+	};
+
+	LEMNG::CZESystem *czeSys;
+	auto icVecBGE = mkInConstVec({ chloride, sodium });
+	auto icVecSample = mkInConstVec({ chloride, sodium });
+
+	failIfError(LEMNG::makeCZESystem(icVecBGE, icVecSample, czeSys));
+
+	for (const auto &item : concentrations) {
+		auto fresh = calculate({ chloride, sodium }, { chloride, sodium }, item.first, item.second, true, true, false, false);
+		auto reused = evaluate(czeSys, item.first, item.second);
+
+		compareResults(reused, fresh);
+
+		LEMNG::releaseResults(fresh);
+		LEMNG::releaseResults(reused);
+	}
+
+	LEMNG::releaseCZESystem(czeSys);
+	icVecSample->destroy();
+	icVecBGE->destroy();
+
+	SysComp::releaseInConstituent(chloride);
+	SysComp::releaseInConstituent(sodium);
+
+	return EXIT_SUCCESS;
+}
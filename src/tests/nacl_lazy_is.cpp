@@ -0,0 +1,121 @@
+#include <cstdlib>
+#include "barsarkagang_tests.h"
+
+
+using namespace ECHMET;
+using namespace ECHMET::Barsarkagang;
+
+
+static
+void failIfNotMobility(const LEMNG::REigenzoneVec *ezs, const double u)
+{
+	for (size_t idx = 0; idx < ezs->size(); idx++) {
+		if (numberMatches(ezs->at(idx).mobility, u))
+			return;
+	}
+
+	std::cerr << "Eigenzone with mobility " << u << " not found" << std::endl;
+	std::exit(EXIT_FAILURE);
+}
+
+static
+void failIfNotExpected(const LEMNG::RetCode tRet, const LEMNG::RetCode expected)
+{
+	if (tRet != expected) {
+		std::cerr << "Unexpected return code " << LEMNG::LEMNGerrorToString(tRet) << std::endl;
+		std::exit(EXIT_FAILURE);
+	}
+}
+
+int main(int , char ** )
+{
+	SysComp::InConstituent chloride{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Chloride"),
+		-1,
+		0,
+		mkRealVec( { -2.0 } ),
+		mkRealVec( { 79.1, 0.0 } ),
+		noComplexes(),
+		0.0
+	};
+
+	SysComp::InConstituent sodium{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Sodium"),
+		0,
+		1,
+		mkRealVec( { 13.7 } ),
+		mkRealVec( { 0.0, 51.9 } ),
+		noComplexes(),
+		0.0
+	};
+
+	LEMNG::CZESystem *czeSys;
+	auto icVecBGE = mkInConstVec({ chloride, sodium });
+	auto icVecSample = mkInConstVec({ chloride, sodium });
+
+	failIfError(LEMNG::makeCZESystem(icVecBGE, icVecSample, czeSys));
+
+	LEMNG::InAnalyticalConcentrationsMap *acBGEMap = nullptr;
+	LEMNG::InAnalyticalConcentrationsMap *acSampleMap = nullptr;
+
+	failIfError(czeSys->makeAnalyticalConcentrationsMaps(acBGEMap, acSampleMap));
+
+	acBGEMap->item("Chloride") = 9.0;
+	acBGEMap->item("Sodium") = 10.0;
+	acSampleMap->item("Chloride") = 7.0;
+	acSampleMap->item("Sodium") = 8.0;
+
+	auto corrections = defaultNonidealityCorrections();
+	nonidealityCorrectionSet(corrections, NonidealityCorrectionsItems::CORR_DEBYE_HUCKEL);
+	nonidealityCorrectionSet(corrections, NonidealityCorrectionsItems::CORR_ONSAGER_FUOSS);
+
+	/* Request only the eigenmobilities up front */
+	LEMNG::LazyResults *lazy;
+	failIfError(czeSys->evaluateLazy(acBGEMap, acSampleMap, corrections, static_cast<int32_t>(LEMNG::EvaluationParts::EVAL_EIGENMOBILITIES), lazy));
+
+	const LEMNG::REigenzoneVec *ezs;
+	failIfError(lazy->eigenmobilities(ezs));
+	failIfNotMobility(ezs, 2.0483830654e-07);
+	failIfNotMobility(ezs, -172.04923579);
+
+	/* Remaining parts are calculated on access */
+	const LEMNG::RSolutionProperties *BGEProps;
+	failIfError(lazy->BGEProperties(BGEProps));
+	checkSolProps(*BGEProps, 10.949715048, 0.1300633734, 0.0099839393407);
+
+	failIfError(lazy->zoneProperties(ezs));
+	failIfError(lazy->dispersion(ezs));
+
+	const LEMNG::Results *r;
+	failIfError(lazy->results(r));
+	checkEigenzone(1, r->eigenzones, 2.0483830654e-07, 1.2590151325e-07, 1.3705486116, 10.85379174, 0.10403577448);
+	checkEigenzone(2, r->eigenzones, -172.04923579, 7.8420114551, 1.4182534502, 11.031664059, 0.13302316692);
+
+	lazy->destroy();
+
+	/* Parts that were not calculated expire with the next evaluation */
+	failIfError(czeSys->evaluateLazy(acBGEMap, acSampleMap, corrections, static_cast<int32_t>(LEMNG::EvaluationParts::EVAL_BGE), lazy));
+
+	LEMNG::Results full;
+	failIfError(czeSys->evaluate(acBGEMap, acSampleMap, corrections, full));
+	LEMNG::releaseResults(full);
+
+	failIfError(lazy->BGEProperties(BGEProps));
+	checkSolProps(*BGEProps, 10.949715048, 0.1300633734, 0.0099839393407);
+	failIfNotExpected(lazy->dispersion(ezs), LEMNG::RetCode::E_RESULTS_EXPIRED);
+
+	lazy->destroy();
+
+	acBGEMap->destroy();
+	acSampleMap->destroy();
+	LEMNG::releaseCZESystem(czeSys);
+	icVecSample->destroy();
+	icVecBGE->destroy();
+
+	SysComp::releaseInConstituent(chloride);
+	SysComp::releaseInConstituent(sodium);
+
+	return EXIT_SUCCESS;
+}
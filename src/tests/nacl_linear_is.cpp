@@ -0,0 +1,101 @@
+#include <cmath>
+#include <cstdlib>
+#include "barsarkagang_tests.h"
+
+
+using namespace ECHMET;
+using namespace ECHMET::Barsarkagang;
+
+
+static
+void checkLinearEigenzone(int id, const LEMNG::REigenzoneVec *ezs, const double u, const double pH, const double conductivity)
+{
+	for (size_t idx = 0; idx < ezs->size(); idx++) {
+		auto &ez = ezs->at(idx);
+
+		if (numberMatches(ez.mobility, u)) {
+			failIfFalse(std::isnan(ez.a2t));
+			failIfFalse(std::isnan(ez.uEMD));
+			failIfMismatch(ez.solutionProperties.pH, pH);
+			failIfMismatch(ez.solutionProperties.conductivity, conductivity);
+
+			return;
+		}
+	}
+
+	std::cerr << "Eigenzone " << id << " not found" << std::endl;
+
+	std::exit(EXIT_FAILURE);
+}
+
+int main(int , char ** )
+{
+	SysComp::InConstituent chloride{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Chloride"),
+		-1,
+		0,
+		mkRealVec( { -2.0 } ),
+		mkRealVec( { 79.1, 0.0 } ),
+		noComplexes(),
+		0.0
+	};
+
+	SysComp::InConstituent sodium{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Sodium"),
+		0,
+		1,
+		mkRealVec( { 13.7 } ),
+		mkRealVec( { 0.0, 51.9 } ),
+		noComplexes(),
+		0.0
+	};
+
+	LEMNG::CZESystem *czeSys;
+	auto icVecBGE = mkInConstVec({ chloride, sodium });
+	auto icVecSample = mkInConstVec({ chloride, sodium });
+
+	failIfError(LEMNG::makeCZESystem(icVecBGE, icVecSample, czeSys));
+
+	LEMNG::InAnalyticalConcentrationsMap *acBGEMap = nullptr;
+	LEMNG::InAnalyticalConcentrationsMap *acSampleMap = nullptr;
+
+	failIfError(czeSys->makeAnalyticalConcentrationsMaps(acBGEMap, acSampleMap));
+
+	acBGEMap->item("Chloride") = 9.0;
+	acBGEMap->item("Sodium") = 10.0;
+	acSampleMap->item("Chloride") = 7.0;
+	acSampleMap->item("Sodium") = 8.0;
+
+	auto corrections = defaultNonidealityCorrections();
+	nonidealityCorrectionSet(corrections, NonidealityCorrectionsItems::CORR_DEBYE_HUCKEL);
+	nonidealityCorrectionSet(corrections, NonidealityCorrectionsItems::CORR_ONSAGER_FUOSS);
+
+	LEMNG::Results r;
+	failIfError(czeSys->evaluateLinear(acBGEMap, acSampleMap, corrections, r));
+
+	checkBGE(r, 10.949715048, 0.1300633734, 0.0099839393407, 2.302525756);
+	checkLinearEigenzone(1, r.eigenzones, 2.0483830654e-07, 10.85379174, 0.10403577448);
+	checkLinearEigenzone(2, r.eigenzones, -172.04923579, 11.031664059, 0.13302316692);
+
+	/* Electrophoregram cannot be plotted without dispersion parameters */
+	LEMNG::EFGPairVec *efg = nullptr;
+	if (LEMNG::plotElectrophoregram(efg, r, 20000.0, 0.5, 0.4, 0.0, 0.001, LEMNG::EFGResponseType::RESP_CONDUCTIVITY) != LEMNG::RetCode::E_INVALID_ARGUMENT) {
+		std::cerr << "Electrophoregram plotted without dispersion parameters" << std::endl;
+		std::exit(EXIT_FAILURE);
+	}
+
+	LEMNG::releaseResults(r);
+
+	acBGEMap->destroy();
+	acSampleMap->destroy();
+	LEMNG::releaseCZESystem(czeSys);
+	icVecSample->destroy();
+	icVecBGE->destroy();
+
+	SysComp::releaseInConstituent(chloride);
+	SysComp::releaseInConstituent(sodium);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+#include <cmath>
+#include <cstdlib>
+#include "barsarkagang_tests.h"
+
+
+using namespace ECHMET;
+using namespace ECHMET::Barsarkagang;
+
+
+static
+std::vector<double> eigenmobilities(LEMNG::CZESystem *czeSys, LEMNG::InAnalyticalConcentrationsMap *acBGEMap, LEMNG::InAnalyticalConcentrationsMap *acSampleMap,
+				    const double cSodium, const NonidealityCorrections corrections)
+{
+	acBGEMap->item("Sodium") = cSodium;
+
+	LEMNG::Results r;
+	failIfError(czeSys->evaluateLinear(acBGEMap, acSampleMap, corrections, r));
+
+	std::vector<double> mobilities{};
+	for (size_t idx = 0; idx < r.eigenzones->size(); idx++)
+		mobilities.emplace_back(r.eigenzones->at(idx).mobility);
+
+	LEMNG::releaseResults(r);
+
+	return mobilities;
+}
+
+int main(int , char ** )
+{
+	SysComp::InConstituent chloride{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Chloride"),
+		-1,
+		0,
+		mkRealVec( { -2.0 } ),
+		mkRealVec( { 79.1, 0.0 } ),
+		noComplexes(),
+		0.0
+	};
+
+	SysComp::InConstituent sodium{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Sodium"),
+		0,
+		1,
+		mkRealVec( { 13.7 } ),
+		mkRealVec( { 0.0, 51.9 } ),
+		noComplexes(),
+		0.0
+	};
+
+	const double cSodium = 10.0;
+	const double h = 1.0e-3;
+
+	LEMNG::CZESystem *czeSys;
+	auto icVecBGE = mkInConstVec({ chloride, sodium });
+	auto icVecSample = mkInConstVec({ chloride, sodium });
+
+	failIfError(LEMNG::makeCZESystem(icVecBGE, icVecSample, czeSys));
+
+	LEMNG::InAnalyticalConcentrationsMap *acBGEMap = nullptr;
+	LEMNG::InAnalyticalConcentrationsMap *acSampleMap = nullptr;
+
+	failIfError(czeSys->makeAnalyticalConcentrationsMaps(acBGEMap, acSampleMap));
+
+	acBGEMap->item("Chloride") = 9.0;
+	acBGEMap->item("Sodium") = cSodium;
+	acSampleMap->item("Chloride") = 7.0;
+	acSampleMap->item("Sodium") = 8.0;
+
+	auto corrections = defaultNonidealityCorrections();
+	/* Onsager-Fuoss correction is left out, the dependence of ionic mobilities on the ionic strength is not part of the derivatives */
+	nonidealityCorrectionSet(corrections, NonidealityCorrectionsItems::CORR_DEBYE_HUCKEL);
+
+	LEMNG::LazyResults *lazy = nullptr;
+	const LEMNG::REigenzoneVec *ezs = nullptr;
+	failIfError(czeSys->evaluateLazy(acBGEMap, acSampleMap, corrections, static_cast<int32_t>(LEMNG::EvaluationParts::EVAL_SENSITIVITIES), lazy));
+	failIfError(lazy->sensitivities(ezs));
+
+	/* Only the constituents of the BGE are reported */
+	std::vector<double> dLdNa{};
+	for (size_t idx = 0; idx < ezs->size(); idx++) {
+		const LEMNG::RMobilitySensitivitiesMap *sens = ezs->at(idx).mobilitySensitivities;
+		double d;
+
+		failIfFalse(sens != nullptr);
+		failIfFalse(sens->size() == 2);
+		failIfFalse(sens->at(d, "Sodium") == ::ECHMET::RetCode::OK);
+
+		dLdNa.emplace_back(d);
+	}
+	lazy->destroy();
+
+	/* Analytic derivatives must agree with central differences */
+	const auto upper = eigenmobilities(czeSys, acBGEMap, acSampleMap, cSodium + h, corrections);
+	const auto lower = eigenmobilities(czeSys, acBGEMap, acSampleMap, cSodium - h, corrections);
+
+	failIfFalse(upper.size() == dLdNa.size());
+	for (size_t idx = 0; idx < dLdNa.size(); idx++) {
+		const double fd = (upper[idx] - lower[idx]) / (2.0 * h);
+
+		failIfFalse(std::abs(dLdNa[idx] - fd) <= 0.02 * std::abs(fd) + 1.0e-4);
+	}
+
+	acBGEMap->destroy();
+	acSampleMap->destroy();
+	LEMNG::releaseCZESystem(czeSys);
+	icVecSample->destroy();
+	icVecBGE->destroy();
+
+	SysComp::releaseInConstituent(chloride);
+	SysComp::releaseInConstituent(sodium);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,332 @@
+#include <cmath>
+#include <cstdlib>
+#include "barsarkagang_tests.h"
+
+
+using namespace ECHMET;
+using namespace ECHMET::Barsarkagang;
+
+
+/*
+ * Eigenzones at the same index must be the same zone in both results
+ */
+static
+void compareOrder(const LEMNG::Results &a, const LEMNG::Results &b)
+{
+	failIfFalse(a.eigenzones->size() == b.eigenzones->size());
+	for (size_t idx = 0; idx < a.eigenzones->size(); idx++) {
+		const auto &ezA = a.eigenzones->at(idx);
+		const auto &ezB = b.eigenzones->at(idx);
+
+		failIfFalse(ezA.ztype == ezB.ztype);
+		failIfMismatch(ezA.mobility, ezB.mobility);
+	}
+}
+
+static
+void compareResults(const LEMNG::Results &swept, const LEMNG::Results &fresh)
+{
+	checkBGE(swept, fresh.BGEProperties.pH, fresh.BGEProperties.conductivity, fresh.BGEProperties.ionicStrength, fresh.BGEProperties.bufferCapacity);
+
+	failIfFalse(swept.eigenzones->size() == fresh.eigenzones->size());
+	for (size_t idx = 0; idx < fresh.eigenzones->size(); idx++) {
+		const auto &ez = fresh.eigenzones->at(idx);
+
+		checkEigenzone(idx + 1, swept.eigenzones, ez.mobility, ez.uEMD, ez.a2t, ez.solutionProperties.pH, ez.solutionProperties.conductivity);
+	}
+}
+
+/*
+ * Index of the eigenzone that carries most of the given analyte
+ */
+static
+size_t zoneOf(const LEMNG::Results &r, const char *analyte)
+{
+	size_t best = 0;
+	double bestConc = -1.0;
+
+	for (size_t idx = 0; idx < r.eigenzones->size(); idx++) {
+		LEMNG::RConstituent rc;
+
+		failIfFalse(r.eigenzones->at(idx).solutionProperties.composition->at(rc, analyte) == ::ECHMET::RetCode::OK);
+		if (rc.concentration > bestConc) {
+			best = idx;
+			bestConc = rc.concentration;
+		}
+	}
+
+	return best;
+}
+
+/*
+ * Effective mobility of formic acid falls below the mobility of the strong anion
+ * as the excess of acetic acid lowers the pH. The eigenmobilities of the two analyte
+ * zones cross and each zone must keep its index through the crossing.
+ */
+static
+void sweepThroughCrossing()
+{
+	SysComp::InConstituent sodium{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Sodium"),
+		0,
+		1,
+		mkRealVec( { 13.7 } ),
+		mkRealVec( { 0.0, 51.9 } ),
+		noComplexes(),
+		0.0
+	};
+
+	SysComp::InConstituent aceticAcid{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Acetic acid"),
+		-1,
+		0,
+		mkRealVec( { 4.76 } ),
+		mkRealVec( { 42.4, 0.0 } ),
+		noComplexes(),
+		0.0
+	};
+
+	SysComp::InConstituent formicAcid{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Formic acid"),
+		-1,
+		0,
+		mkRealVec( { 3.75 } ),
+		mkRealVec( { 56.6, 0.0 } ),
+		noComplexes(),
+		0.0
+	};
+
+	SysComp::InConstituent strongAnion{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Strong anion"),
+		-1,
+		0,
+		mkRealVec( { -2.0 } ),
+		mkRealVec( { 40.0, 0.0 } ),
+		noComplexes(),
+		0.0
+	};
+
+	std::vector<double> acidPath{};
+	for (double c = 20.0; c <= 90.0; c += 5.0)
+		acidPath.emplace_back(c);
+
+	LEMNG::CZESystem *czeSys;
+	auto icVecBGE = mkInConstVec({ sodium, aceticAcid });
+	auto icVecSample = mkInConstVec({ sodium, aceticAcid, formicAcid, strongAnion });
+
+	failIfError(LEMNG::makeCZESystem(icVecBGE, icVecSample, czeSys));
+
+	LEMNG::InAnalyticalConcentrationsMap *acBGEMap = nullptr;
+	LEMNG::InAnalyticalConcentrationsMap *acSampleMap = nullptr;
+
+	failIfError(czeSys->makeAnalyticalConcentrationsMaps(acBGEMap, acSampleMap));
+
+	acBGEMap->item("Sodium") = 10.0;
+	acBGEMap->item("Acetic acid") = acidPath.front();
+	acSampleMap->item("Sodium") = 10.0;
+	acSampleMap->item("Acetic acid") = acidPath.front();
+	acSampleMap->item("Formic acid") = 0.1;
+	acSampleMap->item("Strong anion") = 0.1;
+
+	const auto corrections = defaultNonidealityCorrections();
+	const int32_t target = static_cast<int32_t>(LEMNG::SweepTarget::SWEEP_BOTH);
+	const int32_t parts = static_cast<int32_t>(LEMNG::EvaluationParts::EVAL_BGE) |
+			      static_cast<int32_t>(LEMNG::EvaluationParts::EVAL_EIGENMOBILITIES) |
+			      static_cast<int32_t>(LEMNG::EvaluationParts::EVAL_ZONE_COMPOSITIONS);
+	RealVec *path = mkRealVec(acidPath);
+	LEMNG::RSweepPointVec *points = nullptr;
+
+	failIfError(czeSys->sweep(acBGEMap, acSampleMap, "Acetic acid", target, path, corrections, parts, points));
+	failIfFalse(points->size() == acidPath.size());
+
+	const auto &first = points->at(0).results;
+	const auto &last = points->at(points->size() - 1).results;
+	failIfError(points->at(0).status);
+	failIfError(points->at(points->size() - 1).status);
+
+	const size_t formicZone = zoneOf(first, "Formic acid");
+	const size_t anionZone = zoneOf(first, "Strong anion");
+	failIfFalse(formicZone != anionZone);
+
+	/* Formic acid migrates faster at the beginning of the path and slower at its end */
+	failIfFalse(std::abs(first.eigenzones->at(formicZone).mobility) > std::abs(first.eigenzones->at(anionZone).mobility));
+	failIfFalse(std::abs(last.eigenzones->at(formicZone).mobility) < std::abs(last.eigenzones->at(anionZone).mobility));
+
+	for (size_t idx = 0; idx < points->size(); idx++) {
+		const auto &pt = points->at(idx);
+
+		failIfError(pt.status);
+		failIfFalse(pt.results.eigenzones->size() == first.eigenzones->size());
+		failIfFalse(zoneOf(pt.results, "Formic acid") == formicZone);
+		failIfFalse(zoneOf(pt.results, "Strong anion") == anionZone);
+	}
+
+	/* Single step across the crossing must be subdivided and end up with the same order as the fine path */
+	{
+		RealVec *coarsePath = mkRealVec({ acidPath.front(), acidPath.back() });
+		LEMNG::RSweepPointVec *coarsePoints = nullptr;
+
+		failIfError(czeSys->sweep(acBGEMap, acSampleMap, "Acetic acid", target, coarsePath, corrections, parts, coarsePoints));
+		failIfFalse(coarsePoints->size() == 2);
+
+		const auto &coarseLast = coarsePoints->at(1).results;
+		failIfError(coarsePoints->at(1).status);
+		failIfFalse(zoneOf(coarseLast, "Formic acid") == formicZone);
+		failIfFalse(zoneOf(coarseLast, "Strong anion") == anionZone);
+
+		failIfFalse(coarseLast.eigenzones->size() == last.eigenzones->size());
+		for (size_t idx = 0; idx < last.eigenzones->size(); idx++)
+			failIfMismatch(coarseLast.eigenzones->at(idx).mobility, last.eigenzones->at(idx).mobility);
+
+		LEMNG::releaseSweepPoints(coarsePoints);
+		coarsePath->destroy();
+	}
+
+	LEMNG::releaseSweepPoints(points);
+	path->destroy();
+
+	acBGEMap->destroy();
+	acSampleMap->destroy();
+	LEMNG::releaseCZESystem(czeSys);
+	icVecSample->destroy();
+	icVecBGE->destroy();
+
+	SysComp::releaseInConstituent(sodium);
+	SysComp::releaseInConstituent(aceticAcid);
+	SysComp::releaseInConstituent(formicAcid);
+	SysComp::releaseInConstituent(strongAnion);
+}
+
+int main(int , char ** )
+{
+	SysComp::InConstituent chloride{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Chloride"),
+		-1,
+		0,
+		mkRealVec( { -2.0 } ),
+		mkRealVec( { 79.1, 0.0 } ),
+		noComplexes(),
+		0.0
+	};
+
+	SysComp::InConstituent sodium{
+		SysComp::ConstituentType::NUCLEUS,
+		createFixedString("Sodium"),
+		0,
+		1,
+		mkRealVec( { 13.7 } ),
+		mkRealVec( { 0.0, 51.9 } ),
+		noComplexes(),
+		0.0
+	};
+
+	const std::vector<double> sodiumPath = { 10.0, 11.0, 12.5, 15.0 };
+
+	LEMNG::CZESystem *czeSys;
+	auto icVecBGE = mkInConstVec({ chloride, sodium });
+	auto icVecSample = mkInConstVec({ chloride, sodium });
+
+	failIfError(LEMNG::makeCZESystem(icVecBGE, icVecSample, czeSys));
+
+	LEMNG::InAnalyticalConcentrationsMap *acBGEMap = nullptr;
+	LEMNG::InAnalyticalConcentrationsMap *acSampleMap = nullptr;
+
+	failIfError(czeSys->makeAnalyticalConcentrationsMaps(acBGEMap, acSampleMap));
+
+	acBGEMap->item("Chloride") = 9.0;
+	acBGEMap->item("Sodium") = 10.0;
+	acSampleMap->item("Chloride") = 7.0;
+	acSampleMap->item("Sodium") = 10.0;
+
+	auto corrections = defaultNonidealityCorrections();
+	nonidealityCorrectionSet(corrections, NonidealityCorrectionsItems::CORR_DEBYE_HUCKEL);
+	nonidealityCorrectionSet(corrections, NonidealityCorrectionsItems::CORR_ONSAGER_FUOSS);
+
+	const int32_t target = static_cast<int32_t>(LEMNG::SweepTarget::SWEEP_BOTH);
+	const int32_t parts = static_cast<int32_t>(LEMNG::EvaluationParts::EVAL_ALL);
+	RealVec *path = mkRealVec(sodiumPath);
+	LEMNG::RSweepPointVec *points = nullptr;
+
+	/* Swept constituent must be present in the targeted composition */
+	if (czeSys->sweep(acBGEMap, acSampleMap, "Potassium", target, path, corrections, parts, points) != LEMNG::RetCode::E_INVALID_ARGUMENT) {
+		std::cerr << "Sweep of a constituent not present in the system was accepted" << std::endl;
+		std::exit(EXIT_FAILURE);
+	}
+
+	/* Leave the system with a different BGE, the sweep must not follow it */
+	{
+		LEMNG::Results r;
+
+		acBGEMap->item("Sodium") = 30.0;
+		acSampleMap->item("Sodium") = 30.0;
+		failIfError(czeSys->evaluate(acBGEMap, acSampleMap, corrections, r));
+		LEMNG::releaseResults(r);
+		acBGEMap->item("Sodium") = 10.0;
+		acSampleMap->item("Sodium") = 10.0;
+	}
+
+	failIfError(czeSys->sweep(acBGEMap, acSampleMap, "Sodium", target, path, corrections, parts, points));
+	failIfFalse(points->size() == sodiumPath.size());
+
+	/* Sweep by a system with no history must give exactly the same order */
+	{
+		LEMNG::CZESystem *czeSysFresh;
+		LEMNG::RSweepPointVec *pointsFresh = nullptr;
+
+		failIfError(LEMNG::makeCZESystem(icVecBGE, icVecSample, czeSysFresh));
+		failIfError(czeSysFresh->sweep(acBGEMap, acSampleMap, "Sodium", target, path, corrections, parts, pointsFresh));
+		failIfFalse(pointsFresh->size() == points->size());
+
+		for (size_t idx = 0; idx < points->size(); idx++)
+			compareOrder(points->at(idx).results, pointsFresh->at(idx).results);
+
+		LEMNG::releaseSweepPoints(pointsFresh);
+		LEMNG::releaseCZESystem(czeSysFresh);
+	}
+
+	/* Each point must match an independent evaluation of the same composition */
+	for (size_t idx = 0; idx < sodiumPath.size(); idx++) {
+		const auto &pt = points->at(idx);
+		const double c = sodiumPath[idx];
+
+		failIfError(pt.status);
+		failIfMismatch(pt.concentration, c);
+
+		auto fresh = calculate({ chloride, sodium }, { chloride, sodium },
+				       { { "Chloride", 9.0 }, { "Sodium", c } }, { { "Chloride", 7.0 }, { "Sodium", c } },
+				       true, true, false, false);
+
+		/* First point is ordered as the solver returns it, each other point follows the previous one.
+		 * Zones of NaCl do not swap along the path so all points match the order of a fresh evaluation. */
+		compareResults(pt.results, fresh);
+
+		/* Eigenzones must stay at the index they have in the first point */
+		const auto &first = points->at(0).results;
+		failIfFalse(pt.results.eigenzones->size() == first.eigenzones->size());
+		for (size_t ezIdx = 0; ezIdx < first.eigenzones->size(); ezIdx++)
+			failIfFalse(pt.results.eigenzones->at(ezIdx).ztype == first.eigenzones->at(ezIdx).ztype);
+
+		LEMNG::releaseResults(fresh);
+	}
+
+	LEMNG::releaseSweepPoints(points);
+	path->destroy();
+
+	acBGEMap->destroy();
+	acSampleMap->destroy();
+	LEMNG::releaseCZESystem(czeSys);
+	icVecSample->destroy();
+	icVecBGE->destroy();
+
+	SysComp::releaseInConstituent(chloride);
+	SysComp::releaseInConstituent(sodium);
+
+	sweepThroughCrossing();
+
+	return EXIT_SUCCESS;
+}
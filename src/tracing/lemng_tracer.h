@@ -16,21 +16,16 @@ enum class LEMNGTracing {
 	CALC_COMMON_CALC_SOLPROPS_CONDUCTIVITY,
 	CALC_MATRIX_M1_DIMS,
 	CALC_MATRIX_M2_DIMS,
-	CALC_MATRIX_M1_UICIF_BLOCK,
-	CALC_MATRIX_M1_UICIF_INTERMEDIATE,
-	CALC_MATRIX_M1_ROW_BLOCK,
+	CALC_MATRIX_UICIF_OUTPUT,
 	CALC_MATRIX_M1_OUTPUT,
 	CALC_MATRIX_M2_OUTPUT,
 	CALC_MATRIX_DM1_INPUT,
-	CALC_MATRIX_DM1_UICIDKDC,
-	CALC_MATRIX_DM1_UIDCIDCJ,
-	CALC_MATRIX_DM1_KRD,
-	CALC_MATRIX_DM1_ROW_BLOCK,
 	CALC_MATRIX_DM1_OUTPUT,
 	CALC_MATRIX_DM2_OUTPUT,
 	CALC_LIN_PROGRESS,
 	CALC_LIN_MFIN,
 	CALC_LIN_ZONE_TAINTED,
+	CALC_LIN_EIGENPAIR_ORDER,
 	CALC_NONLIN_PROGRESS,
 	CALC_NONLIN_NEIGHBOUR_FORMS_LOOKUP,
 	CALC_NONLIN_NERNST_EINST_INPUT,
@@ -41,9 +36,6 @@ enum class LEMNGTracing {
 	EFGPLOT_ZONE_ENVELOPE,
 	CALC_MATRIX_D1_DIMS,
 	CALC_MATRIX_D2_DIMS,
-	CALC_MATRIX_D1_UICIF_BLOCK,
-	CALC_MATRIX_D1_UICIF_INTERMEDIATE,
-	CALC_MATRIX_D1_ROW_BLOCK,
 	CALC_MATRIX_D1_OUTPUT,
 	CALC_MATRIX_D2_OUTPUT,
 	CALC_NONLIN_DIFFUSION_COEFFS,